@@ -10,6 +10,7 @@ TEMPLATE = subdirs
 
 
 SUBDIRS += src
+SUBDIRS += headless
 #SUBDIRS += tests
 TRAVIS = $$(TRAVIS)
 equals(TRAVIS, true){
@@ -21,6 +22,7 @@ equals(TRAVIS, true){
 
 #src.depends = comModules/mocklayer/appPlugin
 app.depends = src
+headless.depends = src
 #tests.depends = src
 
 message($$QMAKESPEC)
@@ -102,6 +102,8 @@ CONFIG(debug, debug|release) {
 
 
 DEFINES += SOL_CHECK_ARGUMENTS
+#writes Chrome trace-event JSON files per test run, see src/tracing.h
+#DEFINES += CTF_TRACING
 
 QMAKE_CXXFLAGS += -Werror -ftemplate-depth=1000
 #QMAKE_CXXFLAGS += -Werror
@@ -0,0 +1,72 @@
+#include "headless_runner.h"
+
+#include <QApplication>
+#include <QCommandLineParser>
+#include <QDir>
+#include <QFile>
+#include <QTextStream>
+#include <chrono>
+#include <iostream>
+#include <stdexcept>
+
+int main(int argc, char *argv[]) {
+    QCoreApplication::setOrganizationName("CPG");
+    QCoreApplication::setApplicationName("Crystal Test Framework App");
+    //the library still creates a few widgets (for example for pdf reports), they are never shown so nothing needs a display
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM")) {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+    QApplication a(argc, argv);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Runs test scripts without the graphical user interface.\n"
+                                     "Exit code: 0 if all scripts passed, 1 if a script failed or timed out, 2 on invalid arguments, "
+                                     "3 if scripts were skipped because the devices they require were not found.");
+    parser.addHelpOption();
+    parser.addPositionalArgument("scripts", "Lua scripts to run, one after another.", "[scripts...]");
+    const QCommandLineOption script_list_option{"script-list", "Text file with one script path per line.", "file"};
+    const QCommandLineOption log_directory_option{"log-dir", "Directory for the log file of each script.", "directory", "headless_logs"};
+    const QCommandLineOption report_option{"report", "Path of the JSON summary report. Defaults to report.json in the log directory.", "file"};
+    const QCommandLineOption timeout_option{"timeout", "Interrupts scripts running longer than this many seconds. 0 disables the timeout.", "seconds", "0"};
+    const QCommandLineOption repeat_option{"repeat", "Runs the script list this many times. Repeated runs reuse the loaded scripts.", "count", "1"};
+    parser.addOptions({script_list_option, log_directory_option, report_option, timeout_option, repeat_option});
+    parser.process(a);
+
+    QStringList scripts = parser.positionalArguments();
+    if (parser.isSet(script_list_option)) {
+        QFile script_list{parser.value(script_list_option)};
+        if (not script_list.open(QIODevice::ReadOnly | QIODevice::Text)) {
+            std::cerr << "Failed opening script list " << script_list.fileName().toStdString() << std::endl;
+            return 2;
+        }
+        QTextStream stream{&script_list};
+        while (not stream.atEnd()) {
+            const auto line = stream.readLine().trimmed();
+            if (not line.isEmpty() && not line.startsWith('#')) {
+                scripts << line;
+            }
+        }
+    }
+    bool timeout_valid = false;
+    const auto timeout_s = parser.value(timeout_option).toDouble(&timeout_valid);
+    bool repeat_valid = false;
+    const auto repeat_count = parser.value(repeat_option).toInt(&repeat_valid);
+    if (scripts.isEmpty() || not timeout_valid || timeout_s < 0 || not repeat_valid || repeat_count < 1) {
+        parser.showHelp(2);
+    }
+
+    const auto log_directory = parser.value(log_directory_option);
+    Headless_runner runner{log_directory, std::chrono::milliseconds{static_cast<long long>(timeout_s * 1000)}};
+    for (int i = 0; i < repeat_count; i++) {
+        for (const auto &script : scripts) {
+            runner.run_script(script);
+        }
+    }
+    try {
+        runner.save_report(parser.isSet(report_option) ? parser.value(report_option) : QDir{log_directory}.filePath("report.json"));
+    } catch (const std::runtime_error &e) {
+        std::cerr << e.what() << std::endl;
+        return 2;
+    }
+    return runner.get_exit_code();
+}
@@ -1,6 +1,8 @@
 #include "comportcommunicationdevice.h"
 #include "Windows/mainwindow.h"
+#include "performance_counters.h"
 #include "qt_util.h"
+#include "tracing.h"
 #include "util.h"
 
 #include <QApplication>
@@ -81,6 +83,7 @@ bool ComportCommunicationDevice::connect(const QMap<QString, QVariant> &portinfo
 }
 
 bool ComportCommunicationDevice::waitReceived(Duration timeout, int bytes, bool isPolling) {
+    TRACE_SCOPE("CommunicationDevice::waitReceived");
     auto now = std::chrono::high_resolution_clock::now();
     int received_bytes = 0;
     auto try_read = [this, &received_bytes] {
@@ -94,6 +97,7 @@ bool ComportCommunicationDevice::waitReceived(Duration timeout, int bytes, bool
         });
         if (not result.isEmpty()) {
             //qDebug() << "received" << result << "from" << port.portName();
+            Performance_counters::add(Performance_counters::Counter::bytes_received, result.size());
             emit received(result);
             received_bytes += result.size();
         }
@@ -113,6 +117,7 @@ bool ComportCommunicationDevice::waitReceived(Duration timeout, int bytes, bool
 }
 
 bool ComportCommunicationDevice::waitReceived(Duration timeout, std::string escape_characters, std::string leading_pattern_indicating_skip_line) {
+    TRACE_SCOPE("CommunicationDevice::waitReceived");
     QByteArray inbuffer{};
 
     auto try_read = [this](QByteArray &inbuffer, QSerialPort &port) {
@@ -140,6 +145,7 @@ bool ComportCommunicationDevice::waitReceived(Duration timeout, std::string esca
         QThread::currentThread()->usleep(100);
         try_read(inbuffer, port);
         if (inbuffer.indexOf(QString::fromStdString(escape_characters)) > -1) {
+            Performance_counters::add(Performance_counters::Counter::bytes_received, inbuffer.size());
             emit received(inbuffer);
             escape_found = true;
             QString in_str{inbuffer};
@@ -164,6 +170,8 @@ bool ComportCommunicationDevice::waitReceived(Duration timeout, std::string esca
 }
 
 void ComportCommunicationDevice::send(const QByteArray &data, const QByteArray &displayed_data) {
+    TRACE_SCOPE("CommunicationDevice::send");
+    Performance_counters::add(Performance_counters::Counter::bytes_sent, data.size());
     //qDebug() << "Sending" << data << "to" << port.portName();
     return Utility::promised_thread_call(this, [this, &data, &displayed_data] {
         auto size = port.write(data);
@@ -1,4 +1,6 @@
 #include "rpcserialport.h"
+#include "performance_counters.h"
+#include "tracing.h"
 #include <assert.h>
 
 
@@ -24,6 +26,7 @@ bool RPCSerialPort::connect(QString port_name, uint baud) {
 }
 
 bool RPCSerialPort::waitReceived(std::chrono::steady_clock::duration timeout, int bytes, bool isPolling) {
+    TRACE_SCOPE("CommunicationDevice::waitReceived");
     auto now = std::chrono::high_resolution_clock::now();
     int received_bytes = 0;
     auto try_read = [this, &received_bytes] {
@@ -32,6 +35,7 @@ bool RPCSerialPort::waitReceived(std::chrono::steady_clock::duration timeout, in
         QByteArray result = serial_port.readAll();
         //});
         if (result.isEmpty() == false) {
+            Performance_counters::add(Performance_counters::Counter::bytes_received, result.size());
             emit received(result);
             received_bytes += result.size();
         }
@@ -66,6 +70,8 @@ void RPCSerialPort::send(std::vector<unsigned char> data, std::vector<unsigned c
 }
 
 void RPCSerialPort::send(const QByteArray &data, const QByteArray &displayed_data) {
+    TRACE_SCOPE("CommunicationDevice::send");
+    Performance_counters::add(Performance_counters::Counter::bytes_sent, data.size());
 
     auto size = serial_port.write(data);
     if (size == -1) {
@@ -1,4 +1,6 @@
 #include "socketcommunicationdevice.h"
+#include "performance_counters.h"
+#include "tracing.h"
 #include "util.h"
 #include <QDebug>
 #include <cassert>
@@ -48,6 +50,8 @@ SocketCommunicationDevice::SocketCommunicationDevice()
 }
 
 void SocketCommunicationDevice::send(const QByteArray &data, const QByteArray &displayed_data) {
+    TRACE_SCOPE("CommunicationDevice::send");
+    Performance_counters::add(Performance_counters::Counter::bytes_sent, data.size());
     (void)displayed_data;
     socket->write(data);
     socket->waitForBytesWritten(1000);
@@ -66,12 +70,14 @@ bool SocketCommunicationDevice::awaitConnection(Duration timeout) {
 }
 
 bool SocketCommunicationDevice::waitReceived(Duration timeout, int bytes, bool isPolling) {
+    TRACE_SCOPE("CommunicationDevice::waitReceived");
     (void)bytes; //TODO: fix it so it waits for [bytes] until [timeout]
     (void)isPolling;
     return socket->waitForReadyRead(std::chrono::duration_cast<std::chrono::milliseconds>(timeout).count());
 }
 
 bool SocketCommunicationDevice::waitReceived(Duration timeout, std::string escape_characters, std::string leading_pattern_indicating_skip_line) {
+    TRACE_SCOPE("CommunicationDevice::waitReceived");
     (void)escape_characters;
     (void)leading_pattern_indicating_skip_line;
     return socket->waitForReadyRead(std::chrono::duration_cast<std::chrono::milliseconds>(timeout).count());
@@ -101,6 +107,7 @@ bool SocketCommunicationDevice::isConnected() {
 }
 
 void SocketCommunicationDevice::receiveData(QByteArray data) {
+    Performance_counters::add(Performance_counters::Counter::bytes_received, data.size());
     emit received(std::move(data));
 }
 
@@ -1,6 +1,8 @@
 #include "usbtmccommunicationdevice.h"
 #include "assert.h"
+#include "performance_counters.h"
 #include "qt_util.h"
+#include "tracing.h"
 #include "util.h"
 #include <QDebug>
 
@@ -29,6 +31,7 @@ bool USBTMCCommunicationDevice::connect(const QMap<QString, QVariant> &portinfo_
 }
 
 bool USBTMCCommunicationDevice::waitReceived(CommunicationDevice::Duration timeout, int bytes, bool isPolling) {
+    TRACE_SCOPE("CommunicationDevice::waitReceived");
     (void) timeout;
     (void) bytes;
     (void) isPolling;
@@ -38,12 +41,14 @@ bool USBTMCCommunicationDevice::waitReceived(CommunicationDevice::Duration timeo
 
 bool USBTMCCommunicationDevice::waitReceived(CommunicationDevice::Duration timeout, std::string escape_characters,
                                              std::string leading_pattern_indicating_skip_line) {
+    TRACE_SCOPE("CommunicationDevice::waitReceived");
     (void)escape_characters;
     (void)leading_pattern_indicating_skip_line;
     usbtmc.set_timeout(timeout);
 
     QByteArray response = usbtmc.read_answer();
     if (response.size()) {
+        Performance_counters::add(Performance_counters::Counter::bytes_received, response.size());
         emit received(response);
         return true;
     } else {
@@ -52,6 +57,8 @@ bool USBTMCCommunicationDevice::waitReceived(CommunicationDevice::Duration timeo
 }
 
 void USBTMCCommunicationDevice::send(const QByteArray &data, const QByteArray &displayed_data) {
+    TRACE_SCOPE("CommunicationDevice::send");
+    Performance_counters::add(Performance_counters::Counter::bytes_sent, data.size());
     usbtmc.send_buffer(data);
     emit decoded_sent(displayed_data.isEmpty() ? data : displayed_data);
 }
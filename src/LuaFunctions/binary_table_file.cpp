@@ -0,0 +1,304 @@
+#include "binary_table_file.h"
+
+#include <QFile>
+#include <QIODevice>
+#include <QObject>
+#include <QtEndian>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <sol.hpp>
+#include <stdexcept>
+#include <string>
+
+//file layout: header, then the root table
+//table: table_begin, optionally number_array with a count and that many doubles for the keys 1 to count, then key value pairs, then table_end
+//numbers are little endian doubles, strings are a little endian 64 bit length followed by the bytes
+static const char header[] = {'C', 'T', 'F', 'T', 'B', 'L', '\0', '\1'};
+constexpr std::size_t header_size = sizeof header;
+//nesting deeper than this is most likely a table that contains itself
+constexpr int max_depth = 200;
+
+namespace {
+    enum Tag : unsigned char { tag_false, tag_true, tag_number, tag_string, tag_table_begin, tag_table_end, tag_number_array };
+
+    class Writer {
+        public:
+        explicit Writer(QIODevice &device)
+            : device(device) {
+            buffer.reserve(buffer_size);
+        }
+
+        void write_tag(Tag tag) {
+            buffer.push_back(static_cast<char>(tag));
+            flush_if_full();
+        }
+        void write_number(double value) {
+            quint64 bits;
+            std::memcpy(&bits, &value, sizeof bits);
+            write_integer(bits);
+        }
+        void write_integer(quint64 value) {
+            const quint64 little_endian = qToLittleEndian(value);
+            buffer.append(reinterpret_cast<const char *>(&little_endian), sizeof little_endian);
+            flush_if_full();
+        }
+        void write_bytes(const char *data, std::size_t size) {
+            buffer.append(data, size);
+            flush_if_full();
+        }
+        void flush() {
+            if (buffer.empty()) {
+                return;
+            }
+            if (device.write(buffer.data(), static_cast<qint64>(buffer.size())) != static_cast<qint64>(buffer.size())) {
+                buffer.clear();
+                throw std::runtime_error(QObject::tr("Failed writing table file: %1").arg(device.errorString()).toStdString());
+            }
+            buffer.clear();
+        }
+
+        private:
+        void flush_if_full() {
+            if (buffer.size() >= buffer_size) {
+                flush();
+            }
+        }
+
+        static constexpr std::size_t buffer_size = 1 << 16;
+        QIODevice &device;
+        std::string buffer;
+    };
+
+    class Reader {
+        public:
+        Reader(const uchar *begin, const uchar *end)
+            : position(begin)
+            , end(end) {}
+
+        Tag read_tag() {
+            return static_cast<Tag>(*read_bytes(1));
+        }
+        Tag peek_tag() {
+            check_remaining(1);
+            return static_cast<Tag>(*position);
+        }
+        double read_number() {
+            const quint64 bits = read_integer();
+            double value;
+            std::memcpy(&value, &bits, sizeof value);
+            return value;
+        }
+        quint64 read_integer() {
+            quint64 value;
+            std::memcpy(&value, read_bytes(sizeof value), sizeof value);
+            return qFromLittleEndian(value);
+        }
+        const uchar *read_bytes(quint64 size) {
+            check_remaining(size);
+            const uchar *data = position;
+            position += size;
+            return data;
+        }
+
+        private:
+        void check_remaining(quint64 size) const {
+            if (size > static_cast<quint64>(end - position)) {
+                throw std::runtime_error("Table file is truncated");
+            }
+        }
+
+        const uchar *position;
+        const uchar *end;
+    };
+} // namespace
+
+static void write_table(Writer &writer, lua_State *L, int index, int depth);
+
+static void write_value(Writer &writer, lua_State *L, int index, int depth) {
+    switch (lua_type(L, index)) {
+        case LUA_TNUMBER:
+            writer.write_tag(tag_number);
+            writer.write_number(lua_tonumber(L, index));
+            break;
+        case LUA_TBOOLEAN:
+            writer.write_tag(lua_toboolean(L, index) ? tag_true : tag_false);
+            break;
+        case LUA_TSTRING: {
+            std::size_t length = 0;
+            const char *string = lua_tolstring(L, index, &length);
+            writer.write_tag(tag_string);
+            writer.write_integer(length);
+            writer.write_bytes(string, length);
+            break;
+        }
+        case LUA_TTABLE:
+            write_table(writer, L, index, depth + 1);
+            break;
+        default:
+            throw std::runtime_error(QObject::tr("Unsupported table field type %1").arg(lua_typename(L, lua_type(L, index))).toStdString());
+    }
+}
+
+static void write_table(Writer &writer, lua_State *L, int index, int depth) {
+    if (depth > max_depth) {
+        throw std::runtime_error("Table is nested too deep, it probably contains itself");
+    }
+    if (not lua_checkstack(L, 3)) {
+        throw std::runtime_error("Lua stack overflow while saving table");
+    }
+    index = lua_absindex(L, index);
+    const auto length = static_cast<lua_Integer>(lua_rawlen(L, index));
+    bool is_number_array = length > 0;
+    for (lua_Integer i = 1; i <= length && is_number_array; i++) {
+        is_number_array = lua_rawgeti(L, index, i) == LUA_TNUMBER;
+        lua_pop(L, 1);
+    }
+
+    writer.write_tag(tag_table_begin);
+    if (is_number_array) {
+        writer.write_tag(tag_number_array);
+        writer.write_integer(static_cast<quint64>(length));
+        for (lua_Integer i = 1; i <= length; i++) {
+            lua_rawgeti(L, index, i);
+            writer.write_number(lua_tonumber(L, -1));
+            lua_pop(L, 1);
+        }
+    }
+    lua_pushnil(L);
+    while (lua_next(L, index)) {
+        if (is_number_array && lua_isinteger(L, -2)) {
+            const auto key = lua_tointeger(L, -2);
+            if (key >= 1 && key <= length) {
+                lua_pop(L, 1);
+                continue;
+            }
+        }
+        write_value(writer, L, -2, depth);
+        write_value(writer, L, -1, depth);
+        lua_pop(L, 1);
+    }
+    writer.write_tag(tag_table_end);
+}
+
+void Binary_table_file::save(const sol::table &table, QIODevice &device) {
+    lua_State *L = table.lua_state();
+    Writer writer{device};
+    writer.write_bytes(header, header_size);
+    const int stack_top = lua_gettop(L);
+    table.push();
+    try {
+        write_table(writer, L, -1, 0);
+    } catch (...) {
+        lua_settop(L, stack_top);
+        throw;
+    }
+    lua_settop(L, stack_top);
+    writer.flush();
+}
+
+bool Binary_table_file::is_binary_table_file(const QString &file_name) {
+    QFile file{file_name};
+    if (not file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    return file.read(header_size) == QByteArray(header, header_size);
+}
+
+static void read_table(Reader &reader, lua_State *L, int depth);
+
+//pushes the value
+static void read_value(Reader &reader, lua_State *L, Tag tag, int depth) {
+    switch (tag) {
+        case tag_false:
+        case tag_true:
+            lua_pushboolean(L, tag == tag_true);
+            break;
+        case tag_number:
+            lua_pushnumber(L, reader.read_number());
+            break;
+        case tag_string: {
+            const auto length = reader.read_integer();
+            const auto data = reader.read_bytes(length);
+            lua_pushlstring(L, reinterpret_cast<const char *>(data), length);
+            break;
+        }
+        case tag_table_begin:
+            read_table(reader, L, depth + 1);
+            break;
+        default:
+            throw std::runtime_error(QObject::tr("Invalid value tag %1 in table file").arg(static_cast<int>(tag)).toStdString());
+    }
+}
+
+//the table_begin tag has already been read, pushes the table
+static void read_table(Reader &reader, lua_State *L, int depth) {
+    if (depth > max_depth) {
+        throw std::runtime_error("Table in table file is nested too deep");
+    }
+    if (not lua_checkstack(L, 4)) {
+        throw std::runtime_error("Lua stack overflow while loading table");
+    }
+    if (reader.peek_tag() == tag_number_array) {
+        reader.read_tag();
+        const auto length = reader.read_integer();
+        if (length > static_cast<quint64>(std::numeric_limits<int>::max())) {
+            throw std::runtime_error("Number array in table file is too long");
+        }
+        const auto data = reader.read_bytes(length * sizeof(double));
+        lua_createtable(L, static_cast<int>(length), 0);
+        for (quint64 i = 0; i < length; i++) {
+            quint64 bits;
+            std::memcpy(&bits, data + i * sizeof bits, sizeof bits);
+            bits = qFromLittleEndian(bits);
+            double value;
+            std::memcpy(&value, &bits, sizeof value);
+            lua_pushnumber(L, value);
+            lua_rawseti(L, -2, static_cast<lua_Integer>(i + 1));
+        }
+    } else {
+        lua_createtable(L, 0, 0);
+    }
+    for (Tag tag = reader.read_tag(); tag != tag_table_end; tag = reader.read_tag()) {
+        read_value(reader, L, tag, depth);
+        if (lua_type(L, -1) == LUA_TNUMBER && std::isnan(lua_tonumber(L, -1))) {
+            throw std::runtime_error("Invalid NaN key in table file");
+        }
+        read_value(reader, L, reader.read_tag(), depth);
+        lua_rawset(L, -3);
+    }
+}
+
+sol::table Binary_table_file::load(lua_State *lua, const QString &file_name) {
+    QFile file{file_name};
+    if (not file.open(QIODevice::ReadOnly)) {
+        throw std::runtime_error(QObject::tr("Can not open file for reading: \"%1\"").arg(file_name).toStdString());
+    }
+    //mapping avoids copying the file into memory first, reading it is the fallback for devices that cannot be mapped
+    QByteArray content;
+    qint64 size = file.size();
+    const uchar *data = size > 0 ? file.map(0, size) : nullptr;
+    if (data == nullptr) {
+        content = file.readAll();
+        data = reinterpret_cast<const uchar *>(content.constData());
+        size = content.size();
+    }
+    if (static_cast<std::size_t>(size) < header_size || std::memcmp(data, header, header_size) != 0) {
+        throw std::runtime_error(QObject::tr("\"%1\" is not a binary table file").arg(file_name).toStdString());
+    }
+
+    Reader reader{data + header_size, data + size};
+    const int stack_top = lua_gettop(lua);
+    try {
+        if (reader.read_tag() != tag_table_begin) {
+            throw std::runtime_error("Table file does not start with a table");
+        }
+        read_table(reader, lua, 0);
+    } catch (...) {
+        lua_settop(lua, stack_top);
+        throw;
+    }
+    sol::table table{lua, -1};
+    lua_pop(lua, 1);
+    return table;
+}
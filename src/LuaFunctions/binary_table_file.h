@@ -0,0 +1,21 @@
+#ifndef BINARY_TABLE_FILE_H
+#define BINARY_TABLE_FILE_H
+
+#include <QString>
+#include <sol_forward.hpp>
+
+class QIODevice;
+struct lua_State;
+
+//Binary file format of table_save_to_file for large tables.
+//The table is written while walking it through a small buffer instead of being converted to a JSON document first, so memory use does not grow
+//with the size of the table. The array part of a table consisting only of numbers is stored as one block of doubles, which loading copies directly
+//out of the memory mapped file.
+namespace Binary_table_file {
+    void save(const sol::table &table, QIODevice &device);
+    bool is_binary_table_file(const QString &file_name);
+    //throws std::runtime_error if the file cannot be read or is not a valid binary table file
+    sol::table load(lua_State *lua, const QString &file_name);
+} // namespace Binary_table_file
+
+#endif // BINARY_TABLE_FILE_H
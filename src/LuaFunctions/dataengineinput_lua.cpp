@@ -10,6 +10,13 @@
 #include <QSettings>
 #include <fstream>
 
+namespace {
+    struct Data_engine_field_handle {
+        Data_engine_field field;
+        sol::object data_engine; //the Data_engine_handle the field belongs to, referenced so it is not collected while the field is in use
+    };
+} // namespace
+
 void bind_dataengineinput(sol::state &lua, sol::table &ui_table, ScriptEngine &script_engine, UI_container *parent, const std::string &path) {
     ui_table.new_usertype<Lua_UI_Wrapper<DataEngineInput>>(
         "DataEngineInput", //
@@ -34,6 +41,35 @@ void bind_dataengineinput(sol::state &lua, sol::table &ui_table, ScriptEngine &s
         "set_explanation_text", thread_call_wrapper(&DataEngineInput::set_explanation_text));
     //bind data engine
     {
+        lua.new_usertype<Data_engine_field_handle>(
+            "Data_engine_field", //
+            sol::meta_function::construct, sol::no_constructor,
+            "set",
+            +[](Data_engine_field_handle &handle, const sol::object &value) {
+                abort_check();
+                switch (value.get_type()) {
+                    case sol::type::number:
+                        handle.field.set_actual_number(value.as<double>());
+                        break;
+                    case sol::type::boolean:
+                        handle.field.set_actual_bool(value.as<bool>());
+                        break;
+                    case sol::type::string:
+                        handle.field.set_actual_text(QString::fromStdString(value.as<std::string>()));
+                        break;
+                    default:
+                        throw std::runtime_error(
+                            QString("Data_engine_field: can not set \"%1\" with a value of that type").arg(handle.field.get_id()).toStdString());
+                }
+            },
+            "get",
+            +[](Data_engine_field_handle &handle, sol::this_state lua) {
+                abort_check();
+                if (handle.field.get_entry_type().t == EntryType::Number) {
+                    return sol::make_object(lua, handle.field.get_actual_number());
+                }
+                return sol::make_object(lua, handle.field.get_actual_value().toStdString());
+            });
         lua.new_usertype<Data_engine_handle>(
             "Data_engine", //
             sol::meta_function::construct,
@@ -185,6 +221,11 @@ void bind_dataengineinput(sol::state &lua, sol::table &ui_table, ScriptEngine &s
                 abort_check();
                 handle.data_engine->set_enable_auto_open_pdf(auto_open_on_pdf_creation);
             },
+            "set_performance_counters_in_report",
+            +[](Data_engine_handle &handle, bool enable) {
+                abort_check();
+                handle.data_engine->set_enable_performance_counters_in_report(enable);
+            },
             "value_in_range",
             +[](Data_engine_handle &handle, const std::string &field_id) {
                 abort_check();
@@ -234,6 +275,12 @@ void bind_dataengineinput(sol::state &lua, sol::table &ui_table, ScriptEngine &s
                 abort_check();
                 return handle.data_engine->is_exceptionally_approved(QString::fromStdString(field_id));
             },
+            "field",
+            +[](const sol::object &data_engine, const std::string &field_id) {
+                abort_check();
+                auto &handle = data_engine.as<Data_engine_handle &>();
+                return Data_engine_field_handle{handle.data_engine->get_field(QString::fromStdString(field_id)), data_engine};
+            },
             "set_actual_number",
             +[](Data_engine_handle &handle, const std::string &field_id, double value) {
                 abort_check();
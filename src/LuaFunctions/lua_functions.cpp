@@ -1,10 +1,13 @@
 /// \cond HIDDEN_SYMBOLS
 
 #include "lua_functions.h"
+#include "LuaFunctions/binary_table_file.h"
+#include "LuaFunctions/numarray.h"
 #include "Windows/mainwindow.h"
 #include "config.h"
 #include "console.h"
 #include "scriptengine.h"
+#include "scriptsetup_helper.h"
 //#include "util.h"
 #include "vc.h"
 #include <QApplication>
@@ -18,6 +21,7 @@
 #include <QJsonObject>
 #include <QPlainTextEdit>
 #include <QProcess>
+#include <QSaveFile>
 #include <QSettings>
 #include <QString>
 #include <QStringList>
@@ -44,29 +48,32 @@
 
 /// \cond HIDDEN_SYMBOLS
 
-std::vector<unsigned int> measure_noise_level_distribute_tresholds(const unsigned int length, const double min_val, const double max_val) {
-    std::vector<unsigned int> retval;
-    double range = max_val - min_val;
-    for (unsigned int i = 0; i < length; i++) {
-        unsigned int val = std::round(i * range / length) + min_val;
-        retval.push_back(val);
+//dialogs wait for somebody to answer them, but nobody is there to do so in a headless run
+static void throw_if_headless(const char *function_name) {
+    if (MainWindow::mw == nullptr) {
+        throw sol::error(std::string{function_name} + " requires user interaction and is not available in headless mode");
     }
-    return retval;
 }
 /// \endcond
 
-/*! \fn double measure_noise_level_czt(device rpc_device, int dacs_quantity, int max_possible_dac_value)
+/*! \fn double measure_noise_level_czt(device rpc_device, int dacs_quantity, int max_possible_dac_value, table options)
 \brief Calculates the noise level of an CZT-Detector system with thresholded radioactivity counters.
 \param rpc_device The communication instance of the CZT-Detector.
 \param dacs_quantity Number of thresholds which is also equal to the number of counter results.
 \param max_possible_dac_value Max digit of the DAC which controlls the thresholds. For 12 Bit this value equals 4095.
+\param options Optional table with the fields \c limit_cps (LimitCPS, default 5) and \c integration_times_s (the integration schedule, default {1, 10}).
 \return The lowest DAC threshold value which matches with the noise level definition.
 
 \details This function modifies DAC thresholds in order to find the
    lowest NoiseLevel which matches with:<br> \f$ \int_{NoiseLevel}^\infty
    spectrum(energy) < LimitCPS \f$ <br> where LimitCPS is defined by
-   configuration and is set by default to 5 CPS. <br> <br> Because this
-   functions iterates through the range of the spectrum to the find the noise
+   configuration and is set by default to 5 CPS. <br> <br>
+   The search splits the remaining range of thresholds by \c dacs_quantity
+   thresholds per integration, so it takes about log(max_possible_dac_value)/log(dacs_quantity + 1)
+   integrations with the first integration time of the schedule. Every further
+   integration time of the schedule confirms the result with a longer integration
+   and continues the search above it if the threshold turns out to be noisy.<br> <br>
+   Because this function searches through the range of the spectrum to the find the noise
    level it is necessary to have write access to the DAC thresholds and read
    access to the count values at the DAC thresholds. This is done by two call
    back functions which have to be implemented by the user into the lua script:
@@ -136,123 +143,130 @@ rpc_device:thresholds_set_custom_values(0, 0,0,0,0) --disable overwriting
 
 #ifdef DOXYGEN_ONLY
 // this block is just for ducumentation purpose
-double measure_noise_level_czt(device rpc_device, int dacs_quantity, int max_possible_dac_value);
+double measure_noise_level_czt(device rpc_device, int dacs_quantity, int max_possible_dac_value, table options);
 #endif
 
 /// \cond HIDDEN_SYMBOLS
-double measure_noise_level_czt(sol::state &lua, sol::table rpc_device, const unsigned int dacs_quantity, const unsigned int max_possible_dac_value) {
-    const unsigned int THRESHOLD_NOISE_LEVEL_CPS = 5;
-    const unsigned int INTEGRATION_TIME_SEC = 1;
-    const unsigned int INTEGRATION_TIME_HIGH_DEF_SEC = 10;
-    double noise_level_result = 100000000;
-    // TODO: test if dacs_quantity > 1
-
-    std::vector<unsigned int> dac_thresholds = measure_noise_level_distribute_tresholds(dacs_quantity, 0, max_possible_dac_value);
-
-    for (unsigned int i = 0; i < max_possible_dac_value; i++) {
-        sol::table dac_thresholds_lua_table = lua.create_table_with();
-        for (auto j : dac_thresholds) {
-            dac_thresholds_lua_table.add(j);
+unsigned int measure_noise_level_search(const Noise_level_measurement &measure, const unsigned int dacs_quantity, const unsigned int max_possible_dac_value,
+                                        const Noise_level_search_options &options) {
+    if (dacs_quantity == 0) {
+        throw std::runtime_error("measure_noise_level_czt: dacs_quantity must be greater than 0");
+    }
+    if (options.integration_times_s.empty()) {
+        throw std::runtime_error("measure_noise_level_czt: the integration schedule must contain at least one integration time");
+    }
+    //every integration measures dacs_quantity thresholds at once, so each one narrows the interval between the highest threshold known to be noisy
+    //and the lowest threshold known to be quiet to 1/(dacs_quantity + 1)
+    const long long unknown = static_cast<long long>(max_possible_dac_value) + 1;
+    long long noisy = -1;
+    long long quiet = unknown;
+    std::vector<unsigned int> thresholds(dacs_quantity);
+    auto first_quiet_index = [&](const std::vector<double> &counts, double integration_time_s) {
+        if (counts.size() < dacs_quantity) {
+            throw std::runtime_error(QObject::tr("measure_noise_level_czt: expected %1 counts from "
+                                                 "callback_measure_noise_level_set_dac_thresholds_and_get_raw_counts but got %2")
+                                         .arg(dacs_quantity)
+                                         .arg(counts.size())
+                                         .toStdString());
         }
-        sol::table counts = sol_call<sol::table>(lua, "callback_measure_noise_level_set_dac_thresholds_and_get_raw_counts", rpc_device,
-                                                 dac_thresholds_lua_table, INTEGRATION_TIME_SEC, 0);
-
-#if 0
-        sol::protected_function callback = lua["callback_measure_noise_level_set_dac_thresholds_and_get_raw_counts"];
-        sol::protected_function_result result = callback(rpc_device, dac_thresholds_lua_table, INTEGRATION_TIME_SEC, 0);
-
-        if (result.valid() == false) {
-            qDebug() << "result.get_type:" << (int)result.get_type();
-            qDebug() << "result.status:" << (int)result.status();
-            throw std::runtime_error(
-                "callback_measure_noise_level_set_dac_thresholds_and_get_raw_counts() returned an invalid value. (e.g nil) Most likely this function has "
-                "crashed.");
+        for (std::size_t i = 0; i < dacs_quantity; i++) {
+            if (counts[i] / integration_time_s <= options.limit_cps) {
+                return static_cast<long long>(i);
+            }
         }
-        sol::table counts = result;
-#endif
-        // print counts here
-        for (auto &j : counts) {
-            double val = std::abs(j.second.as<double>());
-            qDebug() << val;
+        return -1LL;
+    };
+
+    for (std::size_t stage = 0; stage < options.integration_times_s.size(); stage++) {
+        const double integration_time_s = options.integration_times_s[stage];
+        if (stage > 0) {
+            //longer integrations are more sensitive, confirm the previous result first and let the callback abort as soon as it is exceeded
+            std::fill(std::begin(thresholds), std::end(thresholds), static_cast<unsigned int>(quiet));
+            const auto counts = measure(thresholds, integration_time_s, integration_time_s * options.limit_cps);
+            if (first_quiet_index(counts, integration_time_s) == 0) {
+                continue;
+            }
+            noisy = quiet;
+            quiet = unknown;
         }
-        double window_start = 0;
-        double window_end = 0;
-
-        for (int j = counts.size() - 1; j >= 0; j--) {
-            if (counts[j + 1].get<double>() > THRESHOLD_NOISE_LEVEL_CPS) {
-                window_start = dac_thresholds[j];
-                window_end = window_start + (dac_thresholds[1] - dac_thresholds[0]);
-                qDebug() << "window_start" << window_start;
-                qDebug() << "window_end" << window_end;
-                break;
+        //the noise level is probably close above the previous result, so the thresholds start right above it and their distance keeps doubling
+        //across integrations until one is quiet
+        long long step = 1;
+        while (quiet - noisy > 1) {
+            const bool galloping = stage > 0 && quiet == unknown;
+            for (std::size_t i = 0; i < dacs_quantity; i++) {
+                long long threshold = 0;
+                if (galloping) {
+                    threshold = noisy + step * (1LL << std::min<std::size_t>(i, 20));
+                } else {
+                    threshold = noisy + (quiet - noisy) * static_cast<long long>(i + 1) / (dacs_quantity + 1);
+                }
+                thresholds[i] = static_cast<unsigned int>(std::max(noisy + 1, std::min(threshold, quiet - 1)));
+            }
+            const auto first_quiet = first_quiet_index(measure(thresholds, integration_time_s, 0), integration_time_s);
+            if (first_quiet == -1) {
+                noisy = thresholds.back();
+                if (galloping) {
+                    step = std::min(step << std::min<std::size_t>(dacs_quantity, 20), unknown);
+                }
+            } else {
+                quiet = thresholds[first_quiet];
+                if (first_quiet > 0) {
+                    noisy = thresholds[first_quiet - 1];
+                }
             }
         }
-        dac_thresholds = measure_noise_level_distribute_tresholds(dacs_quantity, window_start, window_end);
-
-        qDebug() << "new threshold:"; // << dac_thresholds;
-
-        if (dac_thresholds[0] == dac_thresholds[dacs_quantity - 1]) {
-            noise_level_result = dac_thresholds[0];
-            break;
+        if (quiet == unknown) {
+            throw std::runtime_error(QObject::tr("measure_noise_level_czt: the noise exceeds %1 cps even at the maximum DAC value %2")
+                                         .arg(options.limit_cps)
+                                         .arg(max_possible_dac_value)
+                                         .toStdString());
         }
     }
+    return static_cast<unsigned int>(quiet);
+}
 
-    // feinabstung und Plausibilitätsprüfung
-    for (unsigned int i = 0; i < max_possible_dac_value; i++) {
-        sol::table dac_thresholds_lua_table = lua.create_table_with();
-        for (unsigned int i = 0; i < dacs_quantity; i++) {
-            dac_thresholds_lua_table.add(uint(round(noise_level_result)));
-        }
-        // print("DAC:",rauschkante)
-        sol::table counts =
-            sol_call<sol::table>(lua, "callback_measure_noise_level_set_dac_thresholds_and_get_raw_counts", rpc_device, dac_thresholds_lua_table,
-                                 INTEGRATION_TIME_HIGH_DEF_SEC, INTEGRATION_TIME_HIGH_DEF_SEC * THRESHOLD_NOISE_LEVEL_CPS);
-#if 0
-         sol::protected_function callback = lua["callback_measure_noise_level_set_dac_thresholds_and_get_raw_counts"];
-        sol::protected_function_result result =
-            callback(rpc_device, dac_thresholds_lua_table, INTEGRATION_TIME_HIGH_DEF_SEC, INTEGRATION_TIME_HIGH_DEF_SEC * THRESHOLD_NOISE_LEVEL_CPS);
-
-
-        if (result.valid() == false) {
-            qDebug() << "result.get_type:" << (int)result.get_type();
-            qDebug() << "result.status:" << (int)result.status();
-            throw std::runtime_error(
-                "callback_measure_noise_level_set_dac_thresholds_and_get_raw_counts() returned an invalid value. (e.g nil) Most likely this function has "
-                "crashed.");
+double measure_noise_level_czt(sol::state &lua, sol::table rpc_device, const unsigned int dacs_quantity, const unsigned int max_possible_dac_value,
+                               const sol::optional<sol::table> &options_table) {
+    Noise_level_search_options options;
+    if (options_table) {
+        options.limit_cps = options_table.value().get_or("limit_cps", options.limit_cps);
+        if (sol::optional<sol::table> integration_times_s = options_table.value()["integration_times_s"]) {
+            options.integration_times_s.clear();
+            for (std::size_t i = 1; i <= integration_times_s.value().size(); i++) {
+                options.integration_times_s.push_back(integration_times_s.value()[i].get<double>());
+            }
         }
+    }
 
-        sol::table counts = result;
-#endif
-        bool found = true;
-        for (auto &j : counts) {
-            double val = j.second.as<double>() / INTEGRATION_TIME_HIGH_DEF_SEC;
-            if (val > THRESHOLD_NOISE_LEVEL_CPS) {
-                noise_level_result = noise_level_result + 1;
-                found = false;
-                break;
-            }
+    //the same tables are handed to the callback for every integration
+    sol::table thresholds_table = lua.create_table(static_cast<int>(dacs_quantity), 0);
+    std::vector<double> counts;
+    auto measure = [&](const std::vector<unsigned int> &thresholds, double integration_time_s, double count_limit_for_accumulation_abort) {
+        abort_check();
+        for (std::size_t i = 0; i < thresholds.size(); i++) {
+            thresholds_table.raw_set(i + 1, thresholds[i]);
         }
-        if (found) {
-            // print("rauschkante gefunden:", noise_level_result);
-            break;
+        const sol::table counts_table = sol_call<sol::table>(lua, "callback_measure_noise_level_set_dac_thresholds_and_get_raw_counts", rpc_device,
+                                                             thresholds_table, integration_time_s, count_limit_for_accumulation_abort);
+        counts.resize(counts_table.size());
+        for (std::size_t i = 0; i < counts.size(); i++) {
+            counts[i] = std::abs(counts_table.raw_get<double>(i + 1));
         }
-    }
-    sol_call(lua, "callback_measure_noise_level_restore_dac_thresholds_to_normal_mode", rpc_device);
+        return counts;
+    };
 
-#if 0
-    sol::protected_function callback = lua["callback_measure_noise_level_restore_dac_thresholds_to_normal_mode"];
-    sol::protected_function_result result = callback(rpc_device);
-    if (result.valid() == false) {
-        qDebug() << "result.get_type:" << (int)result.get_type();
-        qDebug() << "result.status:" << (int)result.status();
-        throw std::runtime_error(
-            "callback_measure_noise_level_restore_dac_thresholds_to_normal_mode() returned an invalid value.Most likely this function has "
-            "crashed.");
+    unsigned int noise_level = 0;
+    try {
+        noise_level = measure_noise_level_search(measure, dacs_quantity, max_possible_dac_value, options);
+    } catch (...) {
+        //leave the custom threshold mode even if the measurement failed, but report the original error
+        sol::protected_function restore = lua["callback_measure_noise_level_restore_dac_thresholds_to_normal_mode"];
+        restore(rpc_device);
+        throw;
     }
-#endif
-
-    // lua["callback_measure_noise_level_restore_dac_thresholds_to_normal_mode"](rpc_device);
-    return noise_level_result;
+    sol_call(lua, "callback_measure_noise_level_restore_dac_thresholds_to_normal_mode", rpc_device);
+    return noise_level;
 }
 /// \endcond
 
@@ -283,6 +297,7 @@ string show_file_save_dialog(string title, string path, string_table filter);
 #if 1
 /// \cond HIDDEN_SYMBOLS
 std::string show_file_save_dialog(const std::string &title, const std::string &path, sol::table filters) {
+    throw_if_headless("show_file_save_dialog");
     QStringList sl;
     for (auto &i : filters) {
         sl.append(QString::fromStdString(i.second.as<std::string>()));
@@ -325,6 +340,7 @@ string show_file_open_dialog(string title, string path, string_table filter);
 #if 1
 /// \cond HIDDEN_SYMBOLS
 std::string show_file_open_dialog(const std::string &title, const std::string &path, sol::table filters) {
+    throw_if_headless("show_file_open_dialog");
     QStringList sl;
     for (auto &i : filters) {
         sl.append(QString::fromStdString(i.second.as<std::string>()));
@@ -386,6 +402,7 @@ string show_question(string title, string message, string_table button_table);
 #if 1
 /// \cond HIDDEN_SYMBOLS
 std::string show_question(const QString &path, const sol::optional<std::string> &title, const sol::optional<std::string> &message, sol::table button_table) {
+    throw_if_headless("show_question");
     QMessageBox::StandardButtons buttons{};
 #if 1
     for (auto &i : button_table) {
@@ -505,6 +522,10 @@ show_info(string title, string message);
 
 /// \cond HIDDEN_SYMBOLS
 void show_info(const QString &path, const sol::optional<std::string> &title, const sol::optional<std::string> &message) {
+    if (MainWindow::mw == nullptr) {
+        Console_handle::note() << QString::fromStdString(title.value_or("nil")) + " from " + path + ": " + QString::fromStdString(message.value_or("nil"));
+        return;
+    }
     Utility::promised_thread_call(MainWindow::mw, [&path, &title, &message]() {
         QMessageBox::information(MainWindow::mw, QString::fromStdString(title.value_or("nil")) + " from " + path,
                                  QString::fromStdString(message.value_or("nil")));
@@ -537,6 +558,10 @@ show_warning(string title, string message);
 
 /// \cond HIDDEN_SYMBOLS
 void show_warning(const QString &path, const sol::optional<std::string> &title, const sol::optional<std::string> &message) {
+    if (MainWindow::mw == nullptr) {
+        Console_handle::warning() << QString::fromStdString(title.value_or("nil")) + " from " + path + ": " + QString::fromStdString(message.value_or("nil"));
+        return;
+    }
     Utility::promised_thread_call(MainWindow::mw, [&path, &title, &message]() {
         QMessageBox::warning(MainWindow::mw, QString::fromStdString(title.value_or("nil")) + " from " + path, QString::fromStdString(message.value_or("nil")));
     });
@@ -623,6 +648,63 @@ void sleep_ms(ScriptEngine *scriptengine, const unsigned int duration_ms, const
 }
 /// \endcond
 
+/*! \fn spawn(function f);
+\brief Runs \c f concurrently to the calling code.
+\param f          A function without parameters.
+
+\details Only available while the run function of a script executes and cooperative script execution is enabled in the settings.
+All spawned functions and the run function take turns on the same thread. A function gives up its turn when it calls sleep_ms,
+calls an RPC device function or calls coroutine.yield(). Inside coroutines the script creates itself sleep_ms and RPC device functions
+block instead and coroutine.yield() returns to the script's own resume. The script finishes after the run function and all spawned
+functions returned.
+An error in any of them stops the script.
+\par example:
+\code{.lua}
+    function run(devices)
+        for slot = 1, 4 do
+            spawn(function()
+                for i = 1, 10 do
+                    print("slot ", slot, " step ", i)
+                    sleep_ms(100) -- the other slots continue while this one sleeps
+                end
+            end)
+        end
+    end
+\endcode
+*/
+
+#ifdef DOXYGEN_ONLY
+// this block is just for ducumentation purpose
+spawn(function f);
+#endif
+
+/// \cond HIDDEN_SYMBOLS
+//sleep_ms for cooperative script execution. Called from a task of the scheduler it yields the duration to the scheduler which resumes the
+//task after the duration while the thread runs other scripts. Anywhere else, including coroutines of the script, it blocks like sleep_ms.
+//The ScriptEngine is passed as light userdata upvalue.
+int cooperative_sleep_ms(lua_State *L) {
+    const auto duration_ms = luaL_checkinteger(L, 1);
+    auto script_engine = static_cast<ScriptEngine *>(lua_touserdata(L, lua_upvalueindex(1)));
+    if (script_engine->may_yield_to_scheduler(L)) {
+        lua_settop(L, 1);
+        lua_pushlightuserdata(L, ScriptEngine::get_cooperative_yield_tag());
+        lua_insert(L, 1);
+        return lua_yield(L, 2);
+    }
+    bool failed = false;
+    try {
+        sleep_ms(script_engine, static_cast<unsigned int>(duration_ms), 0);
+    } catch (const std::exception &e) {
+        lua_pushstring(L, e.what());
+        failed = true;
+    }
+    if (failed) { //raise the error outside of the catch block so no C++ object is skipped by the longjmp
+        return lua_error(L);
+    }
+    return 0;
+}
+/// \endcond
+
 /*! \fn double current_date_time_ms();
 \brief Returns the current Milliseconds since epoch (1970-01-01T00:00:00.000).
 
@@ -644,6 +726,45 @@ double current_date_time_ms() {
 }
 /// \endcond
 
+/*! \fn table get_performance_counters();
+\brief Returns the performance counters of the currently running test.
+\return A table with the counters \c bytes_sent, \c bytes_received, \c rpc_transactions, \c rpc_timeouts, \c rpc_retries,
+\c scpi_transactions, \c scpi_timeouts and \c data_engine_values_set and the duration histograms \c await_timeout_ms,
+\c gui_call_ms, \c rpc_transaction_ms, \c scpi_transaction_ms and \c pdf_generation_ms. Each histogram is a table with the fields
+\c count, \c total, \c mean, \c p50, \c p90 and \c p99 in milliseconds.
+
+\details Only the current test is counted, including the RPC calls it runs in other threads. Tests running in parallel are not included.
+\par example:
+\code{.lua}
+    local counters = get_performance_counters()
+    print("RPC timeouts: ", counters.rpc_timeouts)
+    print("time spent sleeping: ", counters.await_timeout_ms.total, "ms")
+\endcode
+*/
+
+#ifdef DOXYGEN_ONLY
+// this block is just for ducumentation purpose
+table get_performance_counters();
+#endif
+
+/// \cond HIDDEN_SYMBOLS
+sol::table get_performance_counters(sol::state &lua, ScriptEngine *scriptengine) {
+    const auto snapshot = scriptengine->get_run_performance_counters();
+    sol::table result = lua.create_table_with();
+    for (std::size_t i = 0; i < snapshot.counters.size(); i++) {
+        result[Performance_counters::get_name(static_cast<Performance_counters::Counter>(i))] = static_cast<double>(snapshot.counters[i]);
+    }
+    for (std::size_t i = 0; i < snapshot.histograms.size(); i++) {
+        const auto &histogram = snapshot.histograms[i];
+        result[Performance_counters::get_name(static_cast<Performance_counters::Histogram>(i))] = lua.create_table_with(
+            "count", static_cast<double>(histogram.count), "total", histogram.total_us / 1000., "mean",
+            histogram.count ? histogram.total_us / 1000. / histogram.count : 0., "p50", histogram.percentile_ms(50), "p90", histogram.percentile_ms(90),
+            "p99", histogram.percentile_ms(99));
+    }
+    return result;
+}
+/// \endcond
+
 /*! \fn double round(double value, int precision);
 \brief Returns the rounded value of \c value
 \param value                 Input value of int or double values.
@@ -862,11 +983,14 @@ static void table_to_json_object(QPlainTextEdit *console, QJsonArray &jarray, co
 }
 /// \endcond
 
-/*! \fn table_save_to_file(string file_name, table input_table, bool over_write_file);
+/*! \fn table_save_to_file(string file_name, table input_table, bool over_write_file, string format);
 \brief Writes an arbitrary lua table to file.
 \param file_name The filename to write the file to.
 \param input_table The table to be saved.
 \param over_write_file whether overwrite a potentially existing file(true) or not(false)
+\param format Optional. \c "json" (default) for the \glos{json} format described below or \c "binary" for a compact binary format.
+The binary format is written while walking the table and stores arrays of numbers as one block, so it is much faster and needs much less
+memory for large tables such as measurement histories. table_load_from_file() detects the format by itself.
 
 \sa propose_unique_filename_by_datetime(text dir_path, text prefix, text suffix)
 \sa table_load_from_file()
@@ -916,13 +1040,20 @@ This example is the result of the following code snippet:
 
 #ifdef DOXYGEN_ONLY
 // this block is just for ducumentation purpose
-table_save_to_file(string file_name, table input_table, bool over_write_file);
+table_save_to_file(string file_name, table input_table, bool over_write_file, string format);
 #endif
 /// \cond HIDDEN_SYMBOLS
 
-void table_save_to_file(QPlainTextEdit *console, const std::string file_name, sol::table input_table, bool over_write_file) {
+void table_save_to_file(QPlainTextEdit *console, const std::string file_name, sol::table input_table, bool over_write_file,
+                        const std::string &format) {
     QString fn = QString::fromStdString(file_name);
 
+    if (format != "json" && format != "binary") {
+        const auto &message = QObject::tr("Unknown format for saving table: \"%1\". Must be \"json\" or \"binary\".").arg(QString::fromStdString(format));
+        Utility::thread_call(MainWindow::mw, [console = console, message = std::move(message)] { Console_handle::error(console) << message; });
+        throw sol::error("unknown format");
+    }
+
     if (fn == "") {
         const auto &message = QObject::tr("Failed open file for saving table: %1").arg(fn);
         Utility::thread_call(MainWindow::mw, [console = console, message = std::move(message)] { Console_handle::error(console) << message; });
@@ -939,7 +1070,8 @@ void table_save_to_file(QPlainTextEdit *console, const std::string file_name, so
         throw sol::error("File already exists");
         return;
     }
-    QFile saveFile(fn);
+    //the table is written to a temporary file which only replaces fn on commit, so a failed save does not leave a truncated file behind
+    QSaveFile saveFile(fn);
 
     if (!saveFile.open(QIODevice::WriteOnly)) {
         const auto &message = QObject::tr("Failed open file for saving table: %1").arg(fn);
@@ -948,13 +1080,28 @@ void table_save_to_file(QPlainTextEdit *console, const std::string file_name, so
         return;
     }
 
-    QJsonArray jarray;
+    if (format == "binary") {
+        try {
+            Binary_table_file::save(input_table, saveFile);
+        } catch (const std::runtime_error &e) {
+            const auto &message = QObject::tr("Failed to save table to file: %1").arg(e.what());
+            Utility::thread_call(MainWindow::mw, [console = console, message = std::move(message)] { Console_handle::error(console) << message; });
+            throw sol::error(e.what());
+        }
+    } else {
+        QJsonArray jarray;
 
-    table_to_json_object(console, jarray, input_table);
-    QJsonObject obj;
-    obj["table"] = jarray;
-    QJsonDocument saveDoc(obj);
-    saveFile.write(saveDoc.toJson());
+        table_to_json_object(console, jarray, input_table);
+        QJsonObject obj;
+        obj["table"] = jarray;
+        QJsonDocument saveDoc(obj);
+        saveFile.write(saveDoc.toJson());
+    }
+    if (!saveFile.commit()) {
+        const auto &message = QObject::tr("Failed writing file for saving table: %1").arg(fn);
+        Utility::thread_call(MainWindow::mw, [console = console, message = std::move(message)] { Console_handle::error(console) << message; });
+        throw sol::error("could not write file");
+    }
 }
 
 static sol::object sol_object_from_type_string(QPlainTextEdit *console, sol::state &lua, const QString &value_type, const QString &v) {
@@ -1037,7 +1184,7 @@ static sol::table jsonarray_to_table(QPlainTextEdit *console, sol::state &lua, c
 
 /*! \fn table table_load_from_file(string file_name)
 \brief Loads a lua table from file which where written using
-table_save_to_file() \param file_name            The filename to load the table
+table_save_to_file() in the \glos{json} or the binary format. \param file_name            The filename to load the table
 from. \returns the lua table from file.
 
 \sa table_save_to_file()
@@ -1063,6 +1210,16 @@ table table_load_from_file(string file_name);
 sol::table table_load_from_file(QPlainTextEdit *console, sol::state &lua, const std::string file_name) {
     QString fn = QString::fromStdString(file_name);
 
+    if (Binary_table_file::is_binary_table_file(fn)) {
+        try {
+            return Binary_table_file::load(lua.lua_state(), fn);
+        } catch (const std::runtime_error &e) {
+            const auto &message = QObject::tr("Failed to load table from file \"%1\": %2").arg(fn, e.what());
+            Utility::thread_call(MainWindow::mw, [console = console, message = std::move(message)] { Console_handle::error(console) << message; });
+            throw sol::error(e.what());
+        }
+    }
+
     QFile loadFile(fn);
 
     if (!loadFile.open(QIODevice::ReadOnly)) {
@@ -1334,6 +1491,103 @@ double table_standard_deviation(sol::table input_values) {
 
 /// \endcond
 
+/*! \fn table table_stats(number_table input_values);
+\brief Returns count, sum, mean, variance, standard deviation, minimum and maximum of \c input_values together with the positions of the minimum and maximum.
+\param input_values                 Input table of int or double values or a NumArray.
+
+\return A table with the fields \c count, \c sum, \c mean, \c variance, \c standard_deviation, \c min, \c max, \c argmin and \c argmax.
+\c variance is calculated like in \c table_variance. \c argmin and \c argmax are the indices of the first minimum and maximum.
+If \c input_values is empty only \c count, \c sum, \c mean, \c variance and \c standard_deviation are set, all to 0.
+
+\details All values are calculated in a single pass over \c input_values with Welford's algorithm, which is faster than calling
+\c table_mean, \c table_variance, \c table_min and \c table_max one after another and numerically more stable than summing up squares.
+\par example:
+\code{.lua}
+    local input_values = {-20, -40, 2, 30}
+    local stats = table_stats(input_values)
+    print(stats.mean) -- -7.0
+    print(stats.variance) -- 677
+    print(stats.min, stats.argmin) -- -40 2
+    print(stats.max, stats.argmax) -- 30 4
+\endcode
+*/
+
+#ifdef DOXYGEN_ONLY
+// this block is just for ducumentation purpose
+table table_stats(number_table input_values);
+#endif
+/// \cond HIDDEN_SYMBOLS
+
+namespace {
+    struct Running_statistics {
+        std::size_t count = 0;
+        double sum = 0;
+        double mean = 0;
+        double m2 = 0; //sum of squared differences from the current mean
+        double min = 0;
+        double max = 0;
+        std::size_t argmin = 0;
+        std::size_t argmax = 0;
+
+        void add(double value) {
+            count++;
+            sum += value;
+            const double delta = value - mean;
+            mean += delta / count;
+            m2 += delta * (value - mean);
+            if (count == 1 || value < min) {
+                min = value;
+                argmin = count;
+            }
+            if (count == 1 || value > max) {
+                max = value;
+                argmax = count;
+            }
+        }
+    };
+} // namespace
+
+sol::table table_stats(sol::state &lua, const sol::object &input_values) {
+    Running_statistics statistics;
+    if (input_values.is<NumArray>()) {
+        for (const auto value : input_values.as<NumArray &>().get_values()) {
+            statistics.add(value);
+        }
+    } else if (input_values.get_type() == sol::type::table) {
+        lua_State *L = input_values.lua_state();
+        input_values.push();
+        const auto size = lua_rawlen(L, -1);
+        for (std::size_t i = 1; i <= size; i++) {
+            lua_rawgeti(L, -1, static_cast<lua_Integer>(i));
+            int is_number = 0;
+            const double value = lua_tonumberx(L, -1, &is_number);
+            lua_pop(L, 1);
+            if (not is_number) {
+                lua_pop(L, 1);
+                throw std::runtime_error(QObject::tr("table_stats: value at index %1 is not a number").arg(i).toStdString());
+            }
+            statistics.add(value);
+        }
+        lua_pop(L, 1);
+    } else {
+        throw std::runtime_error(
+            QObject::tr("table_stats: expected a table or a NumArray but got %1").arg(QString::fromStdString(sol::type_name(lua, input_values.get_type()))).toStdString());
+    }
+
+    const double variance = statistics.count ? statistics.m2 / statistics.count : 0;
+    sol::table retval = lua.create_table_with("count", statistics.count, "sum", statistics.sum, "mean", statistics.mean, "variance", variance,
+                                              "standard_deviation", std::sqrt(variance));
+    if (statistics.count) {
+        retval["min"] = statistics.min;
+        retval["max"] = statistics.max;
+        retval["argmin"] = statistics.argmin;
+        retval["argmax"] = statistics.argmax;
+    }
+    return retval;
+}
+
+/// \endcond
+
 /*! \fn number_table table_set_constant(number_table input_values, number constant);
 \brief Returns a table with the length of \c input_values initialized with \c constant.
 \param input_values Input table of \c int or \c double values.
@@ -5,6 +5,7 @@
 #include "sol.hpp"
 
 #include <QString>
+#include <functional>
 #include <vector>
 
 class QPlainTextEdit;
@@ -17,8 +18,17 @@ QString append_separator_to_path(QString path);
 QStringList get_search_path_entries(QString search_path);
 QString search_in_search_path(const QString &script_path, const QString &file_to_be_searched);
 QString get_search_paths(const QString &script_path);
-std::vector<unsigned int> measure_noise_level_distribute_tresholds(const unsigned int length, const double min_val, const double max_val);
-double measure_noise_level_czt(sol::state &lua, sol::table rpc_device, const unsigned int dacs_quantity, const unsigned int max_possible_dac_value);
+struct Noise_level_search_options {
+    double limit_cps = 5;
+    std::vector<double> integration_times_s{1, 10};
+};
+//sets the thresholds, integrates for integration_time_s and returns the counts per threshold
+using Noise_level_measurement =
+    std::function<std::vector<double>(const std::vector<unsigned int> &thresholds, double integration_time_s, double count_limit_for_accumulation_abort)>;
+unsigned int measure_noise_level_search(const Noise_level_measurement &measure, const unsigned int dacs_quantity, const unsigned int max_possible_dac_value,
+                                        const Noise_level_search_options &options);
+double measure_noise_level_czt(sol::state &lua, sol::table rpc_device, const unsigned int dacs_quantity, const unsigned int max_possible_dac_value,
+                               const sol::optional<sol::table> &options_table);
 void print(QPlainTextEdit *console, const sol::variadic_args &args);
 std::string show_file_save_dialog(const std::string &title, const std::string &path, sol::table filters);
 std::string show_file_open_dialog(const std::string &title, const std::string &path, sol::table filters);
@@ -26,11 +36,14 @@ std::string show_question(const QString &path, const sol::optional<std::string>
 void show_info(const QString &path, const sol::optional<std::string> &title, const sol::optional<std::string> &message);
 void show_warning(const QString &path, const sol::optional<std::string> &title, const sol::optional<std::string> &message);
 void sleep_ms(ScriptEngine *scriptengine, const unsigned int duration_ms, const unsigned int starttime_ms);
+int cooperative_sleep_ms(lua_State *L);
 void pc_speaker_beep();
 QString run_external_tool(const QString &script_path, const QString &execute_directory, const QString &executable, const sol::table &arguments, uint timeout);
 double current_date_time_ms(void);
+sol::table get_performance_counters(sol::state &lua, ScriptEngine *scriptengine);
 double round_double(const double value, const unsigned int precision);
-void table_save_to_file(QPlainTextEdit *console, const std::string file_name, sol::table input_table, bool over_write_file);
+void table_save_to_file(QPlainTextEdit *console, const std::string file_name, sol::table input_table, bool over_write_file,
+                        const std::string &format);
 sol::table table_load_from_file(QPlainTextEdit *console, sol::state &lua, const std::string file_name);
 uint16_t table_crc16(QPlainTextEdit *console, sol::table input_values);
 uint table_find_string(sol::table input_table, std::string search_text);
@@ -40,6 +53,7 @@ double table_sum(sol::table input_values);
 double table_mean(sol::table input_values);
 double table_variance(sol::table input_values);
 double table_standard_deviation(sol::table input_values);
+sol::table table_stats(sol::state &lua, const sol::object &input_values);
 sol::table table_set_constant(sol::state &lua, sol::table input_values, double constant);
 sol::table table_create_constant(sol::state &lua, const unsigned int size, double constant);
 sol::table table_add_table(sol::state &lua, sol::table input_values_a, sol::table input_values_b);
@@ -1,6 +1,7 @@
 #include "lua_functions_lua.h"
 #include "Windows/devicematcher.h"
 #include "config.h"
+#include "lua_bytecode_cache.h"
 #include "lua_functions.h"
 #include "scriptsetup_helper.h"
 #include "ui_container.h"
@@ -45,8 +46,22 @@ void bind_lua_functions(sol::state &lua, sol::table &ui_table, const std::string
             abort_check();
             sleep_ms(&script_engine, duration_ms, 0);
         };
+        if (script_engine.cooperative) {
+            //a raw C closure because sol cannot yield from inside a bound function
+            lua_pushlightuserdata(lua.lua_state(), &script_engine);
+            lua_pushcclosure(lua.lua_state(), &cooperative_sleep_ms, 1);
+            lua_setglobal(lua.lua_state(), "sleep_ms");
+        }
+        lua["spawn"] = [&script_engine](const sol::function &function) {
+            abort_check();
+            script_engine.spawn_cooperative_task(function);
+        };
         lua["pc_speaker_beep"] = wrap(pc_speaker_beep);
         lua["current_date_time_ms"] = wrap(current_date_time_ms);
+        lua["get_performance_counters"] = [&lua, &script_engine] {
+            abort_check();
+            return get_performance_counters(lua, &script_engine);
+        };
         lua["round"] = +[](const double value, const unsigned int precision = 0) {
             abort_check();
             return round_double(value, precision);
@@ -54,9 +69,11 @@ void bind_lua_functions(sol::state &lua, sol::table &ui_table, const std::string
     }
     //table functions
     {
-        lua["table_save_to_file"] = [console = console, path = path](const std::string file_name, sol::table input_table, bool over_write_file) {
+        lua["table_save_to_file"] = [console = console, path = path](const std::string file_name, sol::table input_table, bool over_write_file,
+                                                                     sol::optional<std::string> format) {
             abort_check();
-            table_save_to_file(console, get_absolute_file_path(QString::fromStdString(path), file_name), input_table, over_write_file);
+            table_save_to_file(console, get_absolute_file_path(QString::fromStdString(path), file_name), input_table, over_write_file,
+                               format.value_or("json"));
         };
         lua["table_load_from_file"] = [&lua, console = console, path = path](const std::string file_name) {
             abort_check();
@@ -73,6 +90,10 @@ void bind_lua_functions(sol::state &lua, sol::table &ui_table, const std::string
         lua["table_mean"] = wrap(&table_mean);
         lua["table_variance"] = wrap(&table_variance);
         lua["table_standard_deviation"] = wrap(&table_standard_deviation);
+        lua["table_stats"] = [&lua](const sol::object &input_values) {
+            abort_check();
+            return table_stats(lua, input_values);
+        };
         lua["table_set_constant"] = [&lua](sol::table input_values, double constant) {
             abort_check();
             return table_set_constant(lua, input_values, constant);
@@ -192,9 +213,10 @@ void bind_lua_functions(sol::state &lua, sol::table &ui_table, const std::string
     }
     //noise level
     {
-        lua["measure_noise_level_czt"] = [&lua](sol::table rpc_device, const unsigned int dacs_quantity, const unsigned int max_possible_dac_value) {
+        lua["measure_noise_level_czt"] = [&lua](sol::table rpc_device, const unsigned int dacs_quantity, const unsigned int max_possible_dac_value,
+                                                sol::optional<sol::table> options) {
             abort_check();
-            return measure_noise_level_czt(lua, rpc_device, dacs_quantity, max_possible_dac_value);
+            return measure_noise_level_czt(lua, rpc_device, dacs_quantity, max_possible_dac_value, options);
         };
     }
     //Add device discovery functions
@@ -204,6 +226,9 @@ void bind_lua_functions(sol::state &lua, sol::table &ui_table, const std::string
             if (device_description.empty()) {
                 return device_description; //empty device description, return empty matches
             }
+            if (MainWindow::mw == nullptr) {
+                throw sol::error("discover_devices is not available in headless mode");
+            }
             auto devices = MainWindow::mw->discover_devices(script_engine, device_description);
             while (devices.empty()) {
                 abort_check();
@@ -223,6 +248,9 @@ void bind_lua_functions(sol::state &lua, sol::table &ui_table, const std::string
 		)");
         lua["refresh_devices"] = +[] {
             abort_check();
+            if (MainWindow::mw == nullptr) {
+                throw sol::error("refresh_devices is not available in headless mode");
+            }
             Utility::promised_thread_call(
                 MainWindow::mw, +[] {
                     MainWindow::mw->on_actionrefresh_devices_all_triggered(); //does not wait for devices to be refreshed, so we wait afterwards
@@ -231,6 +259,9 @@ void bind_lua_functions(sol::state &lua, sol::table &ui_table, const std::string
         };
         lua["refresh_DUTs"] = +[] {
             abort_check();
+            if (MainWindow::mw == nullptr) {
+                throw sol::error("refresh_DUTs is not available in headless mode");
+            }
             Utility::promised_thread_call(
                 MainWindow::mw, +[] {
                     MainWindow::mw->on_actionrefresh_devices_dut_triggered(); //does not wait for devices to be refreshed, so we wait afterwards
@@ -316,6 +347,7 @@ void bind_lua_functions(sol::state &lua, sol::table &ui_table, const std::string
         struct Require {
             std::string path;
             sol::state &lua;
+            ScriptEngine &script_engine;
             sol::protected_function_result operator()(const std::string &file) const {
                 auto search_paths = get_lua_lib_search_paths_for_lua(QString::fromStdString(path), "");
                 QString tried_paths;
@@ -324,7 +356,8 @@ void bind_lua_functions(sol::state &lua, sol::table &ui_table, const std::string
                     auto abs_path = dir.absoluteFilePath(QString::fromStdString(file) + ".lua");
                     tried_paths += '\n' + abs_path;
                     if (QFile::exists(abs_path)) {
-                        return lua.script_file(abs_path.toStdString());
+                        script_engine.add_required_file(abs_path);
+                        return Lua_bytecode_cache::get().script_file(lua, abs_path);
                     }
                 }
                 throw std::runtime_error("Can not find a path to required module \"" + file + "\" for script: " + path +
@@ -332,7 +365,7 @@ void bind_lua_functions(sol::state &lua, sol::table &ui_table, const std::string
             }
         };
 
-        lua["require"] = Require{path, lua};
+        lua["require"] = Require{path, lua, script_engine};
 #else
 
         lua["require"] = [path, &lua](const std::string &file) {
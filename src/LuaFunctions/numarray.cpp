@@ -0,0 +1,309 @@
+#include "numarray.h"
+#include "lua_functions.h"
+#include "spectrum.h"
+
+#include <QObject>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <sol.hpp>
+#include <stdexcept>
+
+//The kernels below work on plain pointers in simple counted loops without branches that depend on earlier iterations, which is what compilers
+//vectorize. Floating point reductions are not reordered by the compiler, so they use four independent partial results instead of one.
+
+template <class Operation>
+static NumArray elementwise(const std::vector<double> &a, Operation &&operation) {
+    std::vector<double> result(a.size());
+    const double *in = a.data();
+    double *out = result.data();
+    const std::size_t size = a.size();
+    for (std::size_t i = 0; i < size; i++) {
+        out[i] = operation(in[i]);
+    }
+    return NumArray{std::move(result)};
+}
+
+template <class Operation>
+static NumArray elementwise(const std::vector<double> &a, const std::vector<double> &b, const char *function_name, Operation &&operation) {
+    if (a.size() != b.size()) {
+        throw std::runtime_error(QObject::tr("NumArray:%1: sizes of the arrays differ (%2 and %3)").arg(function_name).arg(a.size()).arg(b.size()).toStdString());
+    }
+    std::vector<double> result(a.size());
+    const double *in_a = a.data();
+    const double *in_b = b.data();
+    double *out = result.data();
+    const std::size_t size = a.size();
+    for (std::size_t i = 0; i < size; i++) {
+        out[i] = operation(in_a[i], in_b[i]);
+    }
+    return NumArray{std::move(result)};
+}
+
+template <class Map, class Combine>
+static double reduce(const std::vector<double> &values, double initial, Map &&map, Combine &&combine) {
+    double partial[4] = {initial, initial, initial, initial};
+    const double *in = values.data();
+    const std::size_t size = values.size();
+    std::size_t i = 0;
+    for (; i + 4 <= size; i += 4) {
+        partial[0] = combine(partial[0], map(in[i]));
+        partial[1] = combine(partial[1], map(in[i + 1]));
+        partial[2] = combine(partial[2], map(in[i + 2]));
+        partial[3] = combine(partial[3], map(in[i + 3]));
+    }
+    for (; i < size; i++) {
+        partial[0] = combine(partial[0], map(in[i]));
+    }
+    return combine(combine(partial[0], partial[1]), combine(partial[2], partial[3]));
+}
+
+static double identity(double value) {
+    return value;
+}
+
+static double absolute(double value) {
+    return std::abs(value);
+}
+
+static double plus(double a, double b) {
+    return a + b;
+}
+
+static double maximum(double a, double b) {
+    return a < b ? b : a;
+}
+
+static double minimum(double a, double b) {
+    return b < a ? b : a;
+}
+
+NumArray::NumArray(std::vector<double> values)
+    : values(std::move(values)) {}
+
+NumArray::NumArray(std::size_t size, double constant)
+    : values(size, constant) {}
+
+NumArray NumArray::from_table(const sol::table &values) {
+    lua_State *L = values.lua_state();
+    values.push();
+    const auto size = lua_rawlen(L, -1);
+    std::vector<double> result(size);
+    for (std::size_t i = 0; i < size; i++) {
+        lua_rawgeti(L, -1, static_cast<lua_Integer>(i + 1));
+        int is_number = 0;
+        result[i] = lua_tonumberx(L, -1, &is_number);
+        lua_pop(L, 1);
+        if (not is_number) {
+            lua_pop(L, 1);
+            throw std::runtime_error(QObject::tr("NumArray: value at index %1 of the table is not a number").arg(i + 1).toStdString());
+        }
+    }
+    lua_pop(L, 1);
+    return NumArray{std::move(result)};
+}
+
+NumArray NumArray::range(double start, double stop, double step) {
+    //same loop as table_range so the values and the number of values are identical
+    if (step == 0) {
+        throw std::runtime_error(QObject::tr("NumArray.range: step value must not be 0. Values are: start=%1, stop=%2, step=%3")
+                                     .arg(start)
+                                     .arg(stop)
+                                     .arg(step)
+                                     .toStdString());
+    }
+    if ((step > 0 && start >= stop) || (step < 0 && start <= stop)) {
+        throw std::runtime_error(QObject::tr("NumArray.range: start and stop values do not match the direction of the step value. Values are: "
+                                             "start=%1, stop=%2, step=%3")
+                                     .arg(start)
+                                     .arg(stop)
+                                     .arg(step)
+                                     .toStdString());
+    }
+    std::vector<double> result;
+    result.reserve(static_cast<std::size_t>((stop - start) / step) + 2);
+    for (double value = start; step > 0 ? value <= stop : value >= stop; value += step) {
+        result.push_back(value);
+    }
+    return NumArray{std::move(result)};
+}
+
+sol::table NumArray::to_table(lua_State *lua) const {
+    lua_createtable(lua, static_cast<int>(values.size()), 0);
+    for (std::size_t i = 0; i < values.size(); i++) {
+        lua_pushnumber(lua, values[i]);
+        lua_rawseti(lua, -2, static_cast<lua_Integer>(i + 1));
+    }
+    sol::table table{lua, -1};
+    lua_pop(lua, 1);
+    return table;
+}
+
+std::size_t NumArray::size() const {
+    return values.size();
+}
+
+double NumArray::get(std::size_t index) const {
+    if (index < 1 || index > values.size()) {
+        throw std::runtime_error(QObject::tr("NumArray:get: index %1 is out of range 1 to %2").arg(index).arg(values.size()).toStdString());
+    }
+    return values[index - 1];
+}
+
+void NumArray::set(std::size_t index, double value) {
+    if (index < 1 || index > values.size()) {
+        throw std::runtime_error(QObject::tr("NumArray:set: index %1 is out of range 1 to %2").arg(index).arg(values.size()).toStdString());
+    }
+    values[index - 1] = value;
+}
+
+const std::vector<double> &NumArray::get_values() const {
+    return values;
+}
+
+double NumArray::sum() const {
+    return reduce(values, 0, identity, plus);
+}
+
+double NumArray::mean() const {
+    if (values.empty()) {
+        return 0;
+    }
+    return sum() / values.size();
+}
+
+double NumArray::variance() const {
+    if (values.empty()) {
+        return 0;
+    }
+    const double mean_value = mean();
+    return reduce(values, 0, [mean_value](double value) { return (value - mean_value) * (value - mean_value); }, plus) / values.size();
+}
+
+double NumArray::standard_deviation() const {
+    return std::sqrt(variance());
+}
+
+double NumArray::max() const {
+    if (values.empty()) {
+        return 0;
+    }
+    return reduce(values, values.front(), identity, maximum);
+}
+
+double NumArray::min() const {
+    if (values.empty()) {
+        return 0;
+    }
+    return reduce(values, values.front(), identity, minimum);
+}
+
+double NumArray::max_abs() const {
+    if (values.empty()) {
+        return 0;
+    }
+    return reduce(values, 0, absolute, maximum);
+}
+
+double NumArray::min_abs() const {
+    if (values.empty()) {
+        return 0;
+    }
+    return reduce(values, std::abs(values.front()), absolute, minimum);
+}
+
+NumArray NumArray::add(const NumArray &other) const {
+    return elementwise(values, other.values, "add", plus);
+}
+
+NumArray NumArray::add_at(const NumArray &other, std::size_t at) const {
+    if (at < 1) {
+        throw std::runtime_error("NumArray:add_at: at index must be > 0 but is " + std::to_string(at) + ".");
+    }
+    //missing values are 0 like in table_add_table_at
+    std::vector<double> result(std::max(values.size(), other.values.size() + at - 1));
+    std::copy(std::begin(values), std::end(values), std::begin(result));
+    const double *in = other.values.data();
+    double *out = result.data() + at - 1;
+    const std::size_t size = other.values.size();
+    for (std::size_t i = 0; i < size; i++) {
+        out[i] += in[i];
+    }
+    return NumArray{std::move(result)};
+}
+
+NumArray NumArray::add_constant(double constant) const {
+    return elementwise(values, [constant](double value) { return value + constant; });
+}
+
+NumArray NumArray::sub(const NumArray &other) const {
+    return elementwise(values, other.values, "sub", [](double a, double b) { return a - b; });
+}
+
+NumArray NumArray::mul(const NumArray &other) const {
+    return elementwise(values, other.values, "mul", [](double a, double b) { return a * b; });
+}
+
+NumArray NumArray::mul_constant(double constant) const {
+    return elementwise(values, [constant](double value) { return value * constant; });
+}
+
+NumArray NumArray::div(const NumArray &other) const {
+    return elementwise(values, other.values, "div", [](double a, double b) { return b == 0 ? std::numeric_limits<double>::infinity() : a / b; });
+}
+
+NumArray NumArray::round(unsigned int precision) const {
+    return elementwise(values, [precision](double value) { return round_double(value, precision); });
+}
+
+NumArray NumArray::abs() const {
+    return elementwise(values, absolute);
+}
+
+NumArray NumArray::mid(std::size_t start, std::size_t length) const {
+    if (start < 1 || start + length - 1 > values.size()) {
+        throw std::runtime_error(
+            QObject::tr("NumArray:mid: range from %1 with length %2 is out of range 1 to %3").arg(start).arg(length).arg(values.size()).toStdString());
+    }
+    return NumArray{std::vector<double>(std::begin(values) + start - 1, std::begin(values) + start - 1 + length)};
+}
+
+NumArray NumArray::concat(const NumArray &other) const {
+    std::vector<double> result;
+    result.reserve(values.size() + other.values.size());
+    result.insert(std::end(result), std::begin(values), std::end(values));
+    result.insert(std::end(result), std::begin(other.values), std::end(other.values));
+    return NumArray{std::move(result)};
+}
+
+NumArray NumArray::set_constant(double constant) const {
+    return NumArray{values.size(), constant};
+}
+
+bool NumArray::equal(const NumArray &other) const {
+    return values == other.values;
+}
+
+bool NumArray::equal_constant(double constant) const {
+    return std::all_of(std::begin(values), std::end(values), [constant](double value) { return value == constant; });
+}
+
+NumArray NumArray::rebin(std::size_t factor) const {
+    return NumArray{Spectrum::rebin(values, factor)};
+}
+
+NumArray NumArray::moving_average(std::size_t window) const {
+    return NumArray{Spectrum::moving_average(values, window)};
+}
+
+NumArray NumArray::savitzky_golay(std::size_t window, unsigned int order) const {
+    return NumArray{Spectrum::savitzky_golay(values, window, order)};
+}
+
+NumArray NumArray::snip_background(std::size_t iterations) const {
+    return NumArray{Spectrum::snip_background(values, iterations)};
+}
+
+NumArray NumArray::subtract_background(std::size_t iterations) const {
+    return sub(snip_background(iterations));
+}
@@ -0,0 +1,256 @@
+#ifndef NUMARRAY_H
+#define NUMARRAY_H
+
+#include <cstddef>
+#include <sol_forward.hpp>
+#include <vector>
+
+struct lua_State;
+
+/** \ingroup convenience
+ *  \{
+ */
+// clang-format off
+
+/*!
+    \class   NumArray
+    \brief A NumArray is a packed array of numbers with the operations of the \c table_* functions.
+    Lua tables store every number separately and every \c table_* function builds a new table element by element. A NumArray stores its values
+    in one contiguous block instead, so calculations on large tables such as 16k channel spectra run much faster and create no garbage per element.
+    Convert a table once with \c NumArray.new(table), do the math on NumArray objects and convert the result back with \c to_table() where a table is needed.
+    Indices start at 1 like in Lua tables.
+*/
+// clang-format on
+
+class NumArray {
+    public:
+#ifdef DOXYGEN_ONLY
+    // this block is just for ducumentation purpose
+    NumArray(number_table values);
+    NumArray(int size, number constant);
+#endif
+    /// \cond HIDDEN_SYMBOLS
+    NumArray() = default;
+    explicit NumArray(std::vector<double> values);
+    NumArray(std::size_t size, double constant);
+    static NumArray from_table(const sol::table &values);
+    /// \endcond
+    // clang-format off
+/*! \fn NumArray(number_table values);
+    \brief Creates a NumArray with a copy of the numbers of \c values.
+    \fn NumArray(int size, number constant);
+    \brief Creates a NumArray with \c size elements initialized with \c constant.
+
+     \par examples:
+     \code
+    local spectrum = NumArray.new({1, 2, 3, 4})
+    local background = NumArray.new(4, 0.5)
+    local net = spectrum - background
+    print(net:to_table()) -- {0.5, 1.5, 2.5, 3.5}
+    print(#net) -- 4
+    \endcode
+*/
+    // clang-format on
+
+#ifdef DOXYGEN_ONLY
+    // this block is just for ducumentation purpose
+    NumArray range(number start, number stop, number step);
+#endif
+    /// \cond HIDDEN_SYMBOLS
+    static NumArray range(double start, double stop, double step);
+    /// \endcond
+    // clang-format off
+/*! \fn NumArray range(number start, number stop, number step);
+    \brief Returns a NumArray with evenly spaced values from \c start to \c stop including both like \c table_range.
+     \par examples:
+     \code
+    local x = NumArray.range(0, 1, 0.25) -- {0, 0.25, 0.5, 0.75, 1}
+    \endcode
+*/
+    // clang-format on
+
+#ifdef DOXYGEN_ONLY
+    // this block is just for ducumentation purpose
+    number_table to_table();
+    int size();
+    number get(int index);
+    set(int index, number value);
+#endif
+    /// \cond HIDDEN_SYMBOLS
+    sol::table to_table(lua_State *lua) const;
+    std::size_t size() const;
+    double get(std::size_t index) const;
+    void set(std::size_t index, double value);
+    const std::vector<double> &get_values() const;
+    /// \endcond
+    // clang-format off
+/*! \fn number_table to_table();
+    \brief Returns a Lua table with the values of the NumArray.
+    \fn int size();
+    \brief Returns the number of values. \c #array returns the same.
+    \fn number get(int index);
+    \brief Returns the value at \c index. Raises an error if \c index is not between 1 and \c size().
+    \fn set(int index, number value);
+    \brief Sets the value at \c index. Raises an error if \c index is not between 1 and \c size().
+*/
+    // clang-format on
+
+#ifdef DOXYGEN_ONLY
+    // this block is just for ducumentation purpose
+    number sum();
+    number mean();
+    number variance();
+    number standard_deviation();
+    number max();
+    number min();
+    number max_abs();
+    number min_abs();
+#endif
+    /// \cond HIDDEN_SYMBOLS
+    double sum() const;
+    double mean() const;
+    double variance() const;
+    double standard_deviation() const;
+    double max() const;
+    double min() const;
+    double max_abs() const;
+    double min_abs() const;
+    /// \endcond
+    // clang-format off
+/*! \fn number sum();
+    \brief Same as \c table_sum.
+    \fn number mean();
+    \brief Same as \c table_mean.
+    \fn number variance();
+    \brief Same as \c table_variance.
+    \fn number standard_deviation();
+    \brief Same as \c table_standard_deviation.
+    \fn number max();
+    \brief Same as \c table_max.
+    \fn number min();
+    \brief Same as \c table_min.
+    \fn number max_abs();
+    \brief Same as \c table_max_abs.
+    \fn number min_abs();
+    \brief Same as \c table_min_abs.
+*/
+    // clang-format on
+
+#ifdef DOXYGEN_ONLY
+    // this block is just for ducumentation purpose
+    NumArray add(NumArray other);
+    NumArray add_at(NumArray other, int at);
+    NumArray add_constant(number constant);
+    NumArray sub(NumArray other);
+    NumArray mul(NumArray other);
+    NumArray mul_constant(number constant);
+    NumArray div(NumArray other);
+    NumArray round(int precision);
+    NumArray abs();
+    NumArray mid(int start, int length);
+    NumArray concat(NumArray other);
+    NumArray set_constant(number constant);
+    bool equal(NumArray other);
+    bool equal_constant(number constant);
+#endif
+    /// \cond HIDDEN_SYMBOLS
+    NumArray add(const NumArray &other) const;
+    NumArray add_at(const NumArray &other, std::size_t at) const;
+    NumArray add_constant(double constant) const;
+    NumArray sub(const NumArray &other) const;
+    NumArray mul(const NumArray &other) const;
+    NumArray mul_constant(double constant) const;
+    NumArray div(const NumArray &other) const;
+    NumArray round(unsigned int precision) const;
+    NumArray abs() const;
+    NumArray mid(std::size_t start, std::size_t length) const;
+    NumArray concat(const NumArray &other) const;
+    NumArray set_constant(double constant) const;
+    bool equal(const NumArray &other) const;
+    bool equal_constant(double constant) const;
+    /// \endcond
+    // clang-format off
+/*! \fn NumArray add(NumArray other);
+    \brief Same as \c table_add_table. \c a + \c b returns the same.
+    \fn NumArray add_at(NumArray other, int at);
+    \brief Same as \c table_add_table_at.
+    \fn NumArray add_constant(number constant);
+    \brief Same as \c table_add_constant.
+    \fn NumArray sub(NumArray other);
+    \brief Same as \c table_sub_table. \c a - \c b returns the same.
+    \fn NumArray mul(NumArray other);
+    \brief Same as \c table_mul_table. \c a * \c b returns the same.
+    \fn NumArray mul_constant(number constant);
+    \brief Same as \c table_mul_constant.
+    \fn NumArray div(NumArray other);
+    \brief Same as \c table_div_table. \c a / \c b returns the same.
+    \fn NumArray round(int precision);
+    \brief Same as \c table_round.
+    \fn NumArray abs();
+    \brief Same as \c table_abs.
+    \fn NumArray mid(int start, int length);
+    \brief Same as \c table_mid.
+    \fn NumArray concat(NumArray other);
+    \brief Same as \c table_concat.
+    \fn NumArray set_constant(number constant);
+    \brief Same as \c table_set_constant.
+    \fn bool equal(NumArray other);
+    \brief Same as \c table_equal_table. \c a == \c b returns the same.
+    \fn bool equal_constant(number constant);
+    \brief Same as \c table_equal_constant.
+
+    The element wise operations raise an error if the sizes of the arrays differ, except for \c add_at and \c concat.
+*/
+    // clang-format on
+
+#ifdef DOXYGEN_ONLY
+    // this block is just for ducumentation purpose
+    NumArray rebin(int factor);
+    NumArray moving_average(int window);
+    NumArray savitzky_golay(int window, int order);
+    NumArray snip_background(int iterations);
+    NumArray subtract_background(int iterations);
+    table find_peaks(number min_height);
+#endif
+    /// \cond HIDDEN_SYMBOLS
+    NumArray rebin(std::size_t factor) const;
+    NumArray moving_average(std::size_t window) const;
+    NumArray savitzky_golay(std::size_t window, unsigned int order) const;
+    NumArray snip_background(std::size_t iterations) const;
+    NumArray subtract_background(std::size_t iterations) const;
+    /// \endcond
+    // clang-format off
+/*! \fn NumArray rebin(int factor);
+    \brief Returns a spectrum where every channel is the sum of \c factor neighbouring channels. The last channel holds the rest if the size is not a multiple of \c factor.
+    \fn NumArray moving_average(int window);
+    \brief Returns the centered moving average over an odd number of \c window channels. At the borders the window shrinks to the available channels.
+    \fn NumArray savitzky_golay(int window, int order);
+    \brief Returns the spectrum smoothed with a Savitzky-Golay filter with an odd \c window size and a polynomial of \c order. Peaks keep their height
+    and width better than with a moving average. The \c window/2 channels at each border keep their original values.
+    \fn NumArray snip_background(int iterations);
+    \brief Returns the continuum below the peaks estimated with the SNIP algorithm. \c iterations should be about the width of the widest peak in channels.
+    \fn NumArray subtract_background(int iterations);
+    \brief Returns the spectrum minus \c snip_background(iterations).
+    \fn table find_peaks(number min_height);
+    \brief Finds the peaks with a height of at least \c min_height and returns a table with a table per peak with the fields
+    \c channel (channel of the maximum), \c height, \c centroid (count weighted mean channel within the full width at half maximum), \c fwhm,
+    \c left and \c right (interpolated half maximum positions) and \c area (sum of the counts between \c left and \c right).
+    The spectrum should be background free and smoothed if it is noisy.
+
+     \par examples:
+     \code
+    local spectrum = NumArray.new(counts) -- counts of a 4096 channel detector
+    local net = spectrum:savitzky_golay(9, 2):subtract_background(30)
+    for _, peak in ipairs(net:find_peaks(100)) do
+        print(peak.centroid, peak.fwhm, peak.area)
+    end
+    \endcode
+*/
+    // clang-format on
+
+    private:
+    std::vector<double> values;
+};
+
+/** \} */ // end of group convenience
+#endif // NUMARRAY_H
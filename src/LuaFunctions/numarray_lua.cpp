@@ -0,0 +1,74 @@
+#include "numarray_lua.h"
+#include "numarray.h"
+#include "scriptsetup_helper.h"
+#include "spectrum.h"
+
+void bind_numarray(sol::state &lua) {
+    lua.new_usertype<NumArray>(
+        "NumArray", //
+        sol::meta_function::construct,
+        sol::factories(
+            [](sol::table values) {
+                abort_check();
+                return NumArray::from_table(values);
+            },
+            [](std::size_t size, double constant) {
+                abort_check();
+                return NumArray{size, constant};
+            }),                                                     //
+        "range", wrap(&NumArray::range),                            //
+        "to_table",                                                 //
+        [](const NumArray &array, sol::this_state lua) {
+            abort_check();
+            return array.to_table(lua);
+        },                                                          //
+        "size", wrap(&NumArray::size),                              //
+        "get", wrap(&NumArray::get),                                //
+        "set", wrap(&NumArray::set),                                //
+        "sum", wrap(&NumArray::sum),                                //
+        "mean", wrap(&NumArray::mean),                              //
+        "variance", wrap(&NumArray::variance),                      //
+        "standard_deviation", wrap(&NumArray::standard_deviation),  //
+        "max", wrap(&NumArray::max),                                //
+        "min", wrap(&NumArray::min),                                //
+        "max_abs", wrap(&NumArray::max_abs),                        //
+        "min_abs", wrap(&NumArray::min_abs),                        //
+        "add", wrap(&NumArray::add),                                //
+        "add_at", wrap(&NumArray::add_at),                          //
+        "add_constant", wrap(&NumArray::add_constant),              //
+        "sub", wrap(&NumArray::sub),                                //
+        "mul", wrap(&NumArray::mul),                                //
+        "mul_constant", wrap(&NumArray::mul_constant),              //
+        "div", wrap(&NumArray::div),                                //
+        "round", wrap(&NumArray::round),                            //
+        "abs", wrap(&NumArray::abs),                                //
+        "mid", wrap(&NumArray::mid),                                //
+        "concat", wrap(&NumArray::concat),                          //
+        "set_constant", wrap(&NumArray::set_constant),              //
+        "equal", wrap(&NumArray::equal),                            //
+        "equal_constant", wrap(&NumArray::equal_constant),          //
+        "rebin", wrap(&NumArray::rebin),                            //
+        "moving_average", wrap(&NumArray::moving_average),          //
+        "savitzky_golay", wrap(&NumArray::savitzky_golay),          //
+        "snip_background", wrap(&NumArray::snip_background),        //
+        "subtract_background", wrap(&NumArray::subtract_background), //
+        "find_peaks",                                               //
+        [](const NumArray &array, double min_height, sol::this_state lua) {
+            abort_check();
+            sol::state_view lua_view{lua};
+            sol::table peaks = lua_view.create_table();
+            for (const auto &peak : Spectrum::find_peaks(array.get_values(), min_height)) {
+                //channels are 1 based in Lua
+                peaks.add(lua_view.create_table_with("channel", peak.channel + 1, "height", peak.height, "centroid", peak.centroid + 1, "fwhm", peak.fwhm,
+                                                     "left", peak.left + 1, "right", peak.right + 1, "area", peak.area));
+            }
+            return peaks;
+        },                                                          //
+        sol::meta_function::length, wrap(&NumArray::size),          //
+        sol::meta_function::addition, wrap(&NumArray::add),         //
+        sol::meta_function::subtraction, wrap(&NumArray::sub),      //
+        sol::meta_function::multiplication, wrap(&NumArray::mul),   //
+        sol::meta_function::division, wrap(&NumArray::div),         //
+        sol::meta_function::equal_to, wrap(&NumArray::equal)        //
+    );
+}
@@ -0,0 +1,8 @@
+#ifndef NUMARRAY_LUA_H
+#define NUMARRAY_LUA_H
+
+#include <sol_forward.hpp>
+
+void bind_numarray(sol::state &lua);
+
+#endif // NUMARRAY_LUA_H
@@ -0,0 +1,164 @@
+#include "spectrum.h"
+
+#include <QObject>
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+std::vector<double> Spectrum::rebin(const std::vector<double> &counts, std::size_t factor) {
+    if (factor == 0) {
+        throw std::runtime_error("rebin: factor must be > 0");
+    }
+    std::vector<double> result((counts.size() + factor - 1) / factor);
+    for (std::size_t i = 0; i < counts.size(); i++) {
+        result[i / factor] += counts[i];
+    }
+    return result;
+}
+
+std::vector<double> Spectrum::moving_average(const std::vector<double> &counts, std::size_t window) {
+    if (window == 0 || window % 2 == 0) {
+        throw std::runtime_error(QObject::tr("moving_average: window must be an odd number but is %1").arg(window).toStdString());
+    }
+    const std::size_t size = counts.size();
+    const std::size_t half_window = window / 2;
+    std::vector<double> result(size);
+    //prefix sums make every output value two lookups regardless of the window size
+    std::vector<double> prefix_sum(size + 1);
+    for (std::size_t i = 0; i < size; i++) {
+        prefix_sum[i + 1] = prefix_sum[i] + counts[i];
+    }
+    for (std::size_t i = 0; i < size; i++) {
+        const std::size_t reach = std::min({half_window, i, size - 1 - i});
+        result[i] = (prefix_sum[i + reach + 1] - prefix_sum[i - reach]) / (2 * reach + 1);
+    }
+    return result;
+}
+
+//the smoothed value is the value at 0 of the least squares polynomial fitted through the window, which is a fixed weighted sum of the window
+static std::vector<double> savitzky_golay_coefficients(int half_window, unsigned int order) {
+    const int terms = static_cast<int>(order) + 1;
+    //normal equations (A^T A) x = e_0 with A[j][k] = j^k for j in [-half_window, half_window], augmented by the right hand side
+    std::vector<std::vector<double>> matrix(terms, std::vector<double>(terms + 1));
+    for (int row = 0; row < terms; row++) {
+        for (int column = 0; column < terms; column++) {
+            for (int j = -half_window; j <= half_window; j++) {
+                matrix[row][column] += std::pow(j, row + column);
+            }
+        }
+        matrix[row][terms] = row == 0 ? 1 : 0;
+    }
+    for (int pivot = 0; pivot < terms; pivot++) {
+        int best = pivot;
+        for (int row = pivot + 1; row < terms; row++) {
+            if (std::abs(matrix[row][pivot]) > std::abs(matrix[best][pivot])) {
+                best = row;
+            }
+        }
+        std::swap(matrix[pivot], matrix[best]);
+        for (int row = 0; row < terms; row++) {
+            if (row == pivot) {
+                continue;
+            }
+            const double factor = matrix[row][pivot] / matrix[pivot][pivot];
+            for (int column = pivot; column <= terms; column++) {
+                matrix[row][column] -= factor * matrix[pivot][column];
+            }
+        }
+    }
+    std::vector<double> coefficients(2 * half_window + 1);
+    for (int j = -half_window; j <= half_window; j++) {
+        double coefficient = 0;
+        for (int k = 0; k < terms; k++) {
+            coefficient += matrix[k][terms] / matrix[k][k] * std::pow(j, k);
+        }
+        coefficients[j + half_window] = coefficient;
+    }
+    return coefficients;
+}
+
+std::vector<double> Spectrum::savitzky_golay(const std::vector<double> &counts, std::size_t window, unsigned int order) {
+    if (window % 2 == 0 || window <= order) {
+        throw std::runtime_error(
+            QObject::tr("savitzky_golay: window must be an odd number greater than the order but window is %1 and order is %2").arg(window).arg(order).toStdString());
+    }
+    std::vector<double> result = counts;
+    if (counts.size() < window) {
+        return result;
+    }
+    const auto coefficients = savitzky_golay_coefficients(static_cast<int>(window / 2), order);
+    const double *weights = coefficients.data();
+    for (std::size_t i = 0; i + window <= counts.size(); i++) {
+        const double *in = counts.data() + i;
+        double sum = 0;
+        for (std::size_t j = 0; j < window; j++) {
+            sum += weights[j] * in[j];
+        }
+        result[i + window / 2] = sum;
+    }
+    return result;
+}
+
+std::vector<double> Spectrum::snip_background(const std::vector<double> &counts, std::size_t iterations) {
+    //the square root transformation keeps the clipping from cutting into the tails of large peaks
+    std::vector<double> transformed(counts.size());
+    std::transform(std::begin(counts), std::end(counts), std::begin(transformed), [](double count) { return std::sqrt(std::max(count, 0.)); });
+    std::vector<double> clipped = transformed;
+    const std::size_t size = counts.size();
+    for (std::size_t width = std::min(iterations, size / 2); width >= 1; width--) {
+        for (std::size_t i = width; i + width < size; i++) {
+            clipped[i] = std::min(transformed[i], (transformed[i - width] + transformed[i + width]) / 2);
+        }
+        std::copy(std::begin(clipped) + width, std::end(clipped) - width, std::begin(transformed) + width);
+    }
+    std::transform(std::begin(transformed), std::end(transformed), std::begin(transformed), [](double value) { return value * value; });
+    return transformed;
+}
+
+//position between channel and next_channel where the linear interpolation between them reaches level
+static double interpolate_crossing(const std::vector<double> &counts, std::size_t channel, std::size_t next_channel, double level) {
+    const double difference = counts[next_channel] - counts[channel];
+    const double direction = next_channel > channel ? 1 : -1;
+    if (difference == 0) {
+        return channel;
+    }
+    return channel + direction * (level - counts[channel]) / difference;
+}
+
+std::vector<Spectrum::Peak> Spectrum::find_peaks(const std::vector<double> &counts, double min_height) {
+    std::vector<Peak> peaks;
+    const std::size_t size = counts.size();
+    for (std::size_t i = 1; i + 1 < size; i++) {
+        if (counts[i] < min_height || counts[i] <= counts[i - 1] || counts[i] < counts[i + 1]) {
+            continue;
+        }
+        Peak peak;
+        peak.channel = i;
+        peak.height = counts[i];
+        const double half_maximum = peak.height / 2;
+
+        std::size_t left = i;
+        while (left > 0 && counts[left - 1] > half_maximum) {
+            left--;
+        }
+        std::size_t right = i;
+        while (right + 1 < size && counts[right + 1] > half_maximum) {
+            right++;
+        }
+        peak.left = left > 0 ? interpolate_crossing(counts, left, left - 1, half_maximum) : left;
+        peak.right = right + 1 < size ? interpolate_crossing(counts, right, right + 1, half_maximum) : right;
+        peak.fwhm = peak.right - peak.left;
+
+        double weighted_sum = 0;
+        for (std::size_t channel = left; channel <= right; channel++) {
+            peak.area += counts[channel];
+            weighted_sum += counts[channel] * channel;
+        }
+        peak.centroid = peak.area != 0 ? weighted_sum / peak.area : i;
+        peaks.push_back(peak);
+
+        //local maxima on the flanks of this peak are noise, not separate peaks
+        i = right;
+    }
+    return peaks;
+}
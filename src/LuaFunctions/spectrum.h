@@ -0,0 +1,31 @@
+#ifndef SPECTRUM_H
+#define SPECTRUM_H
+
+#include <cstddef>
+#include <vector>
+
+//Kernels for processing spectra such as the channel counts of a gamma detector. Channels are 0 based here, the Lua bindings convert to 1 based.
+namespace Spectrum {
+    //sums up factor neighbouring channels, the last bin contains the remaining channels if the size is not a multiple of factor
+    std::vector<double> rebin(const std::vector<double> &counts, std::size_t factor);
+    //centered moving average over window channels, the window shrinks symmetrically at the borders
+    std::vector<double> moving_average(const std::vector<double> &counts, std::size_t window);
+    //Savitzky-Golay smoothing with an odd window size and a polynomial of the given order, the borders keep their original values
+    std::vector<double> savitzky_golay(const std::vector<double> &counts, std::size_t window, unsigned int order);
+    //estimates the continuum below the peaks with the SNIP algorithm, iterations should be about the width of the widest peak in channels
+    std::vector<double> snip_background(const std::vector<double> &counts, std::size_t iterations);
+
+    struct Peak {
+        std::size_t channel = 0; //channel with the highest count
+        double height = 0;
+        double centroid = 0; //count weighted mean channel within the full width at half maximum
+        double fwhm = 0;     //in channels, interpolated between the channels around the half maximum
+        double left = 0;     //interpolated position of the half maximum left of the peak
+        double right = 0;    //interpolated position of the half maximum right of the peak
+        double area = 0;     //sum of the counts of the channels between left and right
+    };
+    //finds local maxima of at least min_height and measures them, the counts should be background free and smoothed if they are noisy
+    std::vector<Peak> find_peaks(const std::vector<double> &counts, double min_height);
+} // namespace Spectrum
+
+#endif // SPECTRUM_H
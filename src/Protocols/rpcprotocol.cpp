@@ -3,6 +3,7 @@
 #include "channel_codec_wrapper.h"
 #include "config.h"
 #include "console.h"
+#include "performance_counters.h"
 #include "qt_util.h"
 #include "rpc_ui.h"
 #include "rpcruntime_decoded_function_call.h"
@@ -10,6 +11,7 @@
 #include "rpcruntime_encoded_function_call.h"
 #include "rpcruntime_encoder.h"
 #include "rpcruntime_protocol_description.h"
+#include "tracing.h"
 
 #include <QByteArray>
 #include <QDateTime>
@@ -175,11 +177,25 @@ std::unique_ptr<RPCRuntimeDecodedFunctionCall> RPCProtocol::call_and_wait(const
 
 std::unique_ptr<RPCRuntimeDecodedFunctionCall> RPCProtocol::call_and_wait(const RPCRuntimeEncodedFunctionCall &call, CommunicationDevice::Duration duration,
                                                                           bool show_messagebox_when_timeout) {
+    TRACE_SCOPE("RPCProtocol::call_and_wait");
+    const Performance_counters::Scoped_timer timer{Performance_counters::Histogram::rpc_transaction_ms};
+    bool is_retry = false;
     do {
-        auto result = rpc_runtime_protocol.get()->call_and_wait(call, duration);
+        if (is_retry) {
+            Performance_counters::add(Performance_counters::Counter::rpc_retries);
+        }
+        is_retry = true;
+        Performance_counters::add(Performance_counters::Counter::rpc_transactions);
+        auto result = [&] {
+            std::lock_guard<std::mutex> lock{call_mutex}; //not held while asking for a retry so the dialog blocks no other caller
+            return rpc_runtime_protocol.get()->call_and_wait(call, duration);
+        }();
         if (result.error == RPCError::success) {
             return std::move(result.decoded_function_call_reply);
         }
+        if (result.error == RPCError::timeout_happened) {
+            Performance_counters::add(Performance_counters::Counter::rpc_timeouts);
+        }
     } while (Utility::promised_thread_call(MainWindow::mw, [this, function_name = call.get_description()->get_function_name(), show_messagebox_when_timeout] {
         if (show_messagebox_when_timeout) {
             return QMessageBox::warning(nullptr, QObject::tr("CrystalTestFramework - Timeout error"),
@@ -254,10 +270,12 @@ bool RPCProtocol::has_function(const std::string &name) const {
 }
 
 RPCFunctionCallResult RPCProtocol::call_get_hash_function() const {
+    std::lock_guard<std::mutex> lock{call_mutex};
     return rpc_runtime_protocol->call_get_hash_function();
 }
 
 RPCFunctionCallResult RPCProtocol::call_get_hash_function(int retries) const {
+    std::lock_guard<std::mutex> lock{call_mutex};
     return rpc_runtime_protocol->call_get_hash_function(retries);
 }
 
@@ -10,6 +10,7 @@
 #include "rpcruntime_protcol.h"
 #include "rpcruntime_protocol_description.h"
 #include <memory>
+#include <mutex>
 #include <sol_forward.hpp>
 
 class QTreeWidgetItem;
@@ -80,6 +81,7 @@ class RPCProtocol : public Protocol {
 
     private:
     std::unique_ptr<RPCRuntimeProtocol> rpc_runtime_protocol;
+    mutable std::mutex call_mutex; //only one transaction with the device at a time, calls come from script threads and the RPC call pool
 
     void console_message(RPCConsoleLevel level, QString message);
 
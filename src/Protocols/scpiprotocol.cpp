@@ -5,7 +5,9 @@
 #include "Windows/scpimetadatadeviceselector.h"
 #include "config.h"
 #include "console.h"
+#include "performance_counters.h"
 #include "qt_util.h"
+#include "tracing.h"
 
 #include <QByteArray>
 #include <QDateTime>
@@ -254,6 +256,9 @@ static QString clean_up_regex_with_escape_characters(QString expr) {
 }
 
 bool SCPIProtocol::send_scpi_request(Duration timeout, std::string request, bool use_leading_escape, bool answer_expected) {
+    TRACE_SCOPE("SCPIProtocol::send_scpi_request");
+    const Performance_counters::Scoped_timer timer{Performance_counters::Histogram::scpi_transaction_ms};
+    Performance_counters::add(Performance_counters::Counter::scpi_transactions);
     bool cancel_request = false;
     bool success = false;
     request = request + escape_characters;
@@ -287,6 +292,9 @@ bool SCPIProtocol::send_scpi_request(Duration timeout, std::string request, bool
     if (!answer_expected) {
         success = true;
     }
+    if (!success) {
+        Performance_counters::add(Performance_counters::Counter::scpi_timeouts);
+    }
     return success;
 }
 
@@ -15,6 +15,8 @@
 #include "deviceworker.h"
 #include "identicon/identicon.h"
 #include "qt_util.h"
+#include "script_executor.h"
+#include "script_metadata_cache.h"
 #include "scriptengine.h"
 #include "testdescriptionloader.h"
 #include "testrunner.h"
@@ -317,6 +319,18 @@ MainWindow::MainWindow(QWidget *parent)
     devices_thread.start();
     connect(device_worker.get(), &DeviceWorker::device_discovery_done, this, &MainWindow::slot_device_discovery_done);
     refresh_devices(false);
+    script_thread_pool = std::make_unique<Thread_pool>();
+    script_update_timer.setSingleShot(true);
+    script_update_timer.setInterval(300); //editors tend to save in several steps, so wait until they are done
+    connect(&script_update_timer, &QTimer::timeout, this, &MainWindow::update_changed_scripts);
+    connect(&script_watcher, &QFileSystemWatcher::directoryChanged, [this](const QString &path) {
+        changed_script_directories.insert(path);
+        script_update_timer.start();
+    });
+    connect(&script_watcher, &QFileSystemWatcher::fileChanged, [this](const QString &path) {
+        changed_script_files.insert(path);
+        script_update_timer.start();
+    });
 
     showMaximized();
     QProgressDialog progress_bar{this};
@@ -389,11 +403,16 @@ void MainWindow::shutdown() {
     }
 
     QApplication::processEvents(); //process left over events
+    while (pending_script_loads > 0) { //script updates in the thread pool refer to the test descriptions and call into the gui thread
+        QApplication::processEvents(QEventLoop::AllEvents, 16);
+    }
 
     ui->test_tabs->clear();
     test_descriptions.clear();
     ui->test_simple_view->clear();
     test_runners.clear();
+    TestRunner::clear_warm_engines();
+    Script_executor::shutdown();
 
     devices_thread.quit();
     assert(not devices_thread.is_current());
@@ -432,7 +451,7 @@ namespace Script_loading_progress_factors {
     const int set_enable_state = 10;
 } // namespace Script_loading_progress_factors
 
-void MainWindow::load_scripts(QProgressDialog *dialog) {
+void MainWindow::load_scripts(QProgressDialog *dialog, bool use_cache) {
     assert(currently_in_gui_thread());
     std::unique_ptr<QProgressDialog> progress_bar;
     if (not dialog) {
@@ -454,41 +473,80 @@ void MainWindow::load_scripts(QProgressDialog *dialog) {
     statusBar()->showMessage(tr("Refreshing Scripts.."));
 
     dialog->setValue(dialog->value() + 1);
+    //script updates still running in the thread pool refer to the test descriptions
+    while (pending_script_loads > 0) {
+        QApplication::processEvents(QEventLoop::AllEvents, 16);
+    }
+    pending_script_loads++;
     test_descriptions.clear();
     dialog->setValue(dialog->value() + 1);
     const auto dir = QSettings{}.value(Globals::test_script_path_settings_key, "").toString();
-    std::optional<Thread_pool> othread_pool{std::in_place};
-    auto &thread_pool = othread_pool.value();
     std::mutex test_descriptions_mutex;
     std::vector<TestDescriptionLoader> new_test_descriptions;
     int tasks = 0;
     std::atomic<int> tasks_done = 0;
     luafiles.clear();
-    for (QDirIterator dit{dir, QStringList{} << "*.lua", QDir::Files, QDirIterator::Subdirectories}; dit.hasNext();) {
+    QStringList directories{dir};
+    QStringList script_paths;
+    for (QDirIterator dit{dir, QDir::Files | QDir::Dirs | QDir::NoDotAndDotDot, QDirIterator::Subdirectories}; dit.hasNext();) {
         auto file_path = dit.next();
-        const auto partial_path = file_path.right(partial_luafile_path_size);
-        luafiles[partial_path].push_back(std::move(file_path));
+        if (dit.fileInfo().isDir()) {
+            directories << std::move(file_path);
+        } else if (dit.fileInfo().suffix().compare("lua", Qt::CaseInsensitive) == 0) {
+            luafiles[file_path.right(partial_luafile_path_size)].push_back(file_path);
+            script_paths << std::move(file_path);
+        }
     }
-    for (QDirIterator dit{dir, QStringList{} << "*.lua", QDir::Files, QDirIterator::Subdirectories}; dit.hasNext();) {
-        auto file_path = dit.next();
-        thread_pool.push([&tasks_done, &test_descriptions_mutex, &new_test_descriptions, &dir, this, file_path = std::move(file_path)] {
-            auto return_value = TestDescriptionLoader{ui->tests_advanced_view, file_path, QDir{dir}.relativeFilePath(file_path)};
-            tasks_done++;
+    //validate all scripts that are not cached together instead of starting luacheck for every script
+    std::map<QString, QStringList> validation_messages;
+    std::map<QString, QString> validation_errors;
+    {
+        auto validation = std::async(std::launch::async, [&script_paths, use_cache, &validation_errors] {
+            QStringList uncached_script_paths;
+            auto &metadata_cache = Script_metadata_cache::get();
+            for (const auto &file_path : script_paths) {
+                if (not use_cache || not metadata_cache.find(file_path)) {
+                    uncached_script_paths << file_path;
+                }
+            }
+            return validate_scripts(uncached_script_paths, &validation_errors);
+        });
+        while (validation.wait_for(std::chrono::milliseconds(16)) == std::future_status::timeout) {
+            QApplication::processEvents();
+        }
+        validation_messages = validation.get();
+    }
+    for (const auto &file_path : script_paths) {
+        auto validation_it = validation_messages.find(file_path);
+        auto file_validation_messages = validation_it == std::end(validation_messages) ? std::nullopt : std::optional<QStringList>{validation_it->second};
+        auto validation_error_it = validation_errors.find(file_path);
+        auto file_validation_error = validation_error_it == std::end(validation_errors) ? QString{} : validation_error_it->second;
+        script_thread_pool->push([&tasks_done, &test_descriptions_mutex, &new_test_descriptions, &dir, this, file_path,
+                                  file_validation_messages = std::move(file_validation_messages), file_validation_error = std::move(file_validation_error),
+                                  use_cache] {
+            auto return_value = TestDescriptionLoader{ui->tests_advanced_view, file_path, QDir{dir}.relativeFilePath(file_path),
+                                                      std::move(file_validation_messages), use_cache, std::move(file_validation_error)};
             std::unique_lock l{test_descriptions_mutex};
             new_test_descriptions.push_back(std::move(return_value));
+            tasks_done++;
         });
         tasks++;
     }
     dialog->setMaximum(4 + tasks * (Script_loading_progress_factors::script_loading + Script_loading_progress_factors::favorite_loading +
                                     Script_loading_progress_factors::set_enable_state));
-    {
-        auto close_threads = std::async(std::launch::async, [&othread_pool] { othread_pool = std::nullopt; });
-        while (close_threads.wait_for(std::chrono::milliseconds(0)) == std::future_status::timeout) {
-            dialog->setValue(3 + tasks_done * Script_loading_progress_factors::script_loading);
-            QApplication::processEvents();
-        }
+    while (tasks_done < tasks) {
+        dialog->setValue(3 + tasks_done * Script_loading_progress_factors::script_loading);
+        QApplication::processEvents();
     }
-    std::swap(test_descriptions, new_test_descriptions);
+    {
+        //the last task may still hold the lock after counting itself as done
+        std::unique_lock l{test_descriptions_mutex};
+        std::swap(test_descriptions, new_test_descriptions);
+    }
+    pending_script_loads--;
+    Script_metadata_cache::get().save();
+    watch_script_directory(dir, directories, script_paths);
+    watch_required_files();
     load_favorites(dialog);
     statusBar()->clearMessage();
     ui->tbtn_refresh_scripts->setEnabled(enabled_a);
@@ -497,6 +555,207 @@ void MainWindow::load_scripts(QProgressDialog *dialog) {
     QApplication::processEvents();
 }
 
+void MainWindow::watch_script_directory(const QString &dir, const QStringList &directories, const QStringList &script_paths) {
+    assert(currently_in_gui_thread());
+    script_update_timer.stop();
+    changed_script_directories.clear();
+    changed_script_files.clear();
+    if (not script_watcher.files().isEmpty()) {
+        script_watcher.removePaths(script_watcher.files());
+    }
+    if (not script_watcher.directories().isEmpty()) {
+        script_watcher.removePaths(script_watcher.directories());
+    }
+    if (not QFileInfo{dir}.isDir()) {
+        return;
+    }
+    script_watcher.addPaths(directories);
+    if (not script_paths.isEmpty()) {
+        script_watcher.addPaths(script_paths);
+    }
+}
+
+void MainWindow::watch_required_files() {
+    assert(currently_in_gui_thread());
+    const auto watched = script_watcher.files();
+    std::set<QString> watched_files{std::begin(watched), std::end(watched)};
+    QStringList required_files;
+    for (const auto &test : test_descriptions) {
+        for (const auto &file : test.get_required_files()) {
+            if (watched_files.insert(file).second && QFileInfo::exists(file)) {
+                required_files << file;
+            }
+        }
+    }
+    if (not required_files.isEmpty()) {
+        script_watcher.addPaths(required_files);
+    }
+}
+
+void MainWindow::update_changed_scripts() {
+    assert(currently_in_gui_thread());
+    if (pending_script_loads > 0) { //test_descriptions must not change while scripts are loading, try again later
+        script_update_timer.start();
+        return;
+    }
+    const auto dir = QSettings{}.value(Globals::test_script_path_settings_key, "").toString();
+    std::set<QString> changed_directories;
+    std::set<QString> changed_files;
+    std::swap(changed_directories, changed_script_directories);
+    std::swap(changed_files, changed_script_files);
+
+    std::set<QString> known_scripts;
+    for (const auto &test : test_descriptions) {
+        known_scripts.insert(test.get_filepath());
+    }
+    const auto watched_directories = script_watcher.directories();
+    QStringList added_scripts;
+    QStringList removed_scripts;
+    QStringList new_directories;
+    for (const auto &directory : changed_directories) {
+        //only the changed directory is listed, new subdirectories are walked completely because they may have been copied with content
+        for (QDirIterator dit{directory, QDir::Files | QDir::Dirs | QDir::NoDotAndDotDot}; dit.hasNext();) {
+            auto path = dit.next();
+            if (dit.fileInfo().isDir()) {
+                if (not watched_directories.contains(path) && not new_directories.contains(path)) {
+                    new_directories << path;
+                    for (QDirIterator sub_dit{path, QDir::Files | QDir::Dirs | QDir::NoDotAndDotDot, QDirIterator::Subdirectories}; sub_dit.hasNext();) {
+                        auto sub_path = sub_dit.next();
+                        if (sub_dit.fileInfo().isDir()) {
+                            new_directories << std::move(sub_path);
+                        } else if (sub_dit.fileInfo().suffix().compare("lua", Qt::CaseInsensitive) == 0) {
+                            added_scripts << std::move(sub_path);
+                        }
+                    }
+                }
+            } else if (dit.fileInfo().suffix().compare("lua", Qt::CaseInsensitive) == 0 && known_scripts.count(path) == 0 &&
+                       not added_scripts.contains(path)) {
+                added_scripts << std::move(path);
+            }
+        }
+        //scripts of removed or renamed directories disappear without a notification for each file
+        for (const auto &script : known_scripts) {
+            if (script.startsWith(directory) && not QFileInfo::exists(script)) {
+                removed_scripts << script;
+            }
+        }
+    }
+    QStringList reloaded_scripts;
+    for (const auto &file : changed_files) {
+        //scripts that required the changed file run it when they load, so they are reloaded as well
+        for (const auto &test : test_descriptions) {
+            if (test.get_required_files().contains(file) && not reloaded_scripts.contains(test.get_filepath())) {
+                reloaded_scripts << test.get_filepath();
+            }
+        }
+        if (not QFileInfo::exists(file)) {
+            if (known_scripts.count(file) != 0 && not removed_scripts.contains(file)) {
+                removed_scripts << file;
+            }
+            continue;
+        }
+        //editors that save by replacing the file make the watcher forget it
+        script_watcher.addPath(file);
+        if (known_scripts.count(file) != 0 && not reloaded_scripts.contains(file)) {
+            reloaded_scripts << file;
+        }
+    }
+
+    for (const auto &script : removed_scripts) {
+        remove_test_description(script);
+    }
+    //the loaders stay in place because test_descriptions does not change until all tasks are done
+    std::vector<TestDescriptionLoader *> reloaded_tests;
+    for (auto &test : test_descriptions) {
+        if (reloaded_scripts.contains(test.get_filepath())) {
+            reloaded_tests.push_back(&test);
+        }
+    }
+    if (not new_directories.isEmpty()) {
+        script_watcher.addPaths(new_directories);
+    }
+    if (reloaded_tests.empty() && added_scripts.isEmpty()) {
+        if (not removed_scripts.isEmpty()) {
+            load_favorites();
+        }
+        return;
+    }
+
+    //loading runs the scripts, so it happens in the thread pool and the results are applied in the gui thread once all tasks are done
+    struct Script_update {
+        std::mutex added_tests_mutex;
+        std::vector<TestDescriptionLoader> added_tests;
+        int tasks_left = 0;
+    };
+    auto update = std::make_shared<Script_update>();
+    update->tasks_left = static_cast<int>(reloaded_tests.size()) + added_scripts.size();
+    pending_script_loads++;
+    auto task_done = [this, update] {
+        Utility::thread_call(this, [this, update] {
+            if (--update->tasks_left > 0) {
+                return;
+            }
+            for (auto &test : update->added_tests) {
+                add_test_description(std::move(test));
+            }
+            watch_required_files();
+            Script_metadata_cache::get().save();
+            pending_script_loads--;
+            load_favorites();
+        });
+    };
+    for (auto test : reloaded_tests) {
+        script_thread_pool->push([test, task_done] {
+            test->reload();
+            task_done();
+        });
+    }
+    for (const auto &script : added_scripts) {
+        script_thread_pool->push([this, update, task_done, script, display_name = QDir{dir}.relativeFilePath(script)] {
+            auto test = TestDescriptionLoader{ui->tests_advanced_view, script, display_name};
+            {
+                std::unique_lock l{update->added_tests_mutex};
+                update->added_tests.push_back(std::move(test));
+            }
+            task_done();
+        });
+    }
+}
+
+void MainWindow::add_test_description(TestDescriptionLoader &&test) {
+    assert(currently_in_gui_thread());
+    const auto &file_path = test.get_filepath();
+    luafiles[file_path.right(partial_luafile_path_size)].push_back(file_path);
+    script_watcher.addPath(file_path);
+    test_descriptions.push_back(std::move(test));
+}
+
+void MainWindow::remove_test_description(const QString &file_path) {
+    const auto luafile_it = luafiles.find(file_path.right(partial_luafile_path_size));
+    if (luafile_it != std::end(luafiles)) {
+        auto &paths = luafile_it->second;
+        paths.erase(std::remove(std::begin(paths), std::end(paths), file_path), std::end(paths));
+        if (paths.empty()) {
+            luafiles.erase(luafile_it);
+        }
+    }
+    const auto test_it =
+        std::find_if(std::begin(test_descriptions), std::end(test_descriptions), [&file_path](const auto &test) { return test.get_filepath() == file_path; });
+    if (test_it == std::end(test_descriptions)) {
+        return;
+    }
+    auto folder = test_it->ui_entry ? test_it->ui_entry->parent() : nullptr;
+    test_descriptions.erase(test_it);
+    //remove folders that became empty
+    while (folder && folder->childCount() == 0) {
+        auto parent = folder->parent();
+        delete folder;
+        folder = parent;
+    }
+    Script_metadata_cache::get().remove(file_path);
+    script_watcher.removePath(file_path);
+}
+
 void MainWindow::load_favorites(QProgressDialog *dialog) {
     assert(currently_in_gui_thread());
     ui->test_simple_view->clear();
@@ -664,14 +923,26 @@ void MainWindow::show_status_bar_massage(QString msg, int timeout_ms) {
 }
 
 QStringList MainWindow::validate_script(const QString &path) {
+    std::map<QString, QString> errors;
+    auto messages = validate_scripts(QStringList{} << path, &errors);
+    if (messages.count(path) == 0) {
+        throw std::runtime_error{errors[path].toStdString()};
+    }
+    return messages[path];
+}
+
+std::map<QString, QStringList> MainWindow::validate_scripts(const QStringList &paths, std::map<QString, QString> *errors) {
+    std::map<QString, QStringList> messages;
+    for (const auto &path : paths) {
+        messages[path];
+    }
     auto luachecker_path = QSettings{}.value(Globals::path_to_luacheck_key, "").toString();
-    if (luachecker_path.isEmpty()) {
-        return {};
+    if (luachecker_path.isEmpty() || paths.isEmpty()) {
+        return messages;
     }
     const static QStringList luacheck_args = [] {
         QStringList l;
-        l << ""
-          << "-d"
+        l << "-d"
           << "--std"
           << "none"
           << "--no-max-line-length"
@@ -700,29 +971,84 @@ QStringList MainWindow::validate_script(const QString &path) {
         return l;
     }();
 
-    auto args = luacheck_args;
-    args[0] = path;
-
-    QProcess luachecker;
-    luachecker.setProgram(luachecker_path);
-    luachecker.setArguments(args);
-    luachecker.start(QProcess::OpenMode::enum_type::ReadOnly);
-    luachecker.closeWriteChannel();
-    QStringList messages;
-    luachecker.waitForFinished();
-    auto output = luachecker.readAllStandardOutput();
-    auto output_list = output.replace("\r\n", "\n").split('\n');
-    for (const auto &line : output_list) {
-        if (line.isEmpty()) {
-            continue;
+    //luacheck checks many files per invocation, the batches are small enough to keep the command line short and to use all cores
+    const int max_batch_size = 50;
+    const int process_count = std::max(1, QThread::idealThreadCount());
+    const int batch_size = std::clamp((paths.size() + process_count - 1) / process_count, 1, max_batch_size);
+    std::vector<std::pair<QStringList, std::unique_ptr<QProcess>>> batches;
+    for (int batch_start = 0; batch_start < paths.size(); batch_start += batch_size) {
+        batches.emplace_back(paths.mid(batch_start, batch_size), std::make_unique<QProcess>());
+    }
+    const int luacheck_timeout_ms = 60 * 1000;
+    auto get_luacheck_error = [](QProcess &luachecker) -> QString {
+        if (not luachecker.waitForFinished(luacheck_timeout_ms)) {
+            if (luachecker.error() == QProcess::Timedout) {
+                luachecker.kill();
+                luachecker.waitForFinished();
+                return tr("Luacheck did not finish within %1 seconds").arg(luacheck_timeout_ms / 1000);
+            }
+            return tr("Failed running luacheck: %1").arg(luachecker.errorString());
         }
-        if (line.contains("unused global variable 'device_requirements'")) {
-            continue;
+        if (luachecker.exitStatus() != QProcess::NormalExit) {
+            return tr("Luacheck crashed");
         }
-        if (line.contains("unused global variable 'run'")) {
-            continue;
+        //exit codes 0 to 2 mean the files were checked and had no warnings, warnings or syntax errors, higher codes mean they were not checked
+        if (luachecker.exitCode() > 2) {
+            return tr("Luacheck failed with exit code %1: %2").arg(luachecker.exitCode()).arg(QString::fromUtf8(luachecker.readAllStandardError()).trimmed());
+        }
+        return {};
+    };
+    auto collect_messages = [&messages, &errors, &get_luacheck_error](const QStringList &batch, QProcess &luachecker) {
+        if (const auto error = get_luacheck_error(luachecker); not error.isEmpty()) {
+            for (const auto &path : batch) {
+                messages.erase(path);
+                if (errors) {
+                    (*errors)[path] = error;
+                }
+            }
+            return;
         }
-        messages << line;
+        auto output = luachecker.readAllStandardOutput();
+        auto output_list = output.replace("\r\n", "\n").split('\n');
+        for (const auto &output_line : output_list) {
+            const auto line = QString::fromUtf8(output_line);
+            if (line.isEmpty()) {
+                continue;
+            }
+            if (line.contains("unused global variable 'device_requirements'")) {
+                continue;
+            }
+            if (line.contains("unused global variable 'run'")) {
+                continue;
+            }
+            //messages start with the path of the file as it was passed to luacheck, the longest match wins in case one path is a prefix of another
+            const QString *file = nullptr;
+            for (const auto &path : batch) {
+                if (line.startsWith(path + ':') && (file == nullptr || path.size() > file->size())) {
+                    file = &path;
+                }
+            }
+            if (file == nullptr) {
+                qDebug() << "Failed assigning luacheck message to a script" << line;
+                continue;
+            }
+            messages[*file] << line;
+        }
+    };
+    std::size_t next_to_start = 0;
+    std::size_t next_to_collect = 0;
+    while (next_to_collect < batches.size()) {
+        //the files go first because --globals consumes all following arguments
+        while (next_to_start < batches.size() && next_to_start < next_to_collect + static_cast<std::size_t>(process_count)) {
+            auto &[batch_paths, process] = batches[next_to_start++];
+            process->setProgram(luachecker_path);
+            process->setArguments(batch_paths + luacheck_args);
+            process->start(QProcess::OpenMode::enum_type::ReadOnly);
+            process->closeWriteChannel();
+        }
+        auto &[batch, luachecker] = batches[next_to_collect++];
+        collect_messages(batch, *luachecker);
+        luachecker.reset();
     }
     return messages;
 }
@@ -1094,7 +1420,10 @@ void MainWindow::on_tests_advanced_view_customContextMenuRequested(const QPoint
         menu.addAction(&action_run);
 
         QAction action_reload(tr("Reload"));
-        connect(&action_reload, &QAction::triggered, [test] { test->reload(); });
+        connect(&action_reload, &QAction::triggered, [this, test] {
+            changed_script_files.insert(test->get_filepath());
+            update_changed_scripts();
+        });
         menu.addAction(&action_reload);
 
         QAction action(tr("Reload all scripts"));
@@ -1131,7 +1460,7 @@ void MainWindow::on_tests_advanced_view_customContextMenuRequested(const QPoint
 }
 
 void MainWindow::on_tbtn_refresh_scripts_clicked() {
-    load_scripts();
+    load_scripts(nullptr, false);
 }
 
 void MainWindow::on_actionReload_All_Scripts_triggered() {
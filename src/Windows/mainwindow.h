@@ -7,15 +7,18 @@
 #include "qt_util.h"
 
 #include <QDebug>
+#include <QFileSystemWatcher>
 #include <QListWidgetItem>
 #include <QMainWindow>
 #include <QMessageBox>
 #include <QMutex>
 #include <QThread>
+#include <QTimer>
 #include <QTreeWidgetItem>
 #include <QtSerialPort/QSerialPortInfo>
 #include <map>
 #include <memory>
+#include <set>
 #include <string>
 #include <vector>
 
@@ -27,6 +30,7 @@ class QSplitter;
 class QString;
 class QTreeWidget;
 class TestDescriptionLoader;
+struct Thread_pool;
 class UI_container;
 struct Protocol;
 class TestRunner;
@@ -80,7 +84,11 @@ class EXPORT MainWindow : public QMainWindow {
     void set_testrunner_state(TestRunner *testrunner, TestRunner_State state);
     void adopt_testrunner(TestRunner *testrunner, QString title);
     void show_status_bar_massage(QString msg, int timeout_ms);
+    //throws if luacheck could not check the script
     static QStringList validate_script(const QString &path);
+    //runs luacheck on all paths in parallel batches and returns the messages of each path
+    //paths luacheck failed to check are left out of the result and their error is stored in errors
+    static std::map<QString, QStringList> validate_scripts(const QStringList &paths, std::map<QString, QString> *errors = nullptr);
 
     public slots:
     void link_activated(const QString &path);
@@ -92,7 +100,8 @@ class EXPORT MainWindow : public QMainWindow {
 
     private slots:
     void slot_device_discovery_done();
-    void load_scripts(QProgressDialog *dialog = nullptr);
+    //use_cache = false checks and loads all scripts again instead of using the Script_metadata_cache
+    void load_scripts(QProgressDialog *dialog = nullptr, bool use_cache = true);
     void poll_sg04_counts();
     void closeEvent(QCloseEvent *event) override;
 
@@ -130,6 +139,9 @@ class EXPORT MainWindow : public QMainWindow {
     FavoriteScripts favorite_scripts;
     void refresh_devices(bool only_duts);
     std::vector<TestDescriptionLoader> test_descriptions;
+    //loads and reloads test descriptions, test_descriptions must not change while pending_script_loads is not 0
+    std::unique_ptr<Thread_pool> script_thread_pool;
+    int pending_script_loads = 0;
     std::vector<std::unique_ptr<TestRunner>> test_runners;
 
     std::unique_ptr<DeviceWorker> device_worker;
@@ -151,6 +163,17 @@ class EXPORT MainWindow : public QMainWindow {
     TestDescriptionLoader *get_test_from_listViewItem(QListWidgetItem *item);
     TestDescriptionLoader *get_test_from_tree_widget(const QTreeWidgetItem *item = nullptr);
     void load_favorites(QProgressDialog *dialog = nullptr);
+    //changes below the script directory are collected by the watcher and applied together once the timer expires
+    void watch_script_directory(const QString &dir, const QStringList &directories, const QStringList &script_paths);
+    //library files the scripts require may be outside of the script directory, a change reloads the scripts that require them
+    void watch_required_files();
+    void update_changed_scripts();
+    void add_test_description(TestDescriptionLoader &&test);
+    void remove_test_description(const QString &file_path);
+    QFileSystemWatcher script_watcher;
+    QTimer script_update_timer;
+    std::set<QString> changed_script_directories;
+    std::set<QString> changed_script_files;
     void enable_favorite_view();
     void enable_all_script_view();
     ViewMode view_mode_m;
@@ -34,6 +34,9 @@ namespace Globals {
     static const auto report_history_query_path = "report_history_query_path";
     static const auto recent_report_history_query_paths = "recent_report_history_query_paths";
     static const auto recent_plot_export_path = "recent_plot_export_path";
+    static const auto cooperative_script_execution_key = "cooperative_script_execution";
+    static const auto script_executor_thread_count_key = "script_executor_thread_count";
+    static const auto console_flood_message_limit_key = "console_flood_message_limit";
 
     static const auto ui_blink_ratio = 16777215;
 } // namespace Globals
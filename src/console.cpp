@@ -1,15 +1,91 @@
 #include "console.h"
 #include "Windows/mainwindow.h"
+#include "config.h"
 #include "util.h"
 
 #include <QFileInfo>
 #include <QPlainTextEdit>
+#include <QSettings>
 #include <QTime>
+#include <cassert>
+#include <deque>
+#include <map>
+#include <mutex>
 #include <regex>
 #include <tuple>
 #include <utility>
 
 QPlainTextEdit *Console_handle::console = nullptr;
+std::function<void(QPlainTextEdit *console, const QString &text)> Console_handle::headless_output;
+
+namespace {
+    //Messages are collected per console and handed to the GUI thread in batches. Only the first message of a batch posts an event, all following
+    //messages are appended to the pending queue until the GUI thread drained it. This keeps chatty scripts from flooding the event queue.
+    struct Console_sink {
+        static constexpr std::size_t max_pending_messages = 1000;
+        static constexpr int default_flood_message_limit = 10000;
+
+        void push(QPlainTextEdit *console, QString text) {
+            bool drain_scheduled;
+            {
+                std::lock_guard<std::mutex> lock{mutex};
+                auto &queue = queues[console];
+                drain_scheduled = !queue.messages.empty() || queue.dropped_messages;
+                if (queue.messages.size() >= max_pending_messages) {
+                    queue.messages.pop_front();
+                    queue.dropped_messages++;
+                }
+                queue.messages.push_back(std::move(text));
+            }
+            if (!drain_scheduled) {
+                Utility::thread_call(MainWindow::mw, [this, console] { drain(console); });
+            }
+        }
+
+        private:
+        struct Queue {
+            std::deque<QString> messages;
+            std::size_t dropped_messages = 0;
+        };
+
+        void drain(QPlainTextEdit *console) {
+            Queue queue;
+            {
+                std::lock_guard<std::mutex> lock{mutex};
+                auto it = queues.find(console);
+                if (it == std::end(queues)) {
+                    return;
+                }
+                queue = std::move(it->second);
+                queues.erase(it);
+            }
+            assert(currently_in_gui_thread());
+            if (console->parent()) {
+                console->setVisible(true);
+            }
+            //one block per message, so the block limit limits messages and a flooded console stops growing. Consoles that already have a
+            //lower limit keep it, so the limit is set at most once per console.
+            static const int flood_message_limit = QSettings{}.value(Globals::console_flood_message_limit_key, default_flood_message_limit).toInt();
+            if (flood_message_limit > 0 && (console->maximumBlockCount() == 0 || console->maximumBlockCount() > flood_message_limit)) {
+                console->setMaximumBlockCount(flood_message_limit);
+            }
+            QString html;
+            if (queue.dropped_messages) {
+                html += "<div><font color=\"#" + QString::number(QColor("orangered").rgb(), 16) + "\"><plaintext>" +
+                        QTime::currentTime().toString(Qt::ISODate) + ": Warning: " + QString::number(queue.dropped_messages) +
+                        " console messages were dropped because the console could not keep up.</plaintext></font></div>";
+            }
+            //the whole batch is appended at once because every append lays out the document again
+            for (const auto &message : queue.messages) {
+                html += "<div>" + message + "</div>";
+            }
+            console->appendHtml(html);
+        }
+
+        std::mutex mutex;
+        std::map<QPlainTextEdit *, Queue> queues;
+    } console_sink;
+} // namespace
 
 Console_handle::ConsoleProxy Console_handle::warning(QPlainTextEdit *console) {
     return {console ? console : Console_handle::console, QStringList{}, "Warning", QColor("orangered")};
@@ -96,18 +172,21 @@ Console_handle::ConsoleProxy::~ConsoleProxy() {
     if (state.s.isEmpty()) {
         return;
     }
+    if (headless_output) {
+        headless_output(state.console, QTime::currentTime().toString(Qt::ISODate) + ": " + state.prefix + ": " +
+                                           Utility::to_human_readable_binary_data(state.s.join("")));
+        return;
+    }
     QString s_br = Utility::to_human_readable_binary_data(state.s.join(""));
     s_br = s_br.replace("\n", "<br>");
     auto text = state.fat ? "<font color=\"#" + QString::number(state.color.rgb(), 16) + "\"><plaintext>" + QTime::currentTime().toString(Qt::ISODate) + ": " +
                                 state.prefix + ": </plaintext><b><plaintext>" + s_br + "</plaintext></b></font>\n" :
                             "<font color=\"#" + QString::number(state.color.rgb(), 16) + "\"><plaintext>" + QTime::currentTime().toString(Qt::ISODate) + ": " +
                                 state.prefix + ": " + s_br + "</plaintext></font>\n";
-    Utility::thread_call(MainWindow::mw, [text = std::move(text), console = this->state.console] {
-        if (console->parent()) {
-            console->setVisible(true);
-        }
-        MainWindow::mw->append_html_to_console(text, console);
-    });
+    if (state.console == nullptr) {
+        return;
+    }
+    console_sink.push(state.console, std::move(text));
 }
 
 void Console_handle::ConsoleProxy::linkify_print(std::string line) {
@@ -3,6 +3,7 @@
 
 #include <QColor>
 #include <QStringList>
+#include <functional>
 #include <memory>
 #include <sstream>
 #include <string>
@@ -51,6 +52,8 @@ struct Console_handle {
 
     public:
     static QPlainTextEdit *console;
+    //when set, messages are passed to this function as plain text instead of being shown in a console widget, used for headless runs
+    static std::function<void(QPlainTextEdit *console, const QString &text)> headless_output;
     static ConsoleProxy warning(QPlainTextEdit *console = nullptr);
     static ConsoleProxy note(QPlainTextEdit *console = nullptr);
     static ConsoleProxy error(QPlainTextEdit *console = nullptr);
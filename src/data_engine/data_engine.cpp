@@ -9,12 +9,16 @@
 #include "communication_logger/communication_logger.h"
 #include "console.h"
 #include "exceptionalapproval.h"
+#include "performance_counters.h"
+#include "tracing.h"
 #include "util.h"
 #include "vc.h"
 
 #include <QApplication>
 #include <QBuffer>
 #include <QByteArray>
+#include <QCryptographicHash>
+#include <QDataStream>
 #include <QDateTime>
 #include <QDebug>
 #include <QDesktopServices>
@@ -24,6 +28,7 @@
 #include <QJsonDocument>
 #include <QJsonObject>
 #include <QMessageBox>
+#include <QMutex>
 #include <QObject>
 #include <QPainter>
 #include <QPrinter>
@@ -38,6 +43,7 @@
 #include <QWidget>
 #include <QXmlStreamWriter>
 #include <algorithm>
+#include <atomic>
 #include <cassert>
 #include <cmath>
 #include <iostream>
@@ -112,6 +118,61 @@ void Data_engine::set_dependancy_tags(const QMap<QString, QList<QVariant>> &tags
     sections.is_dummy_data_mode = false;
 }
 
+namespace {
+    //Sections of recently loaded sources after the variants were selected. Loading the same desired values with the same dependency tags again,
+    //which happens for every DUT, copies them instead of parsing the JSON file again.
+    class Prototype_cache {
+        public:
+        std::shared_ptr<const DataEngineSections> find(const QByteArray &key) {
+            QMutexLocker lock{&mutex};
+            for (auto it = std::begin(entries); it != std::end(entries); ++it) {
+                if (it->first == key) {
+                    std::rotate(it, it + 1, std::end(entries));
+                    return entries.back().second;
+                }
+            }
+            return nullptr;
+        }
+        void insert(const QByteArray &key, std::shared_ptr<const DataEngineSections> prototype) {
+            QMutexLocker lock{&mutex};
+            if (entries.size() >= max_entries) {
+                entries.erase(std::begin(entries));
+            }
+            entries.emplace_back(key, std::move(prototype));
+        }
+        void clear() {
+            QMutexLocker lock{&mutex};
+            entries.clear();
+        }
+        std::atomic<bool> enabled{true};
+
+        private:
+        static constexpr std::size_t max_entries = 4;
+        QMutex mutex;
+        std::vector<std::pair<QByteArray, std::shared_ptr<const DataEngineSections>>> entries; //least recently used first
+    };
+} // namespace
+
+//the counters of run, or the process wide counters for a data engine that was not loaded by a test run
+static Performance_counters::Snapshot get_performance_counters_snapshot(const Performance_counters::Run_context &run) {
+    return run ? Performance_counters::get_snapshot(run) : Performance_counters::get_snapshot();
+}
+
+static Prototype_cache &get_prototype_cache() {
+    static Prototype_cache prototype_cache;
+    return prototype_cache;
+}
+
+static QByteArray get_prototype_key(const QByteArray &source, const QMap<QString, QList<QVariant>> &tags, bool is_dummy_data_mode) {
+    QByteArray serialised_tags;
+    QDataStream stream{&serialised_tags, QIODevice::WriteOnly};
+    stream << tags << is_dummy_data_mode;
+    QCryptographicHash hash{QCryptographicHash::Sha1};
+    hash.addData(source);
+    hash.addData(serialised_tags);
+    return hash.result();
+}
+
 void Data_engine::set_source(std::istream &source) {
     QByteArray data;
     constexpr auto eof = std::remove_reference<decltype(source)>::type::traits_type::eof();
@@ -123,6 +184,35 @@ void Data_engine::set_source(std::istream &source) {
         data.push_back(character);
     }
 
+    auto &prototype_cache = get_prototype_cache();
+    if (not prototype_cache.enabled) {
+        load_sections(std::move(data));
+    } else {
+        const QByteArray prototype_key = get_prototype_key(data, sections.get_dependancy_tags(), sections.is_dummy_data_mode);
+        if (const auto prototype = prototype_cache.find(prototype_key)) {
+            sections.clone_from(*prototype);
+        } else {
+            load_sections(std::move(data));
+            auto new_prototype = std::make_shared<DataEngineSections>();
+            new_prototype->clone_from(sections);
+            prototype_cache.insert(prototype_key, std::move(new_prototype));
+        }
+    }
+
+    load_time_seconds_since_epoch = QDateTime::currentMSecsSinceEpoch() / 1000;
+    performance_counters_run = Performance_counters::current_run();
+    load_time_performance_counters = get_performance_counters_snapshot(performance_counters_run);
+}
+
+void Data_engine::set_prototype_cache_enabled(bool enabled) {
+    get_prototype_cache().enabled = enabled;
+}
+
+void Data_engine::clear_prototype_cache() {
+    get_prototype_cache().clear();
+}
+
+void Data_engine::load_sections(QByteArray data) {
     const auto document = QJsonDocument::fromJson(std::move(data));
     if (!document.isObject()) {
         throw DataEngineError(DataEngineErrorNumber::invalid_json_file,
@@ -145,8 +235,6 @@ void Data_engine::set_source(std::istream &source) {
             (void)entry_type;
         }
     }
-
-    load_time_seconds_since_epoch = QDateTime::currentMSecsSinceEpoch() / 1000;
 }
 
 void Data_engine::set_script_path(QString script_path) {
@@ -180,9 +268,12 @@ void Data_engine::set_start_time_seconds_since_epoch(double start_seconds_since_
     this->load_time_seconds_since_epoch = static_cast<qint64>(start_seconds_since_epoch);
 }
 
-DataEngineSections::DataEngineSections() {}
+DataEngineSections::DataEngineSections() {
+    new_generation();
+}
 
 void DataEngineSections::delete_unmatched_variants() {
+    new_generation();
     if (is_dummy_data_mode) {
         for (auto &section : sections) {
             section.delete_all_but_biggest_variants();
@@ -196,24 +287,31 @@ void DataEngineSections::delete_unmatched_variants() {
 
 void DataEngineSections::deref_references() {
     for (auto &section : sections) {
-        for (auto &instance : section.instances) {
-            if (instance.variants.size() == 0) {
-                continue;
-            }
-            const VariantData *variant_to_test = instance.get_variant();
-            for (const auto &entry : variant_to_test->data_entries) {
-                ReferenceDataEntry *reference = entry.get()->as<ReferenceDataEntry>();
-                if (reference) {
-                    reference->dereference(this, is_dummy_data_mode);
-                }
+        deref_references_of_section(section);
+    }
+}
+
+void DataEngineSections::deref_references_of_section(DataEngineSection &section) {
+    for (auto &instance : section.instances) {
+        if (instance.variants.size() == 0) {
+            continue;
+        }
+        const VariantData *variant_to_test = instance.get_variant();
+        for (const auto &entry : variant_to_test->data_entries) {
+            ReferenceDataEntry *reference = entry.get()->as<ReferenceDataEntry>();
+            if (reference) {
+                reference->dereference(this, is_dummy_data_mode);
             }
         }
     }
 }
 
 void DataEngineSections::set_instance_count(QString instance_count_name, uint instance_count) {
+    new_generation();
     bool instance_count_name_found = false;
-    for (auto &section : sections) {
+    std::vector<bool> needs_deref(sections.size(), false);
+    for (std::size_t i = 0; i < sections.size(); i++) {
+        auto &section = sections[i];
         if (section.set_instance_count_if_name_matches(instance_count_name, instance_count)) {
             if (is_dummy_data_mode) {
                 section.delete_all_but_biggest_variants();
@@ -221,9 +319,18 @@ void DataEngineSections::set_instance_count(QString instance_count_name, uint in
                 section.delete_unmatched_variants(dependency_tags);
             }
             instance_count_name_found = true;
+            //the references of this section are new copies and the ones pointing into it have new targets
+            needs_deref[i] = true;
+            for (const auto referencing_section : referencing_sections.value(section.get_section_name().toLower())) {
+                needs_deref[referencing_section] = true;
+            }
+        }
+    }
+    for (std::size_t i = 0; i < sections.size(); i++) {
+        if (needs_deref[i]) {
+            deref_references_of_section(sections[i]);
         }
     }
-    deref_references();
     if (instance_count_name_found == false) {
         throw DataEngineError(DataEngineErrorNumber::instance_count_does_not_exist,
                               QString("Dataengine: Could not find instance count name:\"%1\"").arg(instance_count_name));
@@ -238,10 +345,12 @@ void DataEngineSections::use_instance(QString section_name, QString instance_cap
         throw DataEngineError(DataEngineErrorNumber::no_section_id_found, QString("Dataengine: Could not find section with name = \"%1\"").arg(section_name));
     }
     assert(section_to_use);
+    new_generation();
     section_to_use->use_instance(instance_caption, instance_index);
 }
 
 void DataEngineSections::create_already_defined_instances() {
+    new_generation();
     for (auto &section : sections) {
         section.create_instances_if_defined();
         if (section.is_section_instance_defined()) {
@@ -272,15 +381,15 @@ DataEngineSection *DataEngineSections::get_section_no_exception(FormID id) const
 DecodecFieldID DataEngineSections::decode_field_id(const FormID &id) {
     DecodecFieldID result;
 
-    auto names = id.split("/");
-    if (names.count() != 2) {
+    const int separator = id.indexOf('/');
+    if ((separator < 0) || (id.indexOf('/', separator + 1) >= 0)) {
         throw DataEngineError(DataEngineErrorNumber::faulty_field_id, QString("Dataengine: field id needs to be in format "
                                                                               "\"section-name/field-name\" but is %1")
                                                                           .arg(id));
     }
 
-    result.section_name = names[0];
-    result.field_name = names[1];
+    result.section_name = id.left(separator);
+    result.field_name = id.mid(separator + 1);
     return result;
 }
 
@@ -292,19 +401,36 @@ const QMap<QString, QList<QVariant>> &DataEngineSections::get_dependancy_tags()
     return dependency_tags;
 }
 
+quint64 DataEngineSections::get_generation() const {
+    return generation;
+}
+
+void DataEngineSections::clone_from(const DataEngineSections &prototype) {
+    std::vector<DataEngineSection> copied_sections{prototype.sections};
+    sections.swap(copied_sections);
+    section_index = prototype.section_index;
+    referencing_sections = prototype.referencing_sections;
+    dependency_tags = prototype.dependency_tags;
+    is_dummy_data_mode = prototype.is_dummy_data_mode;
+    new_generation();
+    deref_references();
+}
+
+void DataEngineSections::new_generation() {
+    //unique across all data engines so a field can never mistake another data engine's sections for the ones it was resolved in
+    static std::atomic<quint64> last_generation{0};
+    generation = ++last_generation;
+}
+
 DataEngineSection *DataEngineSections::get_section_raw(const QString &section_name, DataEngineErrorNumber *error_num) const {
-    const DataEngineSection *result = nullptr;
     *error_num = DataEngineErrorNumber::ok;
-    for (auto &section : sections) {
-        if (section.get_section_name().toLower() == section_name.toLower()) {
-            assert(result == nullptr); // there should only be one section with this name
-            result = &section;
-        }
-    }
-    if (result == nullptr) {
+    const auto it = section_index.constFind(section_name.toLower());
+    if (it == section_index.constEnd()) {
         *error_num = DataEngineErrorNumber::no_section_id_found;
+        return nullptr;
     }
-    return const_cast<DataEngineSection *>(result);
+    assert(it.value() < sections.size());
+    return const_cast<DataEngineSection *>(&sections[it.value()]);
 }
 
 QList<const DataEngineDataEntry *> DataEngineSections::get_entries_raw(const FormID &id, DataEngineErrorNumber *error_num, DecodecFieldID &decoded_field_name,
@@ -334,12 +460,19 @@ QList<const DataEngineDataEntry *> DataEngineSections::get_entries_raw(const For
                     result.append(item);
                 }
             }
-        } else {
-            for (uint index = 0; index < section->instances.size(); index++) {
-                auto &instance = section->instances[index];
-                if (using_instance_index && (index != section->get_actual_instance_index())) {
-                    continue;
+        } else if (using_instance_index) {
+            const uint index = section->get_actual_instance_index();
+            if (index < section->instances.size()) {
+                const VariantData *variant = section->instances[index].get_variant();
+                assert(variant);
+                DataEngineErrorNumber error_num_dummy;
+                const DataEngineDataEntry *item = variant->get_entry_raw(decoded_field_name.field_name, &error_num_dummy);
+                if (item) {
+                    result.append(item);
                 }
+            }
+        } else {
+            for (auto &instance : section->instances) {
                 const VariantData *variant = instance.get_variant();
                 assert(variant);
                 DataEngineErrorNumber error_num_dummy;
@@ -460,6 +593,7 @@ bool DataEngineSections::all_values_in_range() const {
 }
 
 void DataEngineSections::from_json(const QJsonObject &object) {
+    new_generation();
     for (const auto &key : object.keys()) {
         if (is_comment_key(key)) {
             continue;
@@ -474,8 +608,58 @@ void DataEngineSections::from_json(const QJsonObject &object) {
             throw DataEngineError(DataEngineErrorNumber::duplicate_section, QString("Dataengine: duplicate section %1").arg(section.get_section_name()));
         }
 
+        section_index.insert(section.get_section_name().toLower(), sections.size());
         sections.push_back(std::move(section));
     }
+    build_reference_graph();
+}
+
+//depth first search along the reference links, a link back to a field whose links are still being followed closes a cycle
+static void check_reference_cycles(const QHash<QString, QStringList> &reference_links, const QString &field_id, QHash<QString, bool> &finished,
+                                   QStringList &path) {
+    if (finished.value(field_id, false)) {
+        return;
+    }
+    if (path.contains(field_id)) {
+        throw DataEngineError(DataEngineErrorNumber::reference_cycle, QString("Dataengine: references form a cycle: %1")
+                                                                          .arg((path.mid(path.indexOf(field_id)) << field_id).join(" -> ")));
+    }
+    path.append(field_id);
+    for (const auto &link : reference_links.value(field_id)) {
+        check_reference_cycles(reference_links, link, finished, path);
+    }
+    path.removeLast();
+    finished.insert(field_id, true);
+}
+
+void DataEngineSections::build_reference_graph() {
+    referencing_sections.clear();
+    QHash<QString, QStringList> reference_links;
+    for (std::size_t i = 0; i < sections.size(); i++) {
+        const auto &section = sections[i];
+        for (const auto &variant : section.prototype_instance.variants) {
+            for (const auto &entry : variant.data_entries) {
+                const ReferenceDataEntry *reference = entry->as<ReferenceDataEntry>();
+                if (reference == nullptr) {
+                    continue;
+                }
+                QStringList &links = reference_links[section.get_section_name().toLower() + "/" + reference->field_name.toLower()];
+                for (const auto &reference_link : reference->reference_links) {
+                    const QString link = reference_link.link.toLower();
+                    links.append(link);
+                    auto &referencing = referencing_sections[link.section('/', 0, 0)];
+                    if (std::find(std::begin(referencing), std::end(referencing), i) == std::end(referencing)) {
+                        referencing.push_back(i);
+                    }
+                }
+            }
+        }
+    }
+    QHash<QString, bool> finished;
+    for (auto it = reference_links.constBegin(); it != reference_links.constEnd(); ++it) {
+        QStringList path;
+        check_reference_cycles(reference_links, it.key(), finished, path);
+    }
 }
 
 QStringList DataEngineSection::get_all_ids_over_variants() const {
@@ -498,7 +682,7 @@ EntryType DataEngineSections::get_entry_type_dummy_mode_recursion(const FormID &
     }
 
     const DataEngineDataEntry *entry = data_entries_for_each_variant[0];
-    const ReferenceDataEntry *referece_entry = dynamic_cast<const ReferenceDataEntry *>(entry);
+    const ReferenceDataEntry *referece_entry = entry->as<ReferenceDataEntry>();
     EntryType result_type{EntryType::Unspecified};
     if (referece_entry) {
         bool first = true;
@@ -543,20 +727,20 @@ bool DataEngineSections::section_exists(QString section_name) {
 }
 
 void DataEngineSection::delete_unmatched_variants(const QMap<QString, QList<QVariant>> &tags) {
+    entry_status_counts.invalidate();
     int instance_index = 0;
     for (DataEngineInstance &instance : instances) {
         assert((bool)instance_count);
-        instance.delete_unmatched_variants(tags, instance_index, instance_count.value());
+        instance.select_matching_variant(prototype_instance, tags, instance_index, instance_count.value());
         instance_index++;
     }
 }
 
 void DataEngineSection::delete_all_but_biggest_variants() {
-    int instance_index = 0;
+    entry_status_counts.invalidate();
     for (auto &instance : instances) {
         assert(instance_count);
-        instance.delete_all_but_biggest_variants();
-        instance_index++;
+        instance.select_biggest_variant(prototype_instance);
     }
 }
 
@@ -568,12 +752,20 @@ DataEngineInstance::DataEngineInstance(const DataEngineInstance &other)
     , section_name{other.section_name}
     , allow_empty_section{other.allow_empty_section} {}
 
-DataEngineInstance::DataEngineInstance(DataEngineInstance &&other)
+DataEngineInstance::DataEngineInstance(DataEngineInstance &&other) noexcept
     : variants(std::move(other.variants))
     , instance_caption{std::move(other.instance_caption)}
     , section_name{std::move(other.section_name)}
     , allow_empty_section{other.allow_empty_section} {}
 
+DataEngineInstance DataEngineInstance::copy_without_variants() const {
+    DataEngineInstance instance;
+    instance.instance_caption = instance_caption;
+    instance.section_name = section_name;
+    instance.allow_empty_section = allow_empty_section;
+    return instance;
+}
+
 const VariantData *DataEngineInstance::get_variant() const {
     if (variants.size() == 1) {
         return &variants[0];
@@ -584,54 +776,48 @@ const VariantData *DataEngineInstance::get_variant() const {
                                                                        .arg(section_name));
 }
 
-void DataEngineInstance::delete_unmatched_variants(const QMap<QString, QList<QVariant>> &tags, uint instance_index, uint instance_count) {
-    std::vector<VariantData> variants_new;
-
-    for (auto &variant : variants) {
+void DataEngineInstance::select_matching_variant(DataEngineInstance &prototype, const QMap<QString, QList<QVariant>> &tags, uint instance_index,
+                                                 uint instance_count) {
+    std::vector<const VariantData *> matching_variants;
+    for (auto &variant : prototype.variants) {
         if (variant.is_dependency_matching(tags, instance_index, instance_count, section_name)) {
-            variants_new.push_back(std::move(variant));
-            // i++;
+            matching_variants.push_back(&variant);
         }
     }
-    variants = std::move(variants_new);
-    if (variants.size() > 1) {
-        throw DataEngineError(DataEngineErrorNumber::non_unique_desired_field_found, QString("Dataengine: More than one dependency fullfilling variants "
-                                                                                             "(%1) found in section: \"%2\"")
-                                                                                         .arg(variants.size())
-                                                                                         .arg(section_name));
-    }
-
-    if ((allow_empty_section) && (variants.size() == 0)) {
-        VariantData variant_data{};
-        variants.push_back(std::move(variant_data));
-    }
-    get_variant(); // for throwing exception if no variant was found
+    use_selected_variants(matching_variants);
 }
 
-void DataEngineInstance::delete_all_but_biggest_variants() {
-    std::vector<VariantData> variants_new;
+void DataEngineInstance::select_biggest_variant(const DataEngineInstance &prototype) {
+    std::vector<const VariantData *> biggest_variant;
     std::experimental::optional<uint> max_size;
-    for (auto &variant : variants) {
+    for (auto &variant : prototype.variants) {
         if (max_size < variant.get_entry_count()) {
             max_size = variant.get_entry_count();
         }
     }
 
-    for (auto &variant : variants) {
+    for (auto &variant : prototype.variants) {
         if (max_size == variant.get_entry_count()) {
-            variants_new.push_back(std::move(variant));
+            biggest_variant.push_back(&variant);
             break;
         }
     }
+    use_selected_variants(biggest_variant);
+}
 
-    variants = std::move(variants_new);
-    if (variants.size() > 1) {
+void DataEngineInstance::use_selected_variants(const std::vector<const VariantData *> &selected_variants) {
+    if (selected_variants.size() > 1) {
         throw DataEngineError(DataEngineErrorNumber::non_unique_desired_field_found, QString("Dataengine: More than one dependency fullfilling variants "
                                                                                              "(%1) found in section: \"%2\"")
-                                                                                         .arg(variants.size())
+                                                                                         .arg(selected_variants.size())
                                                                                          .arg(section_name));
     }
 
+    variants.clear();
+    for (const auto variant : selected_variants) {
+        variants.push_back(*variant);
+    }
+
     if ((allow_empty_section) && (variants.size() == 0)) {
         VariantData variant_data{};
         variants.push_back(std::move(variant_data));
@@ -647,31 +833,61 @@ void DataEngineInstance::set_allow_empty_section(bool allow_empty_section) {
     this->allow_empty_section = allow_empty_section;
 }
 
-bool DataEngineSection::is_complete() const {
-    bool result = true;
-    if (is_section_instance_defined() == false) {
-        result = false;
+const DataEngineSection::EntryStatusCounts &DataEngineSection::get_entry_status_counts() const {
+    if (entry_status_counts.valid) {
+        return entry_status_counts;
     }
+    entry_status_counts.invalidate();
+    uint incomplete = 0;
+    uint out_of_range = 0;
     for (auto &instance : instances) {
         const VariantData *variant_to_test = instance.get_variant();
         assert(variant_to_test);
         for (const auto &entry : variant_to_test->data_entries) {
-            if (!entry.get()->is_complete()) {
-                result = false;
+            if (entry->get_entry_kind().t == EntryType::Reference) {
+                entry_status_counts.references.push_back(entry.get());
+                continue;
+            }
+            if (!entry->is_complete()) {
+                incomplete++;
+            }
+            if (!entry->is_in_range()) {
+                out_of_range++;
             }
         }
     }
+    entry_status_counts.incomplete = incomplete;
+    entry_status_counts.out_of_range = out_of_range;
+    entry_status_counts.valid = true;
+    return entry_status_counts;
+}
+
+bool DataEngineSection::is_complete() const {
+    bool result = true;
+    if (is_section_instance_defined() == false) {
+        result = false;
+    }
+    const auto &counts = get_entry_status_counts();
+    if (counts.incomplete > 0) {
+        result = false;
+    }
+    for (const auto reference : counts.references) {
+        if (!reference->is_complete()) {
+            result = false;
+        }
+    }
     return result;
 }
 
 bool DataEngineSection::all_values_in_range() const {
     bool result = is_complete();
-    for (auto &instance : instances) {
-        const VariantData *variant_to_test = instance.get_variant();
-        for (const auto &entry : variant_to_test->data_entries) {
-            if (!entry.get()->is_in_range()) {
-                result = false;
-            }
+    const auto &counts = get_entry_status_counts();
+    if (counts.out_of_range > 0) {
+        result = false;
+    }
+    for (const auto reference : counts.references) {
+        if (!reference->is_in_range()) {
+            result = false;
         }
     }
     return result;
@@ -698,6 +914,7 @@ static QString jsonTypeToString(const QJsonValue &val) {
 }
 
 void DataEngineSection::from_json(const QJsonValue &object, const QString &key_name) {
+    entry_status_counts.invalidate();
     section_name = key_name;
     prototype_instance.set_section_name(section_name);
     if (object.isArray()) {
@@ -888,16 +1105,17 @@ bool DataEngineSection::set_instance_count_if_name_matches(QString instance_coun
 }
 
 void DataEngineSection::create_instances_if_defined() {
+    entry_status_counts.invalidate();
     if (is_section_instance_defined()) {
         if (instance_count.value() == 0) {
             throw DataEngineError(DataEngineErrorNumber::instance_count_must_not_be_zero_nor_fraction_nor_negative,
                                   QString("Dataengine: Instance count of section \"%1\" must not be zero.").arg(get_section_name()));
         }
         assert(instances.size() == 0);
+        //the variants are copied from the prototype when they are selected, so only the selected variant is copied into each instance
+        instances.reserve(instance_count.value());
         for (uint i = 0; i < instance_count.value(); i++) {
-            //
-            DataEngineInstance instance(prototype_instance);
-            instances.push_back(instance);
+            instances.push_back(prototype_instance.copy_without_variants());
         }
     }
 }
@@ -940,25 +1158,9 @@ VariantData::VariantData(const VariantData &other)
     : dependency_tags{other.dependency_tags}
     , relevant_dependencies{other.relevant_dependencies} {
     for (auto &entry : other.data_entries) {
-        auto entry_num = dynamic_cast<NumericDataEntry *>(entry.get());
-        auto entry_bool = dynamic_cast<BoolDataEntry *>(entry.get());
-        auto entry_text = dynamic_cast<TextDataEntry *>(entry.get());
-        auto entry_dateime = dynamic_cast<DateTimeDataEntry *>(entry.get());
-        auto entry_ref = dynamic_cast<ReferenceDataEntry *>(entry.get());
-        if (entry_num) {
-            data_entries.push_back(std::make_unique<NumericDataEntry>(*entry_num));
-        } else if (entry_bool) {
-            data_entries.push_back(std::make_unique<BoolDataEntry>(*entry_bool));
-        } else if (entry_text) {
-            data_entries.push_back(std::make_unique<TextDataEntry>(*entry_text));
-        } else if (entry_dateime) {
-            data_entries.push_back(std::make_unique<DateTimeDataEntry>(*entry_dateime));
-        } else if (entry_ref) {
-            data_entries.push_back(std::make_unique<ReferenceDataEntry>(*entry_ref));
-        } else {
-            assert(0);
-            // unknown data type
-        }
+        append_entry(entry->visit([](const auto &typed_entry) -> std::unique_ptr<DataEngineDataEntry> {
+            return std::make_unique<std::decay_t<decltype(typed_entry)>>(typed_entry);
+        }));
     }
 }
 
@@ -976,13 +1178,13 @@ bool VariantData::uses_dependency() const {
 
 bool VariantData::is_dependency_matching(const QMap<QString, QList<QVariant>> &tags, uint instance_index, uint instance_count, const QString &section_name) {
     relevant_dependencies.clear();
-    bool dependency_matches = true;
-    const auto &keys_to_test = dependency_tags.tags.uniqueKeys();
+    const auto &key_matchers = dependency_tags.get_key_matchers();
     std::experimental::optional<uint> length_of_first_tag_value_list;
-    if (keys_to_test.count()) {
-        for (const auto &tag_key : keys_to_test) {
-            if (tags.contains(tag_key)) {
-                const unsigned int value_count = tags[tag_key].count();
+    if (key_matchers.size()) {
+        for (const auto &key_matcher : key_matchers) {
+            const auto tag_values = tags.constFind(key_matcher.key);
+            if (tag_values != tags.constEnd()) {
+                const unsigned int value_count = tag_values.value().count();
                 if ((bool)length_of_first_tag_value_list == false) {
                     length_of_first_tag_value_list = value_count;
                 } else {
@@ -1020,29 +1222,26 @@ bool VariantData::is_dependency_matching(const QMap<QString, QList<QVariant>> &t
         assert(instance_index < instance_count);
     }
 
-    for (const auto &tag_key : keys_to_test) {
-        if (tags.contains(tag_key)) {
-            bool at_least_value_matches = false;
-            const auto &value_list = dependency_tags.tags.values(tag_key);
-            for (const auto &test_matching : value_list) {
-                auto val = tags[tag_key][instance_index];
-                if (test_matching.is_matching(val)) {
-                    at_least_value_matches = true;
-                    relevant_dependencies.insert(tag_key, val);
-                }
-            }
-            if (!at_least_value_matches) {
-                dependency_matches = false;
-                break;
+    for (const auto &key_matcher : key_matchers) {
+        const auto tag_values = tags.constFind(key_matcher.key);
+        if (tag_values == tags.constEnd()) {
+            relevant_dependencies.clear();
+            return false;
+        }
+        const QVariant &val = tag_values.value()[instance_index];
+        bool at_least_value_matches = false;
+        for (const auto &test_matching : key_matcher.values) {
+            if (test_matching.is_matching(val)) {
+                at_least_value_matches = true;
+                relevant_dependencies.insert(key_matcher.key, val);
             }
-        } else {
-            dependency_matches = false;
+        }
+        if (!at_least_value_matches) {
+            relevant_dependencies.clear();
+            return false;
         }
     }
-    if (!dependency_matches) {
-        relevant_dependencies.clear();
-    }
-    return dependency_matches;
+    return true;
 }
 
 void VariantData::from_json(const QJsonObject &object) {
@@ -1063,7 +1262,7 @@ void VariantData::from_json(const QJsonObject &object) {
                 throw DataEngineError(DataEngineErrorNumber::duplicate_field,
                                       QString("Dataengine: Data field with the name %1 is already existing").arg(entry.get()->field_name));
             }
-            data_entries.push_back(std::move(entry));
+            append_entry(std::move(entry));
         }
     } else if (data.isObject()) {
         std::unique_ptr<DataEngineDataEntry> entry = DataEngineDataEntry::from_json(data.toObject());
@@ -1071,7 +1270,7 @@ void VariantData::from_json(const QJsonObject &object) {
             throw DataEngineError(DataEngineErrorNumber::duplicate_field,
                                   QString("Dataengine: Data field with the name %1 is already existing").arg(entry.get()->field_name));
         }
-        data_entries.push_back(std::move(entry));
+        append_entry(std::move(entry));
     }
     dependency_tags.from_json(depend_tags);
 }
@@ -1097,13 +1296,16 @@ DataEngineDataEntry *VariantData::get_entry(QString field_name) const {
 
 DataEngineDataEntry *VariantData::get_entry_raw(QString field_name, DataEngineErrorNumber *errornum) const {
     *errornum = DataEngineErrorNumber::ok;
-    for (const auto &entry : data_entries) {
-        if (entry.get()->field_name.toLower() == field_name.toLower()) {
-            return entry.get();
-        }
+    DataEngineDataEntry *entry = entry_index.value(field_name.toLower(), nullptr);
+    if (entry == nullptr) {
+        *errornum = DataEngineErrorNumber::no_field_id_found;
     }
-    *errornum = DataEngineErrorNumber::no_field_id_found;
-    return nullptr;
+    return entry;
+}
+
+void VariantData::append_entry(std::unique_ptr<DataEngineDataEntry> entry) {
+    entry_index.insert(entry->field_name.toLower(), entry.get());
+    data_entries.push_back(std::move(entry));
 }
 
 const QMap<QString, QVariant> &VariantData::get_relevant_dependencies() const {
@@ -1146,6 +1348,17 @@ void DependencyTags::from_json(const QJsonValue &object) {
     } else {
         throw std::runtime_error(QString("Dataengine: invalid tag description in json file").toStdString());
     }
+    key_matchers.clear();
+    for (auto it = tags.constBegin(); it != tags.constEnd(); ++it) {
+        if (key_matchers.empty() || key_matchers.back().key != it.key()) {
+            key_matchers.push_back(KeyMatcher{it.key(), {}});
+        }
+        key_matchers.back().values.push_back(it.value());
+    }
+}
+
+const std::vector<DependencyTags::KeyMatcher> &DependencyTags::get_key_matchers() const {
+    return key_matchers;
 }
 
 #if 0
@@ -1177,6 +1390,7 @@ DependencyValue::DependencyValue() {
     range_high_excluding = 0;
     range_low_including = 0;
     match_style = Match_style::MatchNone;
+    compile();
 }
 
 QString DependencyValue::get_serialised_string() const {
@@ -1223,19 +1437,30 @@ void DependencyValue::from_json(const QJsonValue &object, const bool default_to_
     }
 }
 
+static const double DEPENDENCY_PRECISION_REDUCTION = 1000 * 1000 * 10;
+
+void DependencyValue::compile() {
+    if (match_exactly.type() == QVariant::Double) {
+        exact_type = ExactDouble;
+        rounded_exactly = std::round(match_exactly.toDouble() * DEPENDENCY_PRECISION_REDUCTION);
+    } else if (match_exactly.type() == QVariant::Bool) {
+        exact_type = ExactBool;
+    } else {
+        exact_type = ExactOther;
+    }
+    rounded_low_including = std::round(range_low_including * DEPENDENCY_PRECISION_REDUCTION);
+    rounded_high_excluding = std::round(range_high_excluding * DEPENDENCY_PRECISION_REDUCTION);
+}
+
 bool DependencyValue::is_matching(const QVariant &test_value) const {
-    const double PRECISION_REDUCTION = 1000 * 1000 * 10;
     switch (match_style) {
         case MatchExactly: {
             bool result = true;
-            if ((test_value.type() == QVariant::Double) && (match_exactly.type() == QVariant::Double)) {
-                bool ok_a, ok_b;
-                double num_val_a = test_value.toDouble(&ok_a);
-                double num_val_b = match_exactly.toDouble(&ok_b);
-                if (std::round(num_val_a * PRECISION_REDUCTION) == std::round(num_val_b * PRECISION_REDUCTION)) {
+            if ((exact_type == ExactDouble) && (test_value.type() == QVariant::Double)) {
+                if (std::round(test_value.toDouble() * DEPENDENCY_PRECISION_REDUCTION) == rounded_exactly) {
                     result = true;
                 }
-            } else if ((test_value.type() == QVariant::Bool) && (match_exactly.type() == QVariant::Bool)) {
+            } else if ((exact_type == ExactBool) && (test_value.type() == QVariant::Bool)) {
                 result = test_value.toBool() == match_exactly.toBool();
             } else {
                 result = match_exactly == test_value;
@@ -1246,19 +1471,17 @@ bool DependencyValue::is_matching(const QVariant &test_value) const {
             bool ok;
             double num_val = test_value.toDouble(&ok);
 
-            double val_a = std::round(num_val * PRECISION_REDUCTION);
-            double val_high_excl = std::round(range_high_excluding * PRECISION_REDUCTION);
-            double val_low_incl = std::round(range_low_including * PRECISION_REDUCTION);
+            double val_a = std::round(num_val * DEPENDENCY_PRECISION_REDUCTION);
             assert(ok);
 
-            bool result = (val_low_incl <= val_a);
-            if (almost_equal(val_low_incl, val_a, 10)) {
+            bool result = (rounded_low_including <= val_a);
+            if (almost_equal(rounded_low_including, val_a, 10)) {
                 result = true;
             }
 
-            result = result && (val_a < val_high_excl);
+            result = result && (val_a < rounded_high_excluding);
 
-            if (val_a == val_high_excl) {
+            if (val_a == rounded_high_excluding) {
                 result = false;
             }
 
@@ -1342,6 +1565,7 @@ void DependencyValue::from_string(const QString &str) {
         }
         match_exactly.setValue<QString>(str);
     }
+    compile();
 }
 
 void DependencyValue::from_number(const double &number) {
@@ -1350,6 +1574,7 @@ void DependencyValue::from_number(const double &number) {
     serialised_string = QString::number(number);
     range_low_including = 0;
     range_high_excluding = 0;
+    compile();
 }
 
 void DependencyValue::from_bool(const bool &boolean) {
@@ -1363,6 +1588,7 @@ void DependencyValue::from_bool(const bool &boolean) {
 
     range_low_including = 0;
     range_high_excluding = 0;
+    compile();
 }
 
 bool Data_engine::is_complete() const {
@@ -1470,8 +1696,36 @@ QString DataEngineSection::get_serialised_dependency_string() const {
     return variant->get_dependencies_serialised_string();
 }
 
+template <class Setter>
+void DataEngineSection::set_and_count(DataEngineDataEntry *data_entry, Setter &&setter) {
+    assert(data_entry->get_entry_kind().t != EntryType::Reference);
+    data_entry->actual_value_version++;
+    if (!entry_status_counts.valid) {
+        setter();
+        return;
+    }
+    const bool was_complete = data_entry->is_complete();
+    const bool was_in_range = data_entry->is_in_range();
+    setter();
+    const bool now_complete = data_entry->is_complete();
+    const bool now_in_range = data_entry->is_in_range();
+    if (was_complete && !now_complete) {
+        entry_status_counts.incomplete++;
+    } else if (!was_complete && now_complete) {
+        entry_status_counts.incomplete--;
+    }
+    if (was_in_range && !now_in_range) {
+        entry_status_counts.out_of_range++;
+    } else if (!was_in_range && now_in_range) {
+        entry_status_counts.out_of_range--;
+    }
+}
+
 void DataEngineSection::set_actual_number(const FormID &id, double number) {
-    auto data_entry = get_entry(id);
+    set_entry_actual_number(get_entry(id), id, number);
+}
+
+void DataEngineSection::set_entry_actual_number(DataEngineDataEntry *data_entry, const FormID &id, double number) {
     assert(data_entry); // if field is not found an exception was already thrown
                         // above. Something bad must happen to assert here
 
@@ -1487,12 +1741,15 @@ void DataEngineSection::set_actual_number(const FormID &id, double number) {
         }
         reference_entry->set_actual_value(number);
     } else {
-        number_entry->set_actual_value(number);
+        set_and_count(number_entry, [number_entry, number] { number_entry->set_actual_value(number); });
     }
 }
 
 void DataEngineSection::set_actual_text(const FormID &id, QString text) {
-    auto *data_entry = get_entry(id);
+    set_entry_actual_text(get_entry(id), id, text);
+}
+
+void DataEngineSection::set_entry_actual_text(DataEngineDataEntry *data_entry, const FormID &id, QString text) {
     assert(data_entry); // if field is not found an exception was already thrown
                         // above. Something bad must happen to assert here
 
@@ -1508,12 +1765,15 @@ void DataEngineSection::set_actual_text(const FormID &id, QString text) {
         }
         reference_entry->set_actual_value(text);
     } else {
-        text_entry->set_actual_value(text);
+        set_and_count(text_entry, [text_entry, &text] { text_entry->set_actual_value(text); });
     }
 }
 
 void DataEngineSection::set_actual_bool(const FormID &id, bool value) {
-    DataEngineDataEntry *data_entry = get_entry(id);
+    set_entry_actual_bool(get_entry(id), id, value);
+}
+
+void DataEngineSection::set_entry_actual_bool(DataEngineDataEntry *data_entry, const FormID &id, bool value) {
     assert(data_entry); // if field is not found an exception was already thrown
                         // above. Something bad must happen to assert here
 
@@ -1528,12 +1788,15 @@ void DataEngineSection::set_actual_bool(const FormID &id, bool value) {
         }
         reference_entry->set_actual_value(value);
     } else {
-        bool_entry->set_actual_value(value);
+        set_and_count(bool_entry, [bool_entry, value] { bool_entry->set_actual_value(value); });
     }
 }
 
 void DataEngineSection::set_actual_datetime(const FormID &id, DataEngineDateTime value) {
-    DataEngineDataEntry *data_entry = get_entry(id);
+    set_entry_actual_datetime(get_entry(id), id, value);
+}
+
+void DataEngineSection::set_entry_actual_datetime(DataEngineDataEntry *data_entry, const FormID &id, DataEngineDateTime value) {
     assert(data_entry); // if field is not found an exception was already thrown
                         // above. Something bad must happen to assert here
 
@@ -1553,7 +1816,7 @@ void DataEngineSection::set_actual_datetime(const FormID &id, DataEngineDateTime
         }
         reference_entry->set_actual_value(value);
     } else {
-        date_time_entry->set_actual_value(value);
+        set_and_count(date_time_entry, [date_time_entry, &value] { date_time_entry->set_actual_value(value); });
     }
 }
 
@@ -1574,6 +1837,7 @@ bool DataEngineSection::section_uses_variants() const {
 }
 
 void Data_engine::set_actual_number(const FormID &id, double number) {
+    Performance_counters::add(Performance_counters::Counter::data_engine_values_set);
     auto section = sections.get_section(id);
     section->set_actual_number(id, number);
     QString serialised_dependency = section->get_serialised_dependency_string();
@@ -1581,20 +1845,81 @@ void Data_engine::set_actual_number(const FormID &id, double number) {
 }
 
 void Data_engine::set_actual_text(const FormID &id, QString text) {
+    Performance_counters::add(Performance_counters::Counter::data_engine_values_set);
     auto section = sections.get_section(id);
     section->set_actual_text(id, text);
 }
 
 void Data_engine::set_actual_bool(const FormID &id, bool value) {
+    Performance_counters::add(Performance_counters::Counter::data_engine_values_set);
     auto section = sections.get_section(id);
     section->set_actual_bool(id, value);
 }
 
 void Data_engine::set_actual_datetime(const FormID &id, DataEngineDateTime value) {
+    Performance_counters::add(Performance_counters::Counter::data_engine_values_set);
     auto section = sections.get_section(id);
     section->set_actual_datetime(id, value);
 }
 
+Data_engine_field Data_engine::get_field(const FormID &id) {
+    sections.get_section(id); // for throwing the exception of a faulty id or a missing section right away
+    return Data_engine_field{this, id};
+}
+
+Data_engine_field::Data_engine_field(Data_engine *data_engine, const FormID &id)
+    : data_engine{data_engine}
+    , id{id} {}
+
+DataEngineDataEntry *Data_engine_field::get_entry() const {
+    const auto &sections = data_engine->sections;
+    if ((entry == nullptr) || (generation != sections.get_generation())) {
+        section = sections.get_section(id);
+        entry = section->get_entry(id);
+        serialised_dependency = section->get_serialised_dependency_string();
+        generation = sections.get_generation();
+    }
+    return entry;
+}
+
+void Data_engine_field::set_actual_number(double number) {
+    Performance_counters::add(Performance_counters::Counter::data_engine_values_set);
+    auto data_entry = get_entry();
+    section->set_entry_actual_number(data_entry, id, number);
+    data_engine->statistics_file.set_actual_value(id, serialised_dependency, number);
+}
+
+void Data_engine_field::set_actual_text(QString text) {
+    Performance_counters::add(Performance_counters::Counter::data_engine_values_set);
+    auto data_entry = get_entry();
+    section->set_entry_actual_text(data_entry, id, text);
+}
+
+void Data_engine_field::set_actual_bool(bool value) {
+    Performance_counters::add(Performance_counters::Counter::data_engine_values_set);
+    auto data_entry = get_entry();
+    section->set_entry_actual_bool(data_entry, id, value);
+}
+
+double Data_engine_field::get_actual_number() const {
+    data_engine->assert_not_in_dummy_mode();
+    return get_entry()->get_actual_number();
+}
+
+QString Data_engine_field::get_actual_value() const {
+    data_engine->assert_not_in_dummy_mode();
+    return get_entry()->get_actual_values();
+}
+
+EntryType Data_engine_field::get_entry_type() const {
+    data_engine->assert_not_in_dummy_mode();
+    return get_entry()->get_entry_type();
+}
+
+const FormID &Data_engine_field::get_id() const {
+    return id;
+}
+
 void Data_engine::use_instance(const QString &section_name, const QString &instance_caption, const uint instance_index) {
     sections.use_instance(section_name, instance_caption, instance_index);
 }
@@ -1625,6 +1950,10 @@ void Data_engine::set_enable_auto_open_pdf(bool auto_open_pdf) {
     this->auto_open_pdf = auto_open_pdf;
 }
 
+void Data_engine::set_enable_performance_counters_in_report(bool enable) {
+    performance_counters_in_report = enable;
+}
+
 QStringList Data_engine::get_ids_of_section(const QString &section_name) const {
     DataEngineSection *the_section = sections.get_section(section_name + "/dummy");
     assert(the_section);
@@ -1813,6 +2142,8 @@ std::unique_ptr<QWidget> Data_engine::get_preview() const {
 }
 
 bool Data_engine::generate_pdf(const std::string &form, const std::string &destination) const {
+    TRACE_SCOPE("Data_engine::generate_pdf");
+    const Performance_counters::Scoped_timer timer{Performance_counters::Histogram::pdf_generation_ms};
     return MainWindow::await_execute_in_gui_thread([form, destination, this] {
         QString db_name = ""; //TODO: find a better temporary name
                               //QDir::homePath()
@@ -1945,6 +2276,9 @@ void Data_engine::save_to_json(QString filename) {
     duration.setValue<qint64>(QDateTime::currentMSecsSinceEpoch() / 1000 - load_time_seconds_since_epoch);
     jo_general["test_duration_seconds"] = QJsonValue::fromVariant(duration);
     jo_general["os_username"] = QString::fromStdString(get_os_username());
+    if (performance_counters_in_report) {
+        jo_general["performance_counters"] = (get_performance_counters_snapshot(performance_counters_run) - load_time_performance_counters).to_json();
+    }
 
     QJsonObject jo_dependency;
     const QMap<QString, QList<QVariant>> dependency_tags = sections.get_dependancy_tags();
@@ -3213,6 +3547,15 @@ double NumericTolerance::get_absolute_limit_above(const double desired) const {
     return 0;
 }
 
+bool NumericTolerance::get_absolute_limits(const double desired, double &limit_beneath, double &limit_above) const {
+    if (is_undefined) {
+        return false;
+    }
+    limit_beneath = get_absolute_limit_beneath(desired);
+    limit_above = get_absolute_limit_above(desired);
+    return true;
+}
+
 bool NumericTolerance::test_in_range(const double desired, const std::experimental::optional<double> &measured) const {
     double min_value_absolute = 0;
     double max_value_absolute = 0;
@@ -3605,22 +3948,30 @@ std::unique_ptr<DataEngineDataEntry> DataEngineDataEntry::from_json(const QJsonO
 }
 
 NumericDataEntry::NumericDataEntry(const NumericDataEntry &other)
-    : DataEngineDataEntry(other.field_name)
+    : DataEngineDataEntry(other.field_name, kind)
     , desired_value{other.desired_value}
     , unit{other.unit}
     , description{other.description}
     , si_prefix{other.si_prefix}
     , tolerance{other.tolerance}
-    , actual_value{other.actual_value} {}
+    , actual_value{other.actual_value}
+    , has_limits{other.has_limits}
+    , lower_limit{other.lower_limit}
+    , upper_limit{other.upper_limit} {}
 
 NumericDataEntry::NumericDataEntry(FormID field_name, std::experimental::optional<double> desired_value, NumericTolerance tolerance, QString unit,
                                    std::experimental::optional<double> si_prefix, QString description)
-    : DataEngineDataEntry(field_name)
+    : DataEngineDataEntry(field_name, kind)
     , desired_value(desired_value)
     , unit(std::move(unit))
     , description(std::move(description))
     , tolerance(tolerance) {
     this->si_prefix = si_prefix.value_or(1.0);
+    update_limits();
+}
+
+void NumericDataEntry::update_limits() {
+    has_limits = (bool)desired_value && tolerance.get_absolute_limits(desired_value.value(), lower_limit, upper_limit);
 }
 
 bool NumericDataEntry::is_complete() const {
@@ -3635,9 +3986,11 @@ bool NumericDataEntry::is_in_range() const {
         return false;
     }
     if ((bool)desired_value) {
-        if (tolerance.test_in_range(desired_value.value(), actual_value) == false) {
-            return false;
+        if (!has_limits) {
+            return tolerance.test_in_range(desired_value.value(), actual_value); // throws
         }
+        const double actual = actual_value.value();
+        return (lower_limit <= actual) && (actual <= upper_limit); // false for NaN
     }
     return true;
 }
@@ -3682,7 +4035,7 @@ double NumericDataEntry::get_si_prefix() const {
 }
 
 bool NumericDataEntry::compare_unit_desired_siprefix(const DataEngineDataEntry *from) const {
-    auto const from_num = dynamic_cast<const NumericDataEntry *>(from);
+    auto const from_num = from->as<NumericDataEntry>();
     if (from_num == nullptr) {
         return false;
     }
@@ -3702,10 +4055,6 @@ void NumericDataEntry::set_actual_value(double actual_value) {
     this->actual_value = actual_value / si_prefix;
 }
 
-EntryType NumericDataEntry::get_entry_type() const {
-    return EntryType{EntryType::Number};
-}
-
 bool NumericDataEntry::is_desired_value_set() const {
     return (bool)desired_value;
 }
@@ -3745,22 +4094,24 @@ void NumericDataEntry::set_desired_value_from_desired(DataEngineDataEntry *from)
     NumericDataEntry *num_from = from->as<NumericDataEntry>();
     assert(num_from);
     desired_value = num_from->desired_value;
+    update_limits();
 }
 
 void NumericDataEntry::set_desired_value_from_actual(DataEngineDataEntry *from) {
     NumericDataEntry *num_from = from->as<NumericDataEntry>();
     assert(num_from);
     desired_value = num_from->actual_value;
+    update_limits();
 }
 
 TextDataEntry::TextDataEntry(const TextDataEntry &other)
-    : DataEngineDataEntry{other.field_name}
+    : DataEngineDataEntry{other.field_name, kind}
     , desired_value{other.desired_value}
     , description{other.description}
     , actual_value{other.actual_value} {}
 
 TextDataEntry::TextDataEntry(const FormID name, std::experimental::optional<QString> desired_value, QString description)
-    : DataEngineDataEntry(name)
+    : DataEngineDataEntry(name, kind)
     , desired_value(std::move(desired_value))
     , description(description) {}
 
@@ -3821,7 +4172,7 @@ double TextDataEntry::get_desired_number() const {
 }
 
 bool TextDataEntry::compare_unit_desired_siprefix(const DataEngineDataEntry *from) const {
-    auto const from_text = dynamic_cast<const TextDataEntry *>(from);
+    auto const from_text = from->as<TextDataEntry>();
     if (from_text == nullptr) {
         return false;
     }
@@ -3835,10 +4186,6 @@ void TextDataEntry::set_actual_value(QString actual_value) {
     this->actual_value = actual_value;
 }
 
-EntryType TextDataEntry::get_entry_type() const {
-    return EntryType{EntryType::Text};
-}
-
 void TextDataEntry::set_desired_value_from_desired(DataEngineDataEntry *from) {
     TextDataEntry *num_from = from->as<TextDataEntry>();
     assert(num_from);
@@ -3881,12 +4228,12 @@ QString TextDataEntry::get_specific_json_name() const {
 }
 
 DateTimeDataEntry::DateTimeDataEntry(const DateTimeDataEntry &other)
-    : DataEngineDataEntry{other.field_name}
+    : DataEngineDataEntry{other.field_name, kind}
     , description{other.description}
     , actual_value{other.actual_value} {}
 
 DateTimeDataEntry::DateTimeDataEntry(const FormID name, QString description)
-    : DataEngineDataEntry(name)
+    : DataEngineDataEntry(name, kind)
     , description(description) {}
 
 bool DateTimeDataEntry::is_complete() const {
@@ -3938,7 +4285,7 @@ double DateTimeDataEntry::get_desired_number() const {
 }
 
 bool DateTimeDataEntry::compare_unit_desired_siprefix(const DataEngineDataEntry *from) const {
-    auto const from_dateime = dynamic_cast<const DateTimeDataEntry *>(from);
+    auto const from_dateime = from->as<DateTimeDataEntry>();
     if (from_dateime == nullptr) {
         return false;
     }
@@ -3949,10 +4296,6 @@ void DateTimeDataEntry::set_actual_value(DataEngineDateTime actual_value) {
     this->actual_value = actual_value;
 }
 
-EntryType DateTimeDataEntry::get_entry_type() const {
-    return EntryType{EntryType::DateTime};
-}
-
 void DateTimeDataEntry::set_desired_value_from_desired(DataEngineDataEntry *from) {
     (void)from;
     throw DataEngineError(DataEngineErrorNumber::datetime_dont_support_desired_values_yet,
@@ -4004,13 +4347,13 @@ Fields succeeded: %3/%4)")
 }
 
 BoolDataEntry::BoolDataEntry(const BoolDataEntry &other)
-    : DataEngineDataEntry{other.field_name}
+    : DataEngineDataEntry{other.field_name, kind}
     , desired_value{other.desired_value}
     , description{other.description}
     , actual_value{other.actual_value} {}
 
 BoolDataEntry::BoolDataEntry(const FormID name, std::experimental::optional<bool> desired_value, QString description)
-    : DataEngineDataEntry(name)
+    : DataEngineDataEntry(name, kind)
     , desired_value(std::move(desired_value))
     , description(description) {}
 
@@ -4077,7 +4420,7 @@ double BoolDataEntry::get_desired_number() const {
 }
 
 bool BoolDataEntry::compare_unit_desired_siprefix(const DataEngineDataEntry *from) const {
-    auto const from_bool = dynamic_cast<const BoolDataEntry *>(from);
+    auto const from_bool = from->as<BoolDataEntry>();
     if (from_bool == nullptr) {
         return false;
     }
@@ -4091,10 +4434,6 @@ void BoolDataEntry::set_actual_value(bool value) {
     this->actual_value = value;
 }
 
-EntryType BoolDataEntry::get_entry_type() const {
-    return EntryType{EntryType::Bool};
-}
-
 void BoolDataEntry::set_desired_value_from_desired(DataEngineDataEntry *from) {
     BoolDataEntry *num_from = from->as<BoolDataEntry>();
     assert(num_from);
@@ -4137,35 +4476,25 @@ QString BoolDataEntry::get_specific_json_name() const {
 }
 
 ReferenceDataEntry::ReferenceDataEntry(const ReferenceDataEntry &other)
-    : DataEngineDataEntry{other.field_name}
+    : DataEngineDataEntry{other.field_name, kind}
     , tolerance{other.tolerance}
     , description{other.description}
     , reference_links{other.reference_links}
     , entry_target{other.entry_target} {
-    auto entry_num = dynamic_cast<NumericDataEntry *>(other.entry.get());
-    auto entry_bool = dynamic_cast<BoolDataEntry *>(other.entry.get());
-    auto entry_text = dynamic_cast<TextDataEntry *>(other.entry.get());
-    auto entry_datetime = dynamic_cast<DateTimeDataEntry *>(other.entry.get());
-    if (entry_num) {
-        entry = std::make_unique<NumericDataEntry>(*entry_num);
-    } else if (entry_bool) {
-        entry = std::make_unique<BoolDataEntry>(*entry_bool);
-    } else if (entry_text) {
-        entry = std::make_unique<TextDataEntry>(*entry_text);
-    } else if (entry_datetime) {
-        entry = std::make_unique<DateTimeDataEntry>(*entry_datetime);
-    } else if (other.entry.get() == nullptr) {
+    if (other.entry.get() == nullptr) {
         // not yet initialized. Is ok
-    } else {
-        assert(0);
-        // unknown data type
-        // reference_type would not be allowed since ther is no recursion(reference
-        // pointing to a reference)
+        return;
     }
+    // reference_type would not be allowed since ther is no recursion(reference
+    // pointing to a reference)
+    assert(other.entry->get_entry_kind().t != EntryType::Reference);
+    entry = other.entry->visit([](const auto &typed_entry) -> std::unique_ptr<DataEngineDataEntry> {
+        return std::make_unique<std::decay_t<decltype(typed_entry)>>(typed_entry);
+    });
 }
 
 ReferenceDataEntry::ReferenceDataEntry(const FormID name, QString reference_string, NumericTolerance tolerance, QString description)
-    : DataEngineDataEntry(name)
+    : DataEngineDataEntry(name, kind)
     , tolerance(tolerance)
     , description(description) {
     parse_refence_string(reference_string);
@@ -4198,6 +4527,9 @@ bool ReferenceDataEntry::is_in_range() const {
 
 void ReferenceDataEntry::update_desired_value_from_reference() const {
     assert_that_instance_count_is_defined();
+    if ((updated_from_target != nullptr) && (updated_from_target == entry_target) && (updated_from_version == entry_target->actual_value_version)) {
+        return;
+    }
     if (reference_links[0].value == ReferenceLink::ReferenceValue::DesiredValue) {
         assert(entry_target->is_desired_value_set());
         entry->set_desired_value_from_desired(entry_target);
@@ -4219,6 +4551,8 @@ void ReferenceDataEntry::update_desired_value_from_reference() const {
         }
         entry->set_desired_value_from_actual(entry_target);
     }
+    updated_from_target = entry_target;
+    updated_from_version = entry_target->actual_value_version;
 }
 
 void ReferenceDataEntry::set_actual_value(double number) {
@@ -4323,7 +4657,7 @@ double ReferenceDataEntry::get_desired_number() const {
     return entry_target->get_desired_number();
 }
 
-EntryType ReferenceDataEntry::get_entry_type() const {
+EntryType ReferenceDataEntry::get_target_entry_type() const {
     assert_that_instance_count_is_defined();
     assert(entry_target);
     return entry_target->get_entry_type();
@@ -4338,6 +4672,7 @@ bool ReferenceDataEntry::compare_unit_desired_siprefix(const DataEngineDataEntry
 void ReferenceDataEntry::dereference(DataEngineSections *sections, const bool is_dummy_mode) {
     uint i = 0;
     not_defined_yet_due_to_undefined_instance_count = false;
+    updated_from_target = nullptr;
     while (i < reference_links.size()) {
         auto section = sections->get_section(reference_links[i].link);
         if (!section->is_section_instance_defined()) {
@@ -3,8 +3,10 @@
 
 #include "exceptionalapproval.h"
 #include "forward_decls.h"
+#include "performance_counters.h"
 
 #include <QDateTime>
+#include <QHash>
 #include <QJsonValue>
 #include <QList>
 #include <QString>
@@ -145,7 +147,8 @@ enum class DataEngineErrorNumber {
     inconsistant_types_across_variants_and_reference_targets,
     datetime_dont_support_desired_values_yet,
     datetime_dont_support_references_yet,
-    datetime_is_not_valid
+    datetime_is_not_valid,
+    reference_cycle
 
 };
 
@@ -211,9 +214,10 @@ struct PrintOrderSectionItem {
 };
 
 struct DataEngineDataEntry {
-    DataEngineDataEntry(const FormID &field_name)
+    DataEngineDataEntry(const FormID &field_name, EntryType entry_kind)
         : field_name(field_name)
-        , exceptional_approval{} {}
+        , exceptional_approval{}
+        , entry_kind{entry_kind} {}
     FormID field_name;
 
     virtual bool is_complete() const = 0;
@@ -228,32 +232,47 @@ struct DataEngineDataEntry {
     virtual void set_desired_value_from_actual(DataEngineDataEntry *from) = 0;
     virtual bool is_desired_value_set() const = 0;
     virtual bool compare_unit_desired_siprefix(const DataEngineDataEntry *from) const = 0;
-    virtual EntryType get_entry_type() const = 0;
+    //the type of the value, which for references is the type of the reference target
+    EntryType get_entry_type() const;
+    //the type of the entry itself, Reference for references
+    EntryType get_entry_kind() const;
     virtual QJsonObject get_specific_json_dump() const = 0;
     virtual QString get_specific_json_name() const = 0;
     virtual double get_desired_number() const = 0;
     void set_exceptional_approval(ExceptionalApprovalResult exceptional_approval);
     const ExceptionalApprovalResult &get_exceptional_approval() const;
+    //counts the changes of the actual value so references only copy it again after it changed
+    uint actual_value_version = 0;
 
     template <class T>
     T *as();
     template <class T>
     const T *as() const;
+    //calls visitor with the entry cast to its actual type, all overloads of visitor have to return the same type
+    template <class Visitor>
+    decltype(auto) visit(Visitor &&visitor);
+    template <class Visitor>
+    decltype(auto) visit(Visitor &&visitor) const;
     static std::unique_ptr<DataEngineDataEntry> from_json(const QJsonObject &object);
     virtual ~DataEngineDataEntry() = default;
 
     private:
     ExceptionalApprovalResult exceptional_approval{};
+    EntryType entry_kind;
 };
 
 template <class T>
 T *DataEngineDataEntry::DataEngineDataEntry::as() {
-    return dynamic_cast<T *>(this);
+    return entry_kind.t == T::kind ? static_cast<T *>(this) : nullptr;
 }
 
 template <class T>
 const T *DataEngineDataEntry::DataEngineDataEntry::as() const {
-    return dynamic_cast<const T *>(this);
+    return entry_kind.t == T::kind ? static_cast<const T *>(this) : nullptr;
+}
+
+inline EntryType DataEngineDataEntry::get_entry_kind() const {
+    return entry_kind;
 }
 
 struct NumericTolerance {
@@ -267,6 +286,8 @@ struct NumericTolerance {
     bool is_defined() const;
     QJsonObject get_json(double desirec_value) const;
     bool is_inherited_by_reference_targed = false;
+    //returns false if no tolerance was given to compute the limits from
+    bool get_absolute_limits(const double desired, double &limit_beneath, double &limit_above) const;
 
     private:
     bool is_undefined = true;
@@ -285,6 +306,8 @@ struct NumericTolerance {
 };
 
 struct NumericDataEntry : DataEngineDataEntry {
+    static constexpr decltype(EntryType::t) kind = EntryType::Number;
+
     NumericDataEntry(const NumericDataEntry &other);
 
     NumericDataEntry(FormID field_name, std::experimental::optional<double> desired_value, NumericTolerance tolerance, QString unit,
@@ -302,7 +325,6 @@ struct NumericDataEntry : DataEngineDataEntry {
     double get_desired_number() const override;
     bool compare_unit_desired_siprefix(const DataEngineDataEntry *from) const override;
     void set_actual_value(double actual_value);
-    EntryType get_entry_type() const override;
     bool is_desired_value_set() const override;
     NumericTolerance get_tolerance() const;
     QJsonObject get_specific_json_dump() const override;
@@ -319,9 +341,17 @@ struct NumericDataEntry : DataEngineDataEntry {
     double si_prefix = 1.0;
     NumericTolerance tolerance;
     std::experimental::optional<double> actual_value;
+
+    //absolute limits of the desired value with its tolerance, updated whenever the desired value changes so is_in_range only has to compare
+    void update_limits();
+    bool has_limits = false;
+    double lower_limit = 0;
+    double upper_limit = 0;
 };
 
 struct TextDataEntry : DataEngineDataEntry {
+    static constexpr decltype(EntryType::t) kind = EntryType::Text;
+
     TextDataEntry(const TextDataEntry &other);
 
     TextDataEntry(const FormID name, std::experimental::optional<QString> desired_value, QString description);
@@ -337,7 +367,6 @@ struct TextDataEntry : DataEngineDataEntry {
     double get_desired_number() const override;
     bool compare_unit_desired_siprefix(const DataEngineDataEntry *from) const override;
     void set_actual_value(QString actual_value);
-    EntryType get_entry_type() const override;
     bool is_desired_value_set() const override;
 
     QJsonObject get_specific_json_dump() const override;
@@ -384,6 +413,8 @@ struct DataEngineDateTime {
 Q_DECLARE_METATYPE(DataEngineDateTime);
 
 struct DateTimeDataEntry : DataEngineDataEntry {
+    static constexpr decltype(EntryType::t) kind = EntryType::DateTime;
+
     DateTimeDataEntry(const DateTimeDataEntry &other);
 
     DateTimeDataEntry(const FormID name, QString description);
@@ -399,7 +430,6 @@ struct DateTimeDataEntry : DataEngineDataEntry {
     double get_desired_number() const override;
     bool compare_unit_desired_siprefix(const DataEngineDataEntry *from) const override;
     void set_actual_value(DataEngineDateTime actual_value);
-    EntryType get_entry_type() const override;
     bool is_desired_value_set() const override;
 
     QJsonObject get_specific_json_dump() const override;
@@ -417,6 +447,8 @@ struct DateTimeDataEntry : DataEngineDataEntry {
 };
 
 struct BoolDataEntry : DataEngineDataEntry {
+    static constexpr decltype(EntryType::t) kind = EntryType::Bool;
+
     BoolDataEntry(const BoolDataEntry &other);
     BoolDataEntry(const FormID name, std::experimental::optional<bool> desired_value, QString description);
 
@@ -431,7 +463,6 @@ struct BoolDataEntry : DataEngineDataEntry {
     double get_desired_number() const override;
     bool compare_unit_desired_siprefix(const DataEngineDataEntry *from) const override;
     void set_actual_value(bool value);
-    EntryType get_entry_type() const override;
     bool is_desired_value_set() const override;
 
     QJsonObject get_specific_json_dump() const override;
@@ -454,6 +485,8 @@ struct ReferenceLink {
 };
 
 struct ReferenceDataEntry : DataEngineDataEntry {
+    static constexpr decltype(EntryType::t) kind = EntryType::Reference;
+
     ReferenceDataEntry(const ReferenceDataEntry &other);
     ReferenceDataEntry(const FormID name, QString reference_string, NumericTolerance tolerance, QString description);
 
@@ -471,7 +504,7 @@ struct ReferenceDataEntry : DataEngineDataEntry {
     QString get_unit() const override;
     double get_si_prefix() const override;
     double get_desired_number() const override;
-    EntryType get_entry_type() const override;
+    EntryType get_target_entry_type() const;
     bool compare_unit_desired_siprefix(const DataEngineDataEntry *from) const override;
     void set_actual_value(double number);
     void set_actual_value(QString val);
@@ -499,8 +532,56 @@ struct ReferenceDataEntry : DataEngineDataEntry {
     DataEngineDataEntry *entry_target = nullptr;
     std::experimental::optional<uint> target_instance_count;
     std::unique_ptr<DataEngineDataEntry> entry;
+    //the target and its actual_value_version the desired value of entry was last taken from
+    mutable const DataEngineDataEntry *updated_from_target = nullptr;
+    mutable uint updated_from_version = 0;
 };
 
+inline EntryType DataEngineDataEntry::get_entry_type() const {
+    if (entry_kind.t == EntryType::Reference) {
+        return static_cast<const ReferenceDataEntry *>(this)->get_target_entry_type();
+    }
+    return entry_kind;
+}
+
+template <class Visitor>
+decltype(auto) DataEngineDataEntry::visit(Visitor &&visitor) {
+    switch (entry_kind.t) {
+        case EntryType::Bool:
+            return visitor(static_cast<BoolDataEntry &>(*this));
+        case EntryType::Text:
+            return visitor(static_cast<TextDataEntry &>(*this));
+        case EntryType::DateTime:
+            return visitor(static_cast<DateTimeDataEntry &>(*this));
+        case EntryType::Reference:
+            return visitor(static_cast<ReferenceDataEntry &>(*this));
+        case EntryType::Number:
+        case EntryType::Unspecified:
+            break;
+    }
+    assert(entry_kind.t == EntryType::Number);
+    return visitor(static_cast<NumericDataEntry &>(*this));
+}
+
+template <class Visitor>
+decltype(auto) DataEngineDataEntry::visit(Visitor &&visitor) const {
+    switch (entry_kind.t) {
+        case EntryType::Bool:
+            return visitor(static_cast<const BoolDataEntry &>(*this));
+        case EntryType::Text:
+            return visitor(static_cast<const TextDataEntry &>(*this));
+        case EntryType::DateTime:
+            return visitor(static_cast<const DateTimeDataEntry &>(*this));
+        case EntryType::Reference:
+            return visitor(static_cast<const ReferenceDataEntry &>(*this));
+        case EntryType::Number:
+        case EntryType::Unspecified:
+            break;
+    }
+    assert(entry_kind.t == EntryType::Number);
+    return visitor(static_cast<const NumericDataEntry &>(*this));
+}
+
 struct DependencyValue {
     DependencyValue();
     enum Match_style { MatchExactly, MatchByRange, MatchEverything, MatchNone };
@@ -519,20 +600,38 @@ struct DependencyValue {
     void from_number(const double &number);
     void from_bool(const bool &boolean);
     void parse_number(const QString &str, float &vnumber, bool &matcheverything);
+    void compile();
     QString serialised_string;
+
+    //precomputed by compile() once the value is parsed so is_matching does not convert and round for every test value
+    enum Exact_type { ExactDouble, ExactBool, ExactOther };
+    Exact_type exact_type = ExactDouble;
+    double rounded_exactly = 0;
+    double rounded_low_including = 0;
+    double rounded_high_excluding = 0;
 };
 
 struct DependencyTags {
     QMultiMap<QString, DependencyValue> tags;
 
+    struct KeyMatcher {
+        QString key;
+        std::vector<DependencyValue> values; //the key matches if any of them matches
+    };
+
     public:
     QString get_dependencies_serialised_string() const;
     void from_json(const QJsonValue &object);
+    const std::vector<KeyMatcher> &get_key_matchers() const;
+
+    private:
+    std::vector<KeyMatcher> key_matchers; //tags grouped by key in key order, built by from_json
 };
 
 struct VariantData {
     VariantData();
     VariantData(const VariantData &other);
+    VariantData(VariantData &&other) = default;
 
     // VariantData(const VariantData &) = delete;
     VariantData &operator=(const VariantData &) = delete;
@@ -554,16 +653,20 @@ struct VariantData {
     const QMap<QString, QVariant> &get_relevant_dependencies() const;
 
     private:
+    void append_entry(std::unique_ptr<DataEngineDataEntry> entry);
     QMap<QString, QVariant> relevant_dependencies;
+    QHash<QString, DataEngineDataEntry *> entry_index; //lowercase field name to entry, filled together with data_entries
 };
 
 struct DataEngineInstance {
     DataEngineInstance();
     DataEngineInstance(const DataEngineInstance &other);
-    DataEngineInstance(DataEngineInstance &&other); // move constructor
+    DataEngineInstance(DataEngineInstance &&other) noexcept; // move constructor
 
-    void delete_unmatched_variants(const QMap<QString, QList<QVariant>> &tags, uint instance_index, uint instance_count);
-    void delete_all_but_biggest_variants();
+    DataEngineInstance copy_without_variants() const;
+    //replace the variants by a copy of the ones of prototype that match
+    void select_matching_variant(DataEngineInstance &prototype, const QMap<QString, QList<QVariant>> &tags, uint instance_index, uint instance_count);
+    void select_biggest_variant(const DataEngineInstance &prototype);
     void set_section_name(QString section_name);
     void set_allow_empty_section(bool allow_empty_section);
     const VariantData *get_variant() const;
@@ -572,6 +675,7 @@ struct DataEngineInstance {
     QString instance_caption;
 
     private:
+    void use_selected_variants(const std::vector<const VariantData *> &selected_variants);
     QString section_name;
     bool allow_empty_section = false;
 };
@@ -616,8 +720,41 @@ struct DataEngineSection {
     bool section_uses_variants() const;
 
     QString get_serialised_dependency_string() const;
+    DataEngineDataEntry *get_entry(QString id) const;
+
+    //data_entry has to be an entry of this section
+    void set_entry_actual_number(DataEngineDataEntry *data_entry, const FormID &id, double number);
+    void set_entry_actual_text(DataEngineDataEntry *data_entry, const FormID &id, QString text);
+    void set_entry_actual_bool(DataEngineDataEntry *data_entry, const FormID &id, bool value);
+    void set_entry_actual_datetime(DataEngineDataEntry *data_entry, const FormID &id, DataEngineDateTime value);
 
     private:
+    //Number of incomplete and out of range entries of all instances, kept up to date by the set_entry_actual_* functions so is_complete and
+    //all_values_in_range do not have to ask every entry. References depend on other entries and are asked each time instead.
+    struct EntryStatusCounts {
+        EntryStatusCounts() = default;
+        //a copy would point to the references of the original section, it counts again on first use instead
+        EntryStatusCounts(const EntryStatusCounts &) {}
+        EntryStatusCounts(EntryStatusCounts &&) noexcept {}
+        EntryStatusCounts &operator=(const EntryStatusCounts &) {
+            invalidate();
+            return *this;
+        }
+        void invalidate() {
+            valid = false;
+            references.clear();
+        }
+
+        bool valid = false;
+        uint incomplete = 0;
+        uint out_of_range = 0;
+        std::vector<const DataEngineDataEntry *> references;
+    };
+    mutable EntryStatusCounts entry_status_counts;
+    const EntryStatusCounts &get_entry_status_counts() const;
+    template <class Setter>
+    void set_and_count(DataEngineDataEntry *data_entry, Setter &&setter);
+
     std::experimental::optional<uint> instance_count;
 
     QString section_title;
@@ -626,7 +763,6 @@ struct DataEngineSection {
     void append_variant_from_json(const QJsonObject &object);
     void assert_instance_is_defined() const;
     uint actual_instance_index = 0;
-    DataEngineDataEntry *get_entry(QString id) const;
     const DataEngineInstance *get_actual_instance() const;
 };
 
@@ -666,12 +802,51 @@ struct DataEngineSections {
 
     EntryType get_entry_type_dummy_mode(const FormID &id) const;
 
+    //changes whenever entries may have moved or the actual instance of a section changed, so resolved entries have to be looked up again
+    quint64 get_generation() const;
+
+    //replaces everything by a copy of prototype, the references of the copy point into the copy
+    void clone_from(const DataEngineSections &prototype);
+
     private:
     QList<const DataEngineDataEntry *> get_entries_raw(const FormID &id, DataEngineErrorNumber *error_num, DecodecFieldID &decoded_field_name,
                                                        bool using_instance_index, bool dummy_mode) const;
     DataEngineSection *get_section_raw(const QString &section_name, DataEngineErrorNumber *error_num) const;
     QMap<QString, QList<QVariant>> dependency_tags;
+    QHash<QString, std::size_t> section_index; //lowercase section name to position in sections, filled together with sections
     EntryType get_entry_type_dummy_mode_recursion(const FormID &id) const;
+    void new_generation();
+    quint64 generation = 0;
+    void build_reference_graph();
+    void deref_references_of_section(DataEngineSection &section);
+    //lowercase section name to the positions of the sections with references into that section
+    QHash<QString, std::vector<std::size_t>> referencing_sections;
+};
+
+class Data_engine;
+
+//A field of a data engine whose entry is looked up once and reused until the data engine's sections change
+class Data_engine_field {
+    public:
+    void set_actual_number(double number);
+    void set_actual_text(QString text);
+    void set_actual_bool(bool value);
+    double get_actual_number() const;
+    QString get_actual_value() const;
+    EntryType get_entry_type() const;
+    const FormID &get_id() const;
+
+    private:
+    friend class Data_engine;
+    Data_engine_field(Data_engine *data_engine, const FormID &id);
+    DataEngineDataEntry *get_entry() const;
+
+    Data_engine *data_engine;
+    FormID id;
+    mutable DataEngineSection *section = nullptr;
+    mutable DataEngineDataEntry *entry = nullptr;
+    mutable QString serialised_dependency;
+    mutable quint64 generation = 0;
 };
 /// \endcond
 
@@ -751,6 +926,9 @@ class Data_engine {
     void set_dependancy_tags(const QMap<QString, QList<QVariant>> &tags);
     void set_source(std::istream &source);
     void set_script_path(QString script_path);
+    //set_source copies the sections of recently loaded sources, tests and benchmarks of the loading itself turn that off or clear the cache
+    static void set_prototype_cache_enabled(bool enabled);
+    static void clear_prototype_cache();
 
     QString source_path;
 
@@ -1324,6 +1502,44 @@ The result will be documented in the final data dump as:
 */
 
 
+#ifdef DOXYGEN_ONLY
+    // this block is just for ducumentation purpose
+    field(string data_engine_field);
+#endif
+    /// \cond HIDDEN_SYMBOLS
+    Data_engine_field get_field(const FormID &id);
+    /// \endcond
+    // clang-format off
+/*! \fn field(string data_engine_field);
+    \brief Returns a handle of a data field for setting and reading its actual value repeatedly.
+    \param data_engine_field The datafield-ID
+    \returns a handle with the methods \c set(value) and \c get(). \c set accepts a number, a string or a bool like
+            set_actual_number(), set_actual_text() and set_actual_bool(). \c get returns the actual number of number fields
+            like get_actual_number() and the actual value as string like get_actual_value() otherwise.
+
+    The field is looked up only once instead of on every call. The handle follows use_instance() and
+    always refers to the field of the instance in use.
+
+     \par examples:
+     \code{.lua}
+    local SAVE_FILEPATH =
+        DATA_ENGINE_AUTO_DUMP_PATH..
+        "test_reports\\data_engine_and_report_1\\"..
+        tostring(device_serial_number).."\\"
+
+    local dependency_tags = {}
+    local data_engine = Data_engine.new("report_template.lrxml",
+            "desire_values_aka_data_engine_source.json",
+            SAVE_FILEPATH,dependency_tags)
+
+    local test_number = data_engine:field("desired_values/test_number")
+    test_number:set(0.101)
+    local number_result = test_number:get()
+    -- number_result is 101.0
+\endcode
+*/
+
+
 #ifdef DOXYGEN_ONLY
     // this block is just for ducumentation purpose
     set_actual_text(string data_engine_field, string value);
@@ -1443,6 +1659,23 @@ The result will be documented in the final data dump as:
 
 */
 
+#ifdef DOXYGEN_ONLY
+    // this block is just for ducumentation purpose
+    set_performance_counters_in_report(bool enable);
+#endif
+/*! \fn set_performance_counters_in_report(bool enable);
+    \brief Adds the performance counters of the current test run to the "general" block of the json data dump.
+    \param enable if true, the json dump contains a "performance_counters" object
+    \details The counters are the ones of the test run that loaded the desired values, counted from loading the desired values until the dump is written.
+    A data engine that was not loaded by a test run reports the process wide counters instead.
+    \sa get_performance_counters()
+
+     \code{.lua}
+    data_engine:set_performance_counters_in_report(true);
+\endcode
+
+*/
+
 #ifdef DOXYGEN_ONLY
     // this block is just for ducumentation purpose
     add_extra_pdf_path(string file_name);
@@ -2224,6 +2457,7 @@ finishes such a data dump file is generated anyways.
     bool section_uses_instances(QString section_name) const;
 
     void set_enable_auto_open_pdf(bool auto_open_pdf);
+    void set_enable_performance_counters_in_report(bool enable);
 
     bool do_exceptional_approval(ExceptionalApprovalDB &ea_db, QString field_id, QWidget *parent);
 
@@ -2231,6 +2465,7 @@ finishes such a data dump file is generated anyways.
     /// \endcond
     private:
     QString get_actual_value_raw(const FormID &id) const;
+    void load_sections(QByteArray data);
     void generate_pages(QXmlStreamWriter &xml, QString report_title, QString image_footer_path, QString image_header_path, QString approved_by_field_id,
                         QString static_text_report_header, QString static_text_page_header, QString static_text_page_footer,
                         QString static_text_report_footer_above_signature, QString static_text_report_footer_beneath_signature,
@@ -2266,11 +2501,15 @@ finishes such a data dump file is generated anyways.
                                                  TextFieldDataBandPlace actual_band_position) const;
     int generate_textfields(QXmlStreamWriter &xml, int y_start, const QList<PrintOrderItem> &print_order, TextFieldDataBandPlace actual_band_position) const;
     bool auto_open_pdf = false;
+    bool performance_counters_in_report = false;
+    Performance_counters::Run_context performance_counters_run;
+    Performance_counters::Snapshot load_time_performance_counters;
     void generate_exception_approval_table() const;
     void do_exceptional_approval_(ExceptionalApprovalDB &ea_db, QList<FailedField> failed_fields, QWidget *parent);
     int generate_static_text_field(QXmlStreamWriter &xml, int y_start, const QString static_text, TextFieldDataBandPlace actual_band_position) const;
     void assert_in_dummy_mode() const;
     std::unique_ptr<Communication_logger> logger;
+    friend class Data_engine_field;
     /// \endcond
 };
 /** \} */ // end of group data_engine
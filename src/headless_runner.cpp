@@ -0,0 +1,387 @@
+#include "headless_runner.h"
+#include "CommunicationDevices/comportcommunicationdevice.h"
+#include "Protocols/rpcprotocol.h"
+#include "Protocols/scpiprotocol.h"
+#include "Protocols/sg04countprotocol.h"
+#include "Windows/devicematcher.h"
+#include "Windows/mainwindow.h"
+#include "config.h"
+#include "console.h"
+#include "device_protocols_settings.h"
+#include "qt_util.h"
+#include "scpimetadata.h"
+#include "scriptengine.h"
+#include "util.h"
+
+#include <QApplication>
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QSerialPortInfo>
+#include <QSettings>
+#include <QThread>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cassert>
+#include <iostream>
+#include <stdexcept>
+
+//how long a script gets to react to the interrupt after its timeout before the runner gives up on it
+static const std::chrono::seconds interrupt_grace_period{10};
+
+struct Headless_runner::Warm_script {
+    Warm_script(const QString &script_name)
+        : script{std::make_unique<ScriptEngine>(nullptr, console, nullptr, script_name)} {
+        script->headless = true;
+        thread.adopt(*script);
+        thread.start();
+    }
+    ~Warm_script() {
+        thread.quit();
+        thread.message_queue_join();
+    }
+
+    Console console{nullptr};
+    std::unique_ptr<ScriptEngine> script;
+    //the script runs in its own thread while the main thread serves the calls the script makes to the GUI thread
+    Utility::Qt_thread thread;
+};
+
+struct Headless_runner::Discovered_device {
+    std::unique_ptr<CommunicationDevice> device;
+    std::unique_ptr<Protocol> protocol;
+    QString name;
+};
+
+Headless_runner::Headless_runner(QString log_directory, std::chrono::milliseconds script_timeout)
+    : log_directory{std::move(log_directory)}
+    , script_timeout{script_timeout} {
+    assert(MainWindow::mw == nullptr);
+    if (MainWindow::gui_thread == nullptr) {
+        MainWindow::gui_thread = QThread::currentThread();
+    }
+    QDir{}.mkpath(this->log_directory);
+    Console_handle::headless_output = [this](QPlainTextEdit *console, const QString &text) {
+        (void)console;
+        print(text);
+    };
+}
+
+Headless_runner::~Headless_runner() {
+    warm_scripts.clear();
+    devices.clear();
+    Console_handle::headless_output = nullptr;
+}
+
+void Headless_runner::discover_devices() {
+    assert(currently_in_gui_thread());
+    devices_discovered = true;
+    const auto device_protocol_settings_file = QSettings{}.value(Globals::device_protocols_file_settings_key, "").toString();
+    if (device_protocol_settings_file.isEmpty()) {
+        print("No device protocols file is set in Settings->Paths, no devices can be detected");
+        return;
+    }
+    const DeviceProtocolsSettings device_protocol_settings{device_protocol_settings_file};
+    DeviceMetaData device_meta_data;
+    device_meta_data.reload(QSettings{}.value(Globals::measurement_equipment_meta_data_path_key, "").toString());
+
+    for (const auto &port : QSerialPortInfo::availablePorts()) {
+        auto device = std::make_unique<ComportCommunicationDevice>();
+        auto try_protocols = [&port, &device](const QList<DeviceProtocolSetting> &settings, const QString &type_name,
+                                             const auto &make_protocol) -> std::unique_ptr<Protocol> {
+            for (auto &setting : settings) {
+                if (setting.type != DeviceProtocolSetting::comport || setting.match(port.portName()) == false) {
+                    continue;
+                }
+                QMap<QString, QVariant> port_info;
+                port_info.insert(HOST_NAME_TAG, port.portName());
+                port_info.insert(TYPE_NAME_TAG, type_name);
+                port_info.insert(BAUD_RATE_TAG, setting.baud);
+                port_info.insert(WAIT_AFTER_OPEN_TAG_ms,
+                                 QVariant::fromValue<long>(std::chrono::duration_cast<std::chrono::milliseconds>(setting.wait_after_open).count()));
+                if (device->connect(port_info) == false) {
+                    return nullptr;
+                }
+                if (auto protocol = make_protocol(setting)) {
+                    return protocol;
+                }
+                device->close();
+            }
+            return nullptr;
+        };
+        std::unique_ptr<Protocol> protocol;
+        QString name;
+        protocol = try_protocols(device_protocol_settings.protocols_rpc, "rpc", [&device, &name](const DeviceProtocolSetting &setting) {
+            auto protocol = std::make_unique<RPCProtocol>(*device, setting);
+            if (not protocol->is_correct_protocol()) {
+                return std::unique_ptr<RPCProtocol>{};
+            }
+            name = QString::fromStdString(protocol->get_name());
+            return protocol;
+        });
+        if (not protocol) {
+            protocol = try_protocols(device_protocol_settings.protocols_scpi, "scpi", [&device, &name, &device_meta_data](const DeviceProtocolSetting &setting) {
+                auto protocol = std::make_unique<SCPIProtocol>(*device, setting);
+                if (not protocol->is_correct_protocol()) {
+                    return std::unique_ptr<SCPIProtocol>{};
+                }
+                protocol->set_scpi_meta_data(
+                    device_meta_data.query(QString::fromStdString(protocol->get_serial_number()), QString::fromStdString(protocol->get_name())));
+                name = QString::fromStdString(protocol->get_name());
+                return protocol;
+            });
+        }
+        if (not protocol) {
+            protocol = try_protocols(device_protocol_settings.protocols_sg04_count, "sg04", [&device](const DeviceProtocolSetting &setting) {
+                auto protocol = std::make_unique<SG04CountProtocol>(*device, setting);
+                if (not protocol->is_correct_protocol()) {
+                    return std::unique_ptr<SG04CountProtocol>{};
+                }
+                return protocol;
+            });
+        }
+        if (protocol) {
+            print("Detected " + protocol->type + " device " + name + " on " + port.portName());
+            devices.push_back(Discovered_device{std::move(device), std::move(protocol), name});
+        }
+    }
+}
+
+std::optional<std::vector<MatchedDevice>> Headless_runner::match_devices(const std::vector<DeviceRequirements> &requirements, QString &message) {
+    //same rules as the DeviceMatcher, except that acceptance functions are not called and a device is never asked for interactively
+    if (not requirements.empty() && not devices_discovered) {
+        discover_devices();
+    }
+    std::vector<MatchedDevice> matched_devices;
+    for (const auto &requirement : requirements) {
+        int count = 0;
+        for (const auto &device : devices) {
+            if (count >= requirement.quantity_max) {
+                break;
+            }
+            if (device.protocol->type != requirement.protocol_name || not device.device->isConnected()) {
+                continue;
+            }
+            const bool name_match = requirement.device_names.isEmpty() || requirement.device_names.contains(device.name) ||
+                                    requirement.device_names.contains("*") || requirement.device_names.contains("");
+            if (not name_match) {
+                continue;
+            }
+            if (std::any_of(std::begin(matched_devices), std::end(matched_devices),
+                            [&device](const MatchedDevice &matched_device) { return matched_device.device == device.device.get(); })) {
+                continue;
+            }
+            if (auto scpi_protocol = dynamic_cast<SCPIProtocol *>(device.protocol.get())) {
+                if (scpi_protocol->get_approved_state() != DeviceMetaDataApprovedState::Approved) {
+                    print("SCPI device " + device.name + " is lacking approval, its approval state: " + scpi_protocol->get_approved_state_str());
+                    continue;
+                }
+            } else if (auto sg04_count_protocol = dynamic_cast<SG04CountProtocol *>(device.protocol.get())) {
+                if (not sg04_count_protocol->is_currently_receiving_counts()) {
+                    continue;
+                }
+            }
+            matched_devices.push_back(MatchedDevice{device.device.get(), device.protocol.get(), requirement.alias});
+            count++;
+        }
+        if (count < requirement.quantity_min) {
+            message = QString{R"(Requires %1 device(s) with protocol "%2" and the name "%3" but only %4 device(s) are available)"}
+                          .arg(requirement.quantity_min)
+                          .arg(requirement.protocol_name)
+                          .arg(requirement.device_names.join("/"))
+                          .arg(count);
+            return std::nullopt;
+        }
+    }
+    return matched_devices;
+}
+
+const Headless_runner::Script_result &Headless_runner::run_script(const QString &script_path) {
+    assert(currently_in_gui_thread());
+    results.emplace_back();
+    auto &result = results.back();
+    result.script_path = script_path;
+    const auto script_name = QFileInfo{script_path}.completeBaseName();
+    {
+        std::lock_guard<std::mutex> lock{log_mutex};
+        result.log_path =
+            QDir{log_directory}.filePath(script_name + "_" + QDateTime::currentDateTime().toString("yyyy_MM_dd_hh_mm_ss_zzz") + ".log");
+        log.setFileName(result.log_path);
+        if (not log.open(QIODevice::WriteOnly | QIODevice::Text)) {
+            qDebug() << "Failed opening log file" << result.log_path;
+        }
+    }
+    const auto start = std::chrono::steady_clock::now();
+    auto finish = Utility::RAII_do([this, &result, start] {
+        result.duration = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+        print(QString{get_name(result.result)}.toUpper() + ": " + result.script_path + " (" + QString::number(result.duration.count()) + " ms)" +
+              (result.message.isEmpty() ? "" : " " + result.message));
+        std::lock_guard<std::mutex> lock{log_mutex};
+        log.close();
+    });
+
+    auto &warm_script = warm_scripts[script_path];
+    if (not warm_script) {
+        warm_script = std::make_unique<Warm_script>(script_name);
+    }
+    auto &script = *warm_script->script;
+    //the state is shared with the script thread because a script that ignores its interrupt is abandoned while still running
+    struct Run_state {
+        std::vector<MatchedDevice> devices;
+        std::exception_ptr error;
+        std::atomic<bool> finished{false};
+    };
+    auto run_state = std::make_shared<Run_state>();
+    try {
+        script.load_script(script_path.toStdString());
+        auto matched_devices = match_devices(script.get_device_requirement_list(), result.message);
+        if (not matched_devices) {
+            result.result = Result::skipped;
+            return result;
+        }
+        run_state->devices = std::move(*matched_devices);
+    } catch (const std::exception &e) {
+        result.result = Result::failed;
+        result.message = e.what();
+        return result;
+    }
+
+    Utility::thread_call(&script, [&script, run_state] {
+        try {
+            script.run(run_state->devices);
+        } catch (...) {
+            run_state->error = std::current_exception();
+        }
+        run_state->finished = true;
+    });
+    bool timed_out = false;
+    auto interrupt_time = std::chrono::steady_clock::time_point{};
+    while (not run_state->finished) {
+        QApplication::processEvents();
+        QThread::currentThread()->msleep(16);
+        const auto now = std::chrono::steady_clock::now();
+        if (script_timeout.count() > 0 && not timed_out && now - start > script_timeout) {
+            timed_out = true;
+            interrupt_time = now;
+            warm_script->thread.requestInterruption();
+            script.post_interrupt("Timeout of " + QString::number(script_timeout.count()) + " ms exceeded");
+        }
+        if (timed_out && now - interrupt_time > interrupt_grace_period) {
+            break;
+        }
+    }
+
+    if (timed_out && not run_state->finished) {
+        result.result = Result::timed_out;
+        result.message = "Script did not stop within " + QString::number(interrupt_grace_period.count()) + " s after the timeout of " +
+                         QString::number(script_timeout.count()) + " ms";
+        //The script thread is stuck, so it can neither be joined nor can the script or its devices be destroyed while it may still use them.
+        //They are left to the operating system on exit and the devices are not given to later scripts.
+        for (const auto &matched_device : run_state->devices) {
+            auto device_it = std::find_if(std::begin(devices), std::end(devices),
+                                          [&matched_device](const Discovered_device &device) { return device.device.get() == matched_device.device; });
+            if (device_it != std::end(devices)) {
+                (void)device_it->device.release();
+                (void)device_it->protocol.release();
+                devices.erase(device_it);
+            }
+        }
+        (void)warm_script.release();
+        warm_scripts.erase(script_path);
+        return result;
+    }
+    result.performance_counters = script.get_run_performance_counters();
+
+    if (timed_out) {
+        result.result = Result::timed_out;
+        warm_scripts.erase(script_path); //the thread of an interrupted script cannot run anything anymore
+    } else if (run_state->error) {
+        result.result = Result::failed;
+        try {
+            std::rethrow_exception(run_state->error);
+        } catch (const std::exception &e) {
+            result.message = e.what();
+        } catch (...) {
+            result.message = "Unknown error";
+        }
+    }
+    return result;
+}
+
+const std::vector<Headless_runner::Script_result> &Headless_runner::get_results() const {
+    return results;
+}
+
+QJsonObject Headless_runner::get_report() const {
+    QJsonObject report;
+    QJsonArray scripts;
+    std::array<int, 4> result_counts{};
+    for (const auto &result : results) {
+        result_counts[static_cast<std::size_t>(result.result)]++;
+        QJsonObject script;
+        script["script"] = result.script_path;
+        script["result"] = get_name(result.result);
+        script["message"] = result.message;
+        script["log"] = result.log_path;
+        script["duration_ms"] = static_cast<double>(result.duration.count());
+        script["performance_counters"] = result.performance_counters.to_json();
+        scripts.append(script);
+    }
+    report["date"] = QDateTime::currentDateTime().toString(Qt::ISODate);
+    for (auto result : {Result::passed, Result::failed, Result::skipped, Result::timed_out}) {
+        report[get_name(result)] = result_counts[static_cast<std::size_t>(result)];
+    }
+    report["scripts"] = scripts;
+    return report;
+}
+
+void Headless_runner::save_report(const QString &report_path) const {
+    QFile file{report_path};
+    if (not file.open(QIODevice::WriteOnly)) {
+        throw std::runtime_error("Failed opening report file " + report_path.toStdString());
+    }
+    file.write(QJsonDocument{get_report()}.toJson());
+}
+
+int Headless_runner::get_exit_code() const {
+    int exit_code = 0;
+    for (const auto &result : results) {
+        switch (result.result) {
+            case Result::passed:
+                break;
+            case Result::failed:
+            case Result::timed_out:
+                return 1;
+            case Result::skipped:
+                exit_code = 3;
+                break;
+        }
+    }
+    return exit_code;
+}
+
+const char *Headless_runner::get_name(Headless_runner::Result result) {
+    switch (result) {
+        case Result::passed:
+            return "passed";
+        case Result::failed:
+            return "failed";
+        case Result::skipped:
+            return "skipped";
+        case Result::timed_out:
+            return "timed_out";
+    }
+    return "unknown";
+}
+
+void Headless_runner::print(const QString &text) {
+    std::lock_guard<std::mutex> lock{log_mutex};
+    if (log.isOpen()) {
+        log.write(text.toUtf8() + '\n');
+    }
+    std::cout << text.toStdString() << std::endl;
+}
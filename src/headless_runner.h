@@ -0,0 +1,69 @@
+#ifndef HEADLESS_RUNNER_H
+#define HEADLESS_RUNNER_H
+
+#include "export.h"
+#include "performance_counters.h"
+
+#include <QFile>
+#include <QJsonObject>
+#include <QString>
+#include <chrono>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+class CommunicationDevice;
+class DeviceRequirements;
+struct MatchedDevice;
+struct Protocol;
+
+//Runs scripts one after another without a MainWindow, for example for overnight regression runs.
+//Scripts get no user interface and no console widget. Their console output is written to a log file per script and to stdout.
+//The first script that requires devices detects the devices on the serial ports with the protocols of the device protocols file of the settings.
+//Requirements are matched automatically without calling acceptance functions, scripts whose requirements cannot be met are reported as skipped.
+//Scripts stay loaded between runs, so running the same script again only restores its globals instead of setting up a new Lua state.
+class EXPORT Headless_runner {
+    public:
+    enum class Result { passed, failed, skipped, timed_out };
+    struct Script_result {
+        QString script_path;
+        Result result = Result::passed;
+        QString message;
+        QString log_path;
+        std::chrono::milliseconds duration{};
+        Performance_counters::Snapshot performance_counters;
+    };
+
+    //a script_timeout of 0 lets scripts run as long as they want
+    Headless_runner(QString log_directory, std::chrono::milliseconds script_timeout);
+    ~Headless_runner();
+
+    const Script_result &run_script(const QString &script_path);
+    const std::vector<Script_result> &get_results() const;
+    QJsonObject get_report() const;
+    void save_report(const QString &report_path) const;
+    //0 if all scripts passed, 1 if a script failed or timed out, 3 if scripts were skipped but none failed
+    int get_exit_code() const;
+    static const char *get_name(Result result);
+
+    private:
+    void print(const QString &text);
+    void discover_devices();
+    //returns the devices for the requirements or nothing and the reason in message if they cannot be met
+    std::optional<std::vector<MatchedDevice>> match_devices(const std::vector<DeviceRequirements> &requirements, QString &message);
+
+    struct Warm_script;
+    std::map<QString, std::unique_ptr<Warm_script>> warm_scripts;
+    struct Discovered_device;
+    std::vector<Discovered_device> devices;
+    bool devices_discovered = false;
+    QString log_directory;
+    std::chrono::milliseconds script_timeout;
+    std::vector<Script_result> results;
+    std::mutex log_mutex;
+    QFile log;
+};
+
+#endif // HEADLESS_RUNNER_H
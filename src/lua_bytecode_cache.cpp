@@ -0,0 +1,166 @@
+#include "lua_bytecode_cache.h"
+
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QStandardPaths>
+
+static int write_chunk(lua_State *, const void *data, size_t size, void *bytecode) {
+    static_cast<std::string *>(bytecode)->append(static_cast<const char *>(data), size);
+    return 0;
+}
+
+//the bytecode format depends on the Lua version and the size of its types and the chunk stores the file path for error messages
+QByteArray Lua_bytecode_cache::get_key(const QString &path, const QByteArray &source) {
+    QCryptographicHash hash{QCryptographicHash::Sha1};
+    hash.addData(LUA_VERSION_RELEASE);
+    hash.addData(QByteArray::number(static_cast<int>(sizeof(void *) * 100 + sizeof(lua_Integer) * 10 + sizeof(lua_Number))));
+    hash.addData(path.toUtf8());
+    hash.addData(QByteArray(1, '\0'));
+    hash.addData(source);
+    return hash.result().toHex();
+}
+
+//luaL_loadfile skips a byte order mark and a first line starting with '#', keep the line break so the line numbers stay the same
+static void skip_file_header(QByteArray &source) {
+    if (source.startsWith("\xEF\xBB\xBF")) {
+        source.remove(0, 3);
+    }
+    if (source.startsWith('#')) {
+        const auto line_end = source.indexOf('\n');
+        source.remove(0, line_end == -1 ? source.size() : line_end);
+    }
+}
+
+static sol::protected_function pop_function(lua_State *L) {
+    sol::protected_function function{L, -1};
+    lua_pop(L, 1);
+    return function;
+}
+
+Lua_bytecode_cache &Lua_bytecode_cache::get() {
+    static Lua_bytecode_cache cache{QDir{QStandardPaths::writableLocation(QStandardPaths::CacheLocation)}.filePath("lua_bytecode")};
+    return cache;
+}
+
+Lua_bytecode_cache::Lua_bytecode_cache(QString directory, std::size_t max_memory_size, int max_file_age_days)
+    : max_memory_size{max_memory_size}
+    , directory{std::move(directory)} {
+    prune_files(max_file_age_days);
+}
+
+sol::protected_function Lua_bytecode_cache::load_file(sol::state &lua, const QString &path) {
+    QFile file{path};
+    if (not file.open(QIODevice::ReadOnly)) {
+        throw sol::error("cannot open " + path.toStdString() + ": " + file.errorString().toStdString());
+    }
+    auto source = file.readAll();
+    file.close();
+
+    lua_State *L = lua.lua_state();
+    const auto key = get_key(path, source);
+    const auto chunk_name = "@" + path.toStdString();
+    if (const auto bytecode = find(key)) {
+        if (luaL_loadbufferx(L, bytecode->data(), bytecode->size(), chunk_name.c_str(), "b") == LUA_OK) {
+            return pop_function(L);
+        }
+        qDebug() << "Discarding unloadable bytecode of" << path << lua_tostring(L, -1);
+        lua_pop(L, 1);
+    }
+
+    skip_file_header(source);
+    if (luaL_loadbufferx(L, source.data(), static_cast<size_t>(source.size()), chunk_name.c_str(), nullptr) != LUA_OK) {
+        std::string message = lua_tostring(L, -1);
+        lua_pop(L, 1);
+        throw sol::error(message);
+    }
+    std::string bytecode;
+    if (lua_dump(L, write_chunk, &bytecode, 0) == 0) {
+        insert(key, std::move(bytecode));
+    }
+    return pop_function(L);
+}
+
+sol::protected_function_result Lua_bytecode_cache::script_file(sol::state &lua, const QString &path) {
+    auto result = load_file(lua, path)();
+    if (not result.valid()) {
+        sol::error error = result;
+        throw error;
+    }
+    return result;
+}
+
+std::optional<std::string> Lua_bytecode_cache::find(const QByteArray &key) {
+    {
+        std::lock_guard<std::mutex> lock{chunks_mutex};
+        auto it = chunk_positions.find(key);
+        if (it != std::end(chunk_positions)) {
+            chunks.splice(std::begin(chunks), chunks, it->second);
+            return it->second->second;
+        }
+    }
+    QFile file{get_file_path(key)};
+    if (not file.open(QIODevice::ReadOnly)) {
+        return std::nullopt;
+    }
+    const auto data = file.readAll();
+    file.close();
+#if QT_VERSION >= QT_VERSION_CHECK(5, 10, 0)
+    //the modification time tells prune_files when the chunk was used last
+    if (file.open(QIODevice::Append)) {
+        file.setFileTime(QDateTime::currentDateTime(), QFileDevice::FileModificationTime);
+    }
+#endif
+    std::string bytecode{data.data(), static_cast<std::size_t>(data.size())};
+    std::lock_guard<std::mutex> lock{chunks_mutex};
+    keep_in_memory(key, bytecode);
+    return bytecode;
+}
+
+void Lua_bytecode_cache::insert(const QByteArray &key, std::string bytecode) {
+    //the file name is the key, so concurrent writers of the same chunk write the same content and old chunks never need to be invalidated
+    QDir{}.mkpath(directory);
+    QSaveFile file{get_file_path(key)};
+    if (file.open(QIODevice::WriteOnly)) {
+        file.write(bytecode.data(), static_cast<qint64>(bytecode.size()));
+        if (not file.commit()) {
+            qDebug() << "Failed writing Lua bytecode cache file" << file.fileName() << file.errorString();
+        }
+    }
+    std::lock_guard<std::mutex> lock{chunks_mutex};
+    keep_in_memory(key, std::move(bytecode));
+}
+
+void Lua_bytecode_cache::keep_in_memory(const QByteArray &key, std::string bytecode) {
+    auto it = chunk_positions.find(key);
+    if (it != std::end(chunk_positions)) { //another thread loaded the same chunk in the meantime
+        chunks.splice(std::begin(chunks), chunks, it->second);
+        return;
+    }
+    memory_size += bytecode.size();
+    chunks.emplace_front(key, std::move(bytecode));
+    chunk_positions[key] = std::begin(chunks);
+    while (memory_size > max_memory_size) {
+        auto &[oldest_key, oldest_bytecode] = chunks.back();
+        memory_size -= oldest_bytecode.size();
+        chunk_positions.erase(oldest_key);
+        chunks.pop_back();
+    }
+}
+
+void Lua_bytecode_cache::prune_files(int max_file_age_days) {
+    const auto oldest_allowed = QDateTime::currentDateTime().addDays(-max_file_age_days);
+    for (const auto &file_info : QDir{directory}.entryInfoList(QStringList{} << "*.luac", QDir::Files)) {
+        if (file_info.lastModified() < oldest_allowed && not QFile::remove(file_info.filePath())) {
+            qDebug() << "Failed removing stale Lua bytecode cache file" << file_info.filePath();
+        }
+    }
+}
+
+QString Lua_bytecode_cache::get_file_path(const QByteArray &key) const {
+    return QDir{directory}.filePath(QString::fromLatin1(key) + ".luac");
+}
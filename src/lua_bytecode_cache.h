@@ -0,0 +1,48 @@
+#ifndef LUA_BYTECODE_CACHE_H
+#define LUA_BYTECODE_CACHE_H
+
+#include <QByteArray>
+#include <QString>
+#include <cstddef>
+#include <list>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <sol.hpp>
+#include <string>
+#include <utility>
+
+//Cache of compiled Lua chunks, so scripts and the libraries they require are parsed once per change instead of once per run and DUT.
+//Chunks are keyed by the Lua version, the file path and the file content. They are kept in memory and in the cache directory, so they survive restarts.
+//The bytecode keeps its debug information, so error messages and line numbers are the same as when loading the source.
+class Lua_bytecode_cache {
+    public:
+    static Lua_bytecode_cache &get();
+    //the least recently used chunks are dropped from memory once they take more than max_memory_size bytes
+    //cache files that were not used for max_file_age_days are deleted when the cache is created
+    Lua_bytecode_cache(QString directory, std::size_t max_memory_size = 32 * 1024 * 1024, int max_file_age_days = 30);
+
+    //loads the file as a function without running it, throws sol::error if the file cannot be read or compiled
+    sol::protected_function load_file(sol::state &lua, const QString &path);
+    //replacement for sol::state::script_file that uses the cache
+    sol::protected_function_result script_file(sol::state &lua, const QString &path);
+
+    private:
+    friend class TestScriptEngine;
+
+    static QByteArray get_key(const QString &path, const QByteArray &source);
+    std::optional<std::string> find(const QByteArray &key);
+    void insert(const QByteArray &key, std::string bytecode);
+    void keep_in_memory(const QByteArray &key, std::string bytecode); //requires chunks_mutex to be locked
+    void prune_files(int max_file_age_days);
+    QString get_file_path(const QByteArray &key) const;
+
+    std::list<std::pair<QByteArray, std::string>> chunks; //most recently used first
+    std::map<QByteArray, decltype(chunks)::iterator> chunk_positions;
+    std::size_t memory_size = 0;
+    std::size_t max_memory_size;
+    std::mutex chunks_mutex;
+    QString directory;
+};
+
+#endif // LUA_BYTECODE_CACHE_H
@@ -0,0 +1,185 @@
+#include "performance_counters.h"
+
+#include <QJsonValue>
+#include <algorithm>
+
+struct Performance_counters::Run_counters {
+    struct Atomic_histogram {
+        std::atomic<std::uint64_t> count{0};
+        std::atomic<std::uint64_t> total_us{0};
+        std::array<std::atomic<std::uint64_t>, histogram_bucket_count> buckets{};
+    };
+
+    std::array<std::atomic<std::uint64_t>, static_cast<std::size_t>(Performance_counters::Counter::count)> counters{};
+    std::array<Atomic_histogram, static_cast<std::size_t>(Performance_counters::Histogram::count)> histograms{};
+
+    void add(Counter counter, std::uint64_t value) {
+        counters[static_cast<std::size_t>(counter)].fetch_add(value, std::memory_order_relaxed);
+    }
+    void record(Histogram histogram, std::uint64_t us, std::size_t bucket) {
+        auto &h = histograms[static_cast<std::size_t>(histogram)];
+        h.count.fetch_add(1, std::memory_order_relaxed);
+        h.total_us.fetch_add(us, std::memory_order_relaxed);
+        h.buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+    }
+    Snapshot get_snapshot() const {
+        Snapshot snapshot;
+        for (std::size_t i = 0; i < counters.size(); i++) {
+            snapshot.counters[i] = counters[i].load(std::memory_order_relaxed);
+        }
+        for (std::size_t i = 0; i < histograms.size(); i++) {
+            snapshot.histograms[i].count = histograms[i].count.load(std::memory_order_relaxed);
+            snapshot.histograms[i].total_us = histograms[i].total_us.load(std::memory_order_relaxed);
+            for (std::size_t bucket = 0; bucket < histogram_bucket_count; bucket++) {
+                snapshot.histograms[i].buckets[bucket] = histograms[i].buckets[bucket].load(std::memory_order_relaxed);
+            }
+        }
+        return snapshot;
+    }
+};
+
+namespace {
+    Performance_counters::Run_counters process_counters;
+    thread_local Performance_counters::Run_context bound_run;
+
+    std::size_t get_bucket(std::uint64_t us) {
+        std::size_t bucket = 0;
+        while (bucket < Performance_counters::histogram_bucket_count - 1 && (std::uint64_t{1} << bucket) <= us) {
+            bucket++;
+        }
+        return bucket;
+    }
+} // namespace
+
+const char *Performance_counters::get_name(Counter counter) {
+    switch (counter) {
+        case Counter::bytes_sent:
+            return "bytes_sent";
+        case Counter::bytes_received:
+            return "bytes_received";
+        case Counter::rpc_transactions:
+            return "rpc_transactions";
+        case Counter::rpc_timeouts:
+            return "rpc_timeouts";
+        case Counter::rpc_retries:
+            return "rpc_retries";
+        case Counter::scpi_transactions:
+            return "scpi_transactions";
+        case Counter::scpi_timeouts:
+            return "scpi_timeouts";
+        case Counter::data_engine_values_set:
+            return "data_engine_values_set";
+        case Counter::count:
+            break;
+    }
+    return "unknown";
+}
+
+const char *Performance_counters::get_name(Histogram histogram) {
+    switch (histogram) {
+        case Histogram::await_timeout_ms:
+            return "await_timeout_ms";
+        case Histogram::gui_call_ms:
+            return "gui_call_ms";
+        case Histogram::rpc_transaction_ms:
+            return "rpc_transaction_ms";
+        case Histogram::scpi_transaction_ms:
+            return "scpi_transaction_ms";
+        case Histogram::pdf_generation_ms:
+            return "pdf_generation_ms";
+        case Histogram::count:
+            break;
+    }
+    return "unknown";
+}
+
+Performance_counters::Run_context Performance_counters::create_run() {
+    return std::make_shared<Run_counters>();
+}
+
+Performance_counters::Run_context Performance_counters::current_run() {
+    return bound_run;
+}
+
+Performance_counters::Run_binding::Run_binding(Run_context context)
+    : previous_context{std::move(bound_run)} {
+    bound_run = std::move(context);
+}
+
+Performance_counters::Run_binding::~Run_binding() {
+    bound_run = std::move(previous_context);
+}
+
+void Performance_counters::add(Counter counter, std::uint64_t value) {
+    process_counters.add(counter, value);
+    if (bound_run) {
+        bound_run->add(counter, value);
+    }
+}
+
+void Performance_counters::record(Histogram histogram, std::chrono::steady_clock::duration duration) {
+    const auto us = static_cast<std::uint64_t>(std::max<long long>(0, std::chrono::duration_cast<std::chrono::microseconds>(duration).count()));
+    const auto bucket = get_bucket(us);
+    process_counters.record(histogram, us, bucket);
+    if (bound_run) {
+        bound_run->record(histogram, us, bucket);
+    }
+}
+
+Performance_counters::Snapshot Performance_counters::get_snapshot() {
+    return process_counters.get_snapshot();
+}
+
+Performance_counters::Snapshot Performance_counters::get_snapshot(const Run_context &run) {
+    return run ? run->get_snapshot() : Snapshot{};
+}
+
+double Performance_counters::Histogram_data::percentile_ms(double percentile) const {
+    if (count == 0) {
+        return 0;
+    }
+    const auto threshold = percentile / 100. * count;
+    std::uint64_t seen = 0;
+    for (std::size_t bucket = 0; bucket < histogram_bucket_count; bucket++) {
+        seen += buckets[bucket];
+        if (seen >= threshold) {
+            //upper bound of the bucket
+            return (std::uint64_t{1} << bucket) / 1000.;
+        }
+    }
+    return (std::uint64_t{1} << (histogram_bucket_count - 1)) / 1000.;
+}
+
+Performance_counters::Snapshot Performance_counters::Snapshot::operator-(const Snapshot &other) const {
+    Snapshot result;
+    for (std::size_t i = 0; i < counters.size(); i++) {
+        result.counters[i] = counters[i] - other.counters[i];
+    }
+    for (std::size_t i = 0; i < histograms.size(); i++) {
+        result.histograms[i].count = histograms[i].count - other.histograms[i].count;
+        result.histograms[i].total_us = histograms[i].total_us - other.histograms[i].total_us;
+        for (std::size_t bucket = 0; bucket < histogram_bucket_count; bucket++) {
+            result.histograms[i].buckets[bucket] = histograms[i].buckets[bucket] - other.histograms[i].buckets[bucket];
+        }
+    }
+    return result;
+}
+
+QJsonObject Performance_counters::Snapshot::to_json() const {
+    QJsonObject result;
+    for (std::size_t i = 0; i < counters.size(); i++) {
+        result[get_name(static_cast<Counter>(i))] = static_cast<double>(counters[i]);
+    }
+    for (std::size_t i = 0; i < histograms.size(); i++) {
+        const auto &histogram = histograms[i];
+        QJsonObject jo_histogram;
+        jo_histogram["count"] = static_cast<double>(histogram.count);
+        jo_histogram["total"] = histogram.total_us / 1000.;
+        jo_histogram["mean"] = histogram.count ? histogram.total_us / 1000. / histogram.count : 0.;
+        jo_histogram["p50"] = histogram.percentile_ms(50);
+        jo_histogram["p90"] = histogram.percentile_ms(90);
+        jo_histogram["p99"] = histogram.percentile_ms(99);
+        result[get_name(static_cast<Histogram>(i))] = jo_histogram;
+    }
+    return result;
+}
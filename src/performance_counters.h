@@ -0,0 +1,99 @@
+#ifndef PERFORMANCE_COUNTERS_H
+#define PERFORMANCE_COUNTERS_H
+
+#include <QJsonObject>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+
+//Counters and duration histograms fed by the communication devices, protocols, the data engine and the script engine.
+//Updating a counter is a relaxed atomic add to the process wide values and to the values of the run the calling thread is bound to, so they
+//can stay enabled in production. A test run creates its Run_context and binds the threads that work for it with Run_binding, so runs that
+//execute in parallel do not count each other's traffic.
+namespace Performance_counters {
+    enum class Counter {
+        bytes_sent,
+        bytes_received,
+        rpc_transactions,
+        rpc_timeouts,
+        rpc_retries,
+        scpi_transactions,
+        scpi_timeouts,
+        data_engine_values_set,
+        count
+    };
+
+    enum class Histogram {
+        await_timeout_ms,
+        gui_call_ms,
+        rpc_transaction_ms,
+        scpi_transaction_ms,
+        pdf_generation_ms,
+        count
+    };
+
+    //bucket i counts durations below 2^i microseconds, the last bucket counts everything above
+    constexpr std::size_t histogram_bucket_count = 32;
+
+    struct Histogram_data {
+        std::uint64_t count = 0;
+        std::uint64_t total_us = 0;
+        std::array<std::uint64_t, histogram_bucket_count> buckets{};
+
+        double percentile_ms(double percentile) const;
+    };
+
+    struct Snapshot {
+        std::array<std::uint64_t, static_cast<std::size_t>(Counter::count)> counters{};
+        std::array<Histogram_data, static_cast<std::size_t>(Histogram::count)> histograms{};
+
+        Snapshot operator-(const Snapshot &other) const;
+        QJsonObject to_json() const;
+    };
+
+    const char *get_name(Counter counter);
+    const char *get_name(Histogram histogram);
+
+    struct Run_counters;
+    using Run_context = std::shared_ptr<Run_counters>;
+    Run_context create_run();
+    //the run the calling thread counts for, empty if there is none
+    Run_context current_run();
+
+    //counts the calling thread's values for context until destruction
+    struct Run_binding {
+        Run_binding(Run_context context);
+        ~Run_binding();
+        Run_binding(const Run_binding &) = delete;
+        Run_binding &operator=(const Run_binding &) = delete;
+
+        private:
+        Run_context previous_context;
+    };
+
+    void add(Counter counter, std::uint64_t value = 1);
+    void record(Histogram histogram, std::chrono::steady_clock::duration duration);
+    //process wide values
+    Snapshot get_snapshot();
+    //values of a run, all 0 if run is empty
+    Snapshot get_snapshot(const Run_context &run);
+
+    //records the lifetime of the object into a histogram
+    struct Scoped_timer {
+        Scoped_timer(Histogram histogram)
+            : histogram{histogram} {}
+        ~Scoped_timer() {
+            record(histogram, std::chrono::steady_clock::now() - start);
+        }
+        Scoped_timer(const Scoped_timer &) = delete;
+        Scoped_timer &operator=(const Scoped_timer &) = delete;
+
+        private:
+        Histogram histogram;
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    };
+} // namespace Performance_counters
+
+#endif // PERFORMANCE_COUNTERS_H
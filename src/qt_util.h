@@ -1,6 +1,9 @@
 #ifndef QT_UTIL_H
 #define QT_UTIL_H
 
+#include "performance_counters.h"
+#include "tracing.h"
+
 #include <QApplication>
 #include <QCoreApplication>
 #include <QDebug>
@@ -86,6 +89,9 @@ namespace Utility {
 
     template <typename Fun>
     void thread_call(QObject *obj, Fun &&fun, ScriptEngine *script_engine_to_terminate_on_exception) {
+        if (obj == nullptr) { //headless runs have no MainWindow, calls meant for the GUI thread go to the main thread instead
+            obj = qApp;
+        }
         if (not obj->thread()) {
             if (not qApp || (qApp->thread() != QThread::currentThread())) {
                 throw std::runtime_error{"Internal error: Trying to thread_call on object not associated with a thread outside of main thread"};
@@ -128,6 +134,8 @@ namespace Utility {
 
     template <class Fun>
     auto promised_thread_call(QObject *object, Fun &&f) -> decltype(f()) {
+        TRACE_SCOPE("Utility::promised_thread_call");
+        const Performance_counters::Scoped_timer timer{Performance_counters::Histogram::gui_call_ms};
         std::promise<decltype(f())> promise;
         auto future = promise.get_future();
         thread_call(object, [lf = std::forward<Fun>(f), promise = std::move(promise)]() mutable {
@@ -0,0 +1,55 @@
+#include "script_executor.h"
+#include "config.h"
+
+#include <QSettings>
+#include <QThread>
+#include <algorithm>
+
+Script_executor &Script_executor::get() {
+    auto &executor = get_instance();
+    if (not executor) {
+        executor.reset(new Script_executor{static_cast<std::size_t>(
+            std::max(1, QSettings{}.value(Globals::script_executor_thread_count_key, QThread::idealThreadCount()).toInt()))});
+    }
+    return *executor;
+}
+
+void Script_executor::shutdown() {
+    get_instance().reset();
+}
+
+std::unique_ptr<Script_executor> &Script_executor::get_instance() {
+    static std::unique_ptr<Script_executor> executor; //only accessed by the GUI thread
+    return executor;
+}
+
+Script_executor::Script_executor(std::size_t thread_count) {
+    for (std::size_t i = 0; i < thread_count; i++) {
+        workers.push_back(std::make_unique<Worker>());
+        workers.back()->thread.start();
+    }
+}
+
+Script_executor::~Script_executor() {
+    for (auto &worker : workers) {
+        worker->thread.quit();
+    }
+    for (auto &worker : workers) {
+        worker->thread.wait();
+    }
+}
+
+std::size_t Script_executor::adopt(QObject &object) {
+    std::lock_guard<std::mutex> lock{workers_mutex};
+    const auto least_loaded = std::min_element(std::begin(workers), std::end(workers), [](const auto &lhs, const auto &rhs) { return lhs->load < rhs->load; });
+    (*least_loaded)->load++;
+    (*least_loaded)->thread.adopt(object);
+    return static_cast<std::size_t>(least_loaded - std::begin(workers));
+}
+
+void Script_executor::release(std::size_t worker_index) {
+    std::lock_guard<std::mutex> lock{workers_mutex};
+    assert(worker_index < workers.size());
+    assert(workers[worker_index]->load > 0);
+    workers[worker_index]->load--;
+}
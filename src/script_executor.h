@@ -0,0 +1,36 @@
+#ifndef SCRIPT_EXECUTOR_H
+#define SCRIPT_EXECUTOR_H
+
+#include "qt_util.h"
+
+#include <memory>
+#include <mutex>
+#include <vector>
+
+//A small fixed set of worker threads shared by all TestRunners that run in cooperative mode.
+//Cooperative scripts yield back to the worker's event loop whenever they sleep, so many scripts can share one thread.
+class Script_executor {
+    public:
+    static Script_executor &get();
+    //stops the worker threads, must be called before the QApplication is destroyed. get creates a new executor afterwards.
+    static void shutdown();
+    ~Script_executor();
+
+    //moves object to the least loaded worker thread and returns the index of that worker
+    std::size_t adopt(QObject &object);
+    //must be called once for every adopt after the object left the worker thread
+    void release(std::size_t worker_index);
+
+    private:
+    Script_executor(std::size_t thread_count);
+    static std::unique_ptr<Script_executor> &get_instance();
+
+    struct Worker {
+        Utility::Qt_thread thread;
+        std::size_t load = 0;
+    };
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::mutex workers_mutex;
+};
+
+#endif // SCRIPT_EXECUTOR_H
@@ -0,0 +1,230 @@
+#include "script_metadata_cache.h"
+#include "config.h"
+#include "vc.h"
+
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSettings>
+#include <QStandardPaths>
+
+//increase when the format or the meaning of the cached values changes
+static constexpr int cache_version = 2;
+
+static QByteArray get_hash(const QString &path) {
+    QFile file{path};
+    if (not file.open(QIODevice::ReadOnly)) {
+        return {};
+    }
+    QCryptographicHash hash{QCryptographicHash::Sha1};
+    hash.addData(&file);
+    return hash.result().toHex();
+}
+
+//validation results depend on the luacheck installation and requirements depend on the framework, so both invalidate the whole cache
+static QString get_cache_key() {
+    return QString::number(cache_version) + ";0x" + QString::number(GITHASH, 16) + ";" + QSettings{}.value(Globals::path_to_luacheck_key, "").toString();
+}
+
+static QJsonObject to_json(const DeviceRequirements &requirement) {
+    QJsonObject object;
+    object["protocol_name"] = requirement.protocol_name;
+    object["device_names"] = QJsonArray::fromStringList(requirement.device_names);
+    object["quantity_min"] = requirement.quantity_min;
+    object["quantity_max"] = requirement.quantity_max;
+    object["alias"] = requirement.alias;
+    object["has_acceptance_function"] = requirement.has_acceptance_function;
+    return object;
+}
+
+static DeviceRequirements device_requirements_from_json(const QJsonObject &object) {
+    DeviceRequirements requirement;
+    requirement.protocol_name = object["protocol_name"].toString();
+    for (const auto &device_name : object["device_names"].toArray()) {
+        requirement.device_names << device_name.toString();
+    }
+    requirement.quantity_min = object["quantity_min"].toInt();
+    requirement.quantity_max = object["quantity_max"].toInt();
+    requirement.alias = object["alias"].toString();
+    requirement.has_acceptance_function = object["has_acceptance_function"].toBool();
+    return requirement;
+}
+
+Script_metadata_cache &Script_metadata_cache::get() {
+    static Script_metadata_cache cache{QDir{QStandardPaths::writableLocation(QStandardPaths::CacheLocation)}.filePath("script_metadata_cache.json")};
+    return cache;
+}
+
+static QJsonObject to_json(const QString &path, qint64 modification_time_ms, qint64 size, const QByteArray &hash) {
+    QJsonObject object;
+    object["path"] = path;
+    object["modification_time_ms"] = static_cast<double>(modification_time_ms);
+    object["size"] = static_cast<double>(size);
+    object["hash"] = QString::fromLatin1(hash);
+    return object;
+}
+
+Script_metadata_cache::Script_metadata_cache(QString file_path)
+    : file_path{std::move(file_path)} {
+    QFile file{file_path};
+    if (not file.open(QIODevice::ReadOnly)) {
+        return;
+    }
+    const auto document = QJsonDocument::fromJson(file.readAll()).object();
+    if (document["key"].toString() != get_cache_key()) {
+        return;
+    }
+    auto file_state_from_json = [](const QString &path, const QJsonObject &object) {
+        File_state state;
+        state.path = path;
+        state.modification_time_ms = static_cast<qint64>(object["modification_time_ms"].toDouble());
+        state.size = static_cast<qint64>(object["size"].toDouble());
+        state.hash = object["hash"].toString().toLatin1();
+        return state;
+    };
+    const auto scripts = document["scripts"].toObject();
+    for (auto it = std::begin(scripts); it != std::end(scripts); ++it) {
+        const auto script = it.value().toObject();
+        Entry entry;
+        entry.script = file_state_from_json(it.key(), script);
+        for (const auto &message : script["validation_messages"].toArray()) {
+            entry.metadata.validation_messages << message.toString();
+        }
+        for (const auto &requirement : script["device_requirements"].toArray()) {
+            entry.metadata.device_requirements.push_back(device_requirements_from_json(requirement.toObject()));
+        }
+        for (const auto &required_file : script["required_files"].toArray()) {
+            const auto object = required_file.toObject();
+            entry.required_files.push_back(file_state_from_json(object["path"].toString(), object));
+            entry.metadata.required_files << entry.required_files.back().path;
+        }
+        entries[it.key()] = std::move(entry);
+    }
+}
+
+std::optional<Script_metadata_cache::File_state> Script_metadata_cache::get_file_state(const QString &path) {
+    const QFileInfo file_info{path};
+    File_state state;
+    state.path = file_info.absoluteFilePath();
+    state.modification_time_ms = file_info.lastModified().toMSecsSinceEpoch();
+    state.size = file_info.size();
+    state.hash = get_hash(state.path);
+    if (state.hash.isEmpty()) {
+        return std::nullopt;
+    }
+    return state;
+}
+
+bool Script_metadata_cache::is_unchanged(File_state &state, bool &touched) {
+    const QFileInfo file_info{state.path};
+    const auto modification_time_ms = file_info.lastModified().toMSecsSinceEpoch();
+    if (state.modification_time_ms == modification_time_ms && state.size == file_info.size()) {
+        return true;
+    }
+    //the file was touched, for example by a checkout, but the content may still be the same
+    const auto hash = get_hash(state.path);
+    if (hash.isEmpty() || hash != state.hash) {
+        return false;
+    }
+    state.modification_time_ms = modification_time_ms;
+    state.size = file_info.size();
+    touched = true;
+    return true;
+}
+
+std::optional<Script_metadata> Script_metadata_cache::find(const QString &script_path) {
+    const auto absolute_path = QFileInfo{script_path}.absoluteFilePath();
+    std::unique_lock<std::mutex> lock{entries_mutex};
+    auto it = entries.find(absolute_path);
+    if (it == std::end(entries)) {
+        return std::nullopt;
+    }
+    auto entry = it->second;
+    //hashing touched files takes a while, so it is done without holding the lock
+    lock.unlock();
+    bool touched = false;
+    if (not is_unchanged(entry.script, touched)) {
+        return std::nullopt;
+    }
+    for (auto &required_file : entry.required_files) {
+        if (not is_unchanged(required_file, touched)) {
+            return std::nullopt;
+        }
+    }
+    if (touched) {
+        lock.lock();
+        it = entries.find(absolute_path);
+        if (it != std::end(entries) && it->second.script.hash == entry.script.hash) {
+            it->second = entry;
+            modified = true;
+        }
+    }
+    return std::move(entry.metadata);
+}
+
+void Script_metadata_cache::insert(const QString &script_path, Script_metadata metadata) {
+    Entry entry;
+    auto script_state = get_file_state(script_path);
+    if (not script_state) {
+        return;
+    }
+    entry.script = std::move(*script_state);
+    for (const auto &required_file : metadata.required_files) {
+        auto required_file_state = get_file_state(required_file);
+        if (not required_file_state) {
+            return;
+        }
+        entry.required_files.push_back(std::move(*required_file_state));
+    }
+    entry.metadata = std::move(metadata);
+    std::lock_guard<std::mutex> lock{entries_mutex};
+    entries[entry.script.path] = std::move(entry);
+    modified = true;
+}
+
+void Script_metadata_cache::remove(const QString &script_path) {
+    std::lock_guard<std::mutex> lock{entries_mutex};
+    modified |= entries.erase(QFileInfo{script_path}.absoluteFilePath()) > 0;
+}
+
+void Script_metadata_cache::save() {
+    QJsonObject scripts;
+    {
+        std::lock_guard<std::mutex> lock{entries_mutex};
+        if (not modified) {
+            return;
+        }
+        for (const auto &[path, entry] : entries) {
+            auto script = to_json(path, entry.script.modification_time_ms, entry.script.size, entry.script.hash);
+            script["validation_messages"] = QJsonArray::fromStringList(entry.metadata.validation_messages);
+            QJsonArray requirements;
+            for (const auto &requirement : entry.metadata.device_requirements) {
+                requirements.append(to_json(requirement));
+            }
+            script["device_requirements"] = requirements;
+            QJsonArray required_files;
+            for (const auto &required_file : entry.required_files) {
+                required_files.append(to_json(required_file.path, required_file.modification_time_ms, required_file.size, required_file.hash));
+            }
+            script["required_files"] = required_files;
+            scripts[path] = script;
+        }
+        modified = false;
+    }
+    QJsonObject document;
+    document["key"] = get_cache_key();
+    document["scripts"] = scripts;
+    QDir{}.mkpath(QFileInfo{file_path}.absolutePath());
+    QFile file{file_path};
+    if (not file.open(QIODevice::WriteOnly)) {
+        qDebug() << "Failed writing script metadata cache" << file_path;
+        return;
+    }
+    file.write(QJsonDocument{document}.toJson(QJsonDocument::Compact));
+}
@@ -0,0 +1,55 @@
+#ifndef SCRIPT_METADATA_CACHE_H
+#define SCRIPT_METADATA_CACHE_H
+
+#include "scriptengine.h"
+
+#include <QByteArray>
+#include <QString>
+#include <QStringList>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+struct Script_metadata {
+    QStringList validation_messages;
+    std::vector<DeviceRequirements> device_requirements;
+    QStringList required_files; //absolute paths of the files the script loaded with require or import
+};
+
+//Persistent cache of what loading a script at startup found out about it, so unchanged scripts neither need to be checked by luacheck nor executed.
+//Entries are keyed by the script path and are valid as long as the modification time and size or the content hash of the script and of every
+//file it required match. Reloading a script or reloading all scripts bypasses the cache.
+class Script_metadata_cache {
+    public:
+    static Script_metadata_cache &get();
+    //loads the cache from file_path, save writes it back there
+    Script_metadata_cache(QString file_path);
+
+    std::optional<Script_metadata> find(const QString &script_path);
+    void insert(const QString &script_path, Script_metadata metadata);
+    void remove(const QString &script_path);
+    //writes the cache to disk if anything changed since the last save
+    void save();
+
+    private:
+    struct File_state {
+        QString path;
+        qint64 modification_time_ms = 0;
+        qint64 size = 0;
+        QByteArray hash;
+    };
+    struct Entry {
+        File_state script;
+        std::vector<File_state> required_files;
+        Script_metadata metadata;
+    };
+    static std::optional<File_state> get_file_state(const QString &path);
+    static bool is_unchanged(File_state &state, bool &touched);
+    std::map<QString, Entry> entries;
+    std::mutex entries_mutex;
+    bool modified = false;
+    QString file_path;
+};
+
+#endif // SCRIPT_METADATA_CACHE_H
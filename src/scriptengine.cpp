@@ -12,27 +12,34 @@
 #include "console.h"
 #include "data_engine/data_engine.h"
 #include "data_engine/exceptionalapproval.h"
+#include "lua_bytecode_cache.h"
 #include "qt_util.h"
 #include "rpcruntime_decoded_function_call.h"
 #include "rpcruntime_encoded_function_call.h"
 #include "rpcruntime_function.h"
 #include "scriptsetup.h"
 #include "testrunner.h"
+#include "thread_pool.h"
+#include "tracing.h"
 #include "ui_container.h"
 #include "util.h"
 
 #include <QDebug>
 #include <QDir>
+#include <QFileInfo>
 #include <QKeyEvent>
 #include <QKeySequence>
 #include <QMessageBox>
 #include <QMutex>
 #include <QPlainTextEdit>
+#include <QPointer>
 #include <QProcess>
 #include <QSettings>
 #include <QShortcut>
 #include <QThread>
+#include <QTimer>
 #include <QVariant>
+#include <algorithm>
 #include <cmath>
 #include <functional>
 #include <memory>
@@ -134,6 +141,65 @@ static void set_runtime_parameter(RPCRuntimeEncodedParam &param, sol::object obj
     }
 }
 
+struct RPCDevice;
+
+//Runs the RPC calls of cooperative scripts. Calls to the same device are queued, so there is at most one call per device in flight and each
+//device with queued calls has a thread of its own.
+static Thread_pool &rpc_call_pool() {
+    static Thread_pool pool{0};
+    return pool;
+}
+
+//An RPC call that is executed by a thread of rpc_call_pool while the calling coroutine yields to the cooperative scheduler
+struct Pending_rpc_call {
+    struct State {
+        std::mutex mutex;
+        std::condition_variable condition_variable;
+        bool finished = false;
+        std::unique_ptr<RPCRuntimeDecodedFunctionCall> result;
+        std::exception_ptr error;
+        std::function<void()> on_finished;
+    };
+
+    bool is_finished() const {
+        std::lock_guard<std::mutex> lock{state->mutex};
+        return state->finished;
+    }
+    void wait() const {
+        std::unique_lock<std::mutex> lock{state->mutex};
+        state->condition_variable.wait(lock, [this] { return state->finished; });
+    }
+    bool timed_out() const {
+        wait();
+        if (not state->error) {
+            return false;
+        }
+        try {
+            std::rethrow_exception(state->error);
+        } catch (const RPCTimeoutException &) {
+            return true;
+        } catch (...) {
+            return false;
+        }
+    }
+    sol::object get_result();
+    //calls callback in the pool thread when the call finishes or right away if it already did
+    void call_when_finished(std::function<void()> callback) {
+        {
+            std::lock_guard<std::mutex> lock{state->mutex};
+            if (not state->finished) {
+                state->on_finished = std::move(callback);
+                return;
+            }
+        }
+        callback();
+    }
+
+    RPCDevice *device;
+    std::string name;
+    std::shared_ptr<State> state;
+};
+
 struct RPCDevice {
     std::string get_protocol_name() {
         return protocol->type.toStdString();
@@ -150,6 +216,41 @@ struct RPCDevice {
 
     sol::object call_rpc_function(const std::string &name, const sol::variadic_args &va, bool show_message_box_when_timeout) {
         Console_handle::note() << QString("\"%1\" called").arg(name.c_str());
+        auto function = encode_rpc_function(name, va);
+        return decode_rpc_answer(name, protocol->call_and_wait(function, show_message_box_when_timeout));
+    }
+    //starts the call in a pool thread and returns immediately, used by cooperative scripts which yield until the answer arrived
+    Pending_rpc_call start_rpc_function(const std::string &name, const sol::variadic_args &va, bool show_message_box_when_timeout) {
+        Console_handle::note() << QString("\"%1\" called").arg(name.c_str());
+        auto function = std::make_shared<RPCRuntimeEncodedFunctionCall>(encode_rpc_function(name, va));
+        Pending_rpc_call call{this, name, std::make_shared<Pending_rpc_call::State>()};
+        rpc_call_pool().push_serialized(protocol, [protocol = protocol, function, state = call.state, show_message_box_when_timeout,
+                                                   trace_run = Tracing::current_run(), counters_run = Performance_counters::current_run()] {
+            TRACE_BIND_RUN(trace_run);
+            const Performance_counters::Run_binding performance_counters_binding{counters_run};
+            std::unique_ptr<RPCRuntimeDecodedFunctionCall> result;
+            std::exception_ptr error;
+            try {
+                result = protocol->call_and_wait(*function, show_message_box_when_timeout);
+            } catch (...) {
+                error = std::current_exception();
+            }
+            std::function<void()> on_finished;
+            {
+                std::lock_guard<std::mutex> lock{state->mutex};
+                state->result = std::move(result);
+                state->error = error;
+                state->finished = true;
+                on_finished = std::move(state->on_finished);
+            }
+            state->condition_variable.notify_all();
+            if (on_finished) {
+                on_finished();
+            }
+        });
+        return call;
+    }
+    RPCRuntimeEncodedFunctionCall encode_rpc_function(const std::string &name, const sol::variadic_args &va) {
         auto function = protocol->encode_function(name);
         int param_count = 0;
         for (auto &arg : va) {
@@ -159,7 +260,9 @@ struct RPCDevice {
         if (not function.are_all_values_set()) {
             throw sol::error("Failed calling function, missing parameters");
         }
-        auto result = protocol->call_and_wait(function, show_message_box_when_timeout);
+        return function;
+    }
+    sol::object decode_rpc_answer(const std::string &name, std::unique_ptr<RPCRuntimeDecodedFunctionCall> result) {
         if (result) {
             try {
                 auto output_params = result->get_decoded_parameters();
@@ -188,6 +291,102 @@ struct RPCDevice {
     sol::table enums;
 };
 
+sol::object Pending_rpc_call::get_result() {
+    wait();
+    if (state->error) {
+        std::rethrow_exception(state->error);
+    }
+    return device->decode_rpc_answer(name, std::move(state->result));
+}
+
+//Yields its arguments tagged with the cooperative yield tag if called from a task of the scheduler, otherwise returns right away.
+//The ScriptEngine is passed as light userdata upvalue.
+static int yield_to_scheduler(lua_State *L) {
+    auto script_engine = static_cast<ScriptEngine *>(lua_touserdata(L, lua_upvalueindex(1)));
+    if (not script_engine->may_yield_to_scheduler(L)) {
+        return 0;
+    }
+    lua_pushlightuserdata(L, ScriptEngine::get_cooperative_yield_tag());
+    lua_insert(L, 1);
+    return lua_yield(L, lua_gettop(L));
+}
+
+//Lua side of RPC calls in cooperative mode. Called from a task of the scheduler the call yields the pending call to the scheduler which
+//resumes the task once the answer arrived, anywhere else it simply waits.
+static const char *cooperative_rpc_wrappers = R"(
+local yield_to_scheduler = ...
+local function await(call)
+    yield_to_scheduler(call)
+    call:wait()
+    return call
+end
+return {
+    call = function(start)
+        return function(...)
+            return await(start(...)):get_result()
+        end
+    end,
+    try = function(start)
+        return function(...)
+            local call = await(start(...))
+            if call:timed_out() then
+                return {timeout = true}
+            end
+            return {result = call:get_result(), timeout = false}
+        end
+    end
+}
+)";
+
+//Takes a snapshot of every table reachable from the globals, package.loaded and the string metatable, including metatables and the
+//metatables of userdata, and returns a function that restores all of them. This resets a state between runs without recreating all
+//bindings. Tables the script created are unreachable after the restore and get collected.
+static const char *globals_snapshot = R"(
+local next, rawset, type = next, rawset, type
+local getmetatable, setmetatable = debug.getmetatable, debug.setmetatable
+local saved = {}
+local function snapshot(value)
+    local value_type = type(value)
+    if value_type == "userdata" then
+        local metatable = getmetatable(value)
+        if metatable ~= nil then
+            snapshot(metatable)
+        end
+        return
+    end
+    if value_type ~= "table" or saved[value] then
+        return
+    end
+    local contents = {}
+    saved[value] = {contents = contents, metatable = getmetatable(value)}
+    for k, v in next, value do
+        contents[k] = v
+        snapshot(k)
+        snapshot(v)
+    end
+    snapshot(saved[value].metatable)
+end
+snapshot(_G)
+snapshot(package.loaded)
+local string_metatable = getmetatable("")
+snapshot(string_metatable)
+return function()
+    for t, state in next, saved do
+        local contents = state.contents
+        for k in next, t do
+            if contents[k] == nil then
+                rawset(t, k, nil)
+            end
+        end
+        for k, v in next, contents do
+            rawset(t, k, v)
+        end
+        setmetatable(t, state.metatable)
+    end
+    setmetatable("", string_metatable)
+end
+)";
+
 static void add_enum_type(const RPCRuntimeParameterDescription &param, sol::state &lua, sol::table &device) {
     if (param.get_type() == RPCRuntimeParameterDescription::Type::enumeration) {
         const auto &enum_description = param.as_enumeration();
@@ -229,17 +428,75 @@ static void add_enum_types(const RPCRuntimeFunction &function, sol::state &lua,
 }
 
 static void abort_check() {
-    if (QThread::currentThread()->isInterruptionRequested()) {
+    if (QThread::currentThread()->isInterruptionRequested() || ScriptEngine::current_cooperative_script_interrupted()) {
         throw sol::error("Abort Requested");
     }
 }
 
+//the script the cooperative scheduler of this thread is currently resuming
+static thread_local ScriptEngine *current_cooperative_script = nullptr;
+
+//A task that waits for the GUI thread spins a nested event loop on the worker. Scheduler calls arriving there must neither resume other tasks
+//inside the running one nor tear down a run whose coroutine is on the stack, so they are deferred until the outermost scheduler call returned.
+static thread_local bool scheduler_call_running = false;
+static thread_local std::vector<std::pair<QPointer<QObject>, std::function<void()>>> deferred_scheduler_calls;
+
+static void post_scheduler_call(QObject *context, std::function<void()> call);
+
+//every entry into the cooperative scheduler from the worker's event loop goes through here
+static void run_scheduler_call(QObject *context, const std::function<void()> &call) {
+    if (scheduler_call_running) {
+        deferred_scheduler_calls.emplace_back(context, call);
+        return;
+    }
+    {
+        scheduler_call_running = true;
+        auto running_resetter = Utility::RAII_do([] { scheduler_call_running = false; });
+        call();
+    }
+    auto deferred_calls = std::move(deferred_scheduler_calls);
+    deferred_scheduler_calls.clear();
+    for (auto &[deferred_context, deferred_call] : deferred_calls) {
+        if (deferred_context) { //the runner may have been destroyed in the meantime
+            post_scheduler_call(deferred_context, std::move(deferred_call));
+        }
+    }
+}
+
+//queues call in the event loop of context's thread, also when called from that thread, so other events are handled in between
+static void post_scheduler_call(QObject *context, std::function<void()> call) {
+    QTimer::singleShot(0, context, [context, call = std::move(call)] { run_scheduler_call(context, call); });
+}
+
+struct Cooperative_task {
+    sol::thread thread;
+    sol::coroutine coroutine;
+    bool started = false;
+    bool finished = false;
+    std::uint64_t wait_id = 0; //identifies the pending resume so that stale wake ups are ignored
+};
+
+struct ScriptEngine::Cooperative_run {
+    Cooperative_run(QString run_name)
+        : trace_run{std::move(run_name)} {}
+
+    Tracing::Detached_run trace_run; //bound in every resume, like performance_counters_run
+    std::vector<MatchedDevice> devices;
+    QObject *context;
+    std::function<void(std::exception_ptr)> on_finished;
+    std::vector<std::unique_ptr<Cooperative_task>> tasks; //tasks[0] runs the script's run function, the others are created by spawn
+    std::size_t unfinished_tasks = 0;
+    std::vector<std::shared_ptr<Pending_rpc_call::State>> pending_rpc_calls;
+    bool finishing = false; //no task is resumed anymore, the run completes once the pending RPC calls finished
+    std::exception_ptr error;
+};
+
 ScriptEngine::ScriptEngine(UI_container *parent, Console &console, TestRunner *runner, QString test_name)
     : runner{runner}
     , test_name{std::move(test_name)}
     , parent{parent}
     , console(console) {
-    reset_lua_state();
+    create_lua_state();
 }
 
 ScriptEngine::~ScriptEngine() { //
@@ -247,6 +504,7 @@ ScriptEngine::~ScriptEngine() { //
 }
 
 Event_id::Event_id ScriptEngine::await_timeout(std::chrono::milliseconds duration, std::chrono::milliseconds start) {
+    const Performance_counters::Scoped_timer timer{Performance_counters::Histogram::await_timeout_ms};
     std::unique_lock<std::mutex> lock{await_mutex};
     if (await_condition == Event_id::interrupted) {
         throw std::runtime_error("Interrupted");
@@ -258,6 +516,10 @@ Event_id::Event_id ScriptEngine::await_timeout(std::chrono::milliseconds duratio
     return Event_id::Timer_expired;
 }
 
+Performance_counters::Snapshot ScriptEngine::get_run_performance_counters() const {
+    return Performance_counters::get_snapshot(performance_counters_run);
+}
+
 Event_id::Event_id ScriptEngine::await_ui_event() {
     std::unique_lock<std::mutex> lock{await_mutex};
     if (await_condition == Event_id::interrupted) {
@@ -336,6 +598,40 @@ void ScriptEngine::post_interrupt(QString message) {
         await_condition = Event_id::interrupted;
     }
     await_condition_variable.notify_one();
+    if (cooperative && runner) {
+        //wake up a sleeping coroutine so that it notices the interrupt right away
+        cooperative_interrupt_requested = true;
+        post_scheduler_call(runner->obj(), [this] {
+            if (cooperative_run) {
+                finish_cooperative_run(std::make_exception_ptr(std::runtime_error("Interrupted")));
+            }
+        });
+    }
+}
+
+bool ScriptEngine::current_cooperative_script_interrupted() {
+    return current_cooperative_script && current_cooperative_script->cooperative_interrupt_requested;
+}
+
+bool ScriptEngine::is_warm() const {
+    return state_is_reset && not cooperative_run;
+}
+
+bool ScriptEngine::is_headless() const {
+    return headless;
+}
+
+bool ScriptEngine::may_yield_to_scheduler(lua_State *L) const {
+    if (not cooperative_run || not lua_isyieldable(L)) {
+        return false;
+    }
+    return std::any_of(std::begin(cooperative_run->tasks), std::end(cooperative_run->tasks),
+                       [L](const auto &task) { return task->thread.thread_state() == L; });
+}
+
+void *ScriptEngine::get_cooperative_yield_tag() {
+    static char tag;
+    return &tag;
 }
 
 std::vector<std::string> ScriptEngine::get_default_globals() {
@@ -469,18 +765,42 @@ std::string ScriptEngine::get_script_import_path(const std::string &name) {
     for (auto &dir : {current_script_dir, QDir{QSettings{}.value(Globals::test_script_path_settings_key).toString()}, QDir{}}) {
         const auto filepath = dir.filePath(script);
         if (QFile::exists(filepath)) {
+            add_required_file(filepath);
             return filepath.toStdString();
         }
     }
     return name;
 }
 
+void ScriptEngine::add_required_file(const QString &path) {
+    const auto absolute_path = QFileInfo{path}.absoluteFilePath();
+    if (not required_files.contains(absolute_path)) {
+        required_files << absolute_path;
+    }
+}
+
+const QStringList &ScriptEngine::get_required_files() const {
+    return required_files;
+}
+
 void ScriptEngine::load_script(const std::string &path) {
+    const bool warm = path_m == QString::fromStdString(path) && lua->registry()["restore_globals"].valid();
     path_m = QString::fromStdString(path);
+    required_files.clear();
 
     try {
-        script_setup(*lua, path, *this, parent, console.get_plaintext_edit());
-        lua->script_file(path);
+        if (warm) { //the bindings of the last load are still there, only the script itself needs to run again
+            reset_lua_state();
+        } else {
+            if (lua->registry()["restore_globals"].valid()) { //the bindings refer to the path of the previous script
+                create_lua_state();
+            }
+            script_setup(*lua, path, *this, parent, console.get_plaintext_edit());
+            sol::function restore_globals = lua->script(globals_snapshot);
+            lua->registry()["restore_globals"] = restore_globals;
+        }
+        state_is_reset = false;
+        Lua_bytecode_cache::get().script_file(*lua, path_m);
     } catch (const sol::error &error) {
         qDebug() << "caught sol::error@load_script";
         set_error_line(error);
@@ -498,17 +818,80 @@ void ScriptEngine::set_error_line(const sol::error &error) {
 }
 
 void ScriptEngine::reset_lua_state() {
+    TRACE_SCOPE("ScriptEngine::reset_lua_state");
+    if (lua) {
+        sol::protected_function restore_globals = lua->registry()["restore_globals"];
+        if (restore_globals.valid()) {
+            lua_devices = std::nullopt;
+            if (restore_globals().valid()) {
+                //whatever the script created is unreachable now, collecting it runs the destructors of its userdata like closing the state would
+                lua->collect_garbage();
+                lua_devices = lua->create_table_with();
+                state_is_reset = true;
+                return;
+            }
+        }
+    }
+    create_lua_state();
+}
+
+void ScriptEngine::create_lua_state() {
     if (lua_devices) {
         lua_devices = std::nullopt;
     }
+    state_is_reset = false;
     lua = std::make_unique<sol::state>();
     lua_devices = lua->create_table_with();
 
     //register RPC device type
+    lua->new_usertype<Pending_rpc_call>("Pending_rpc_call",                         //
+                                        "is_finished", &Pending_rpc_call::is_finished, //
+                                        "wait", &Pending_rpc_call::wait,               //
+                                        "timed_out", &Pending_rpc_call::timed_out,     //
+                                        "get_result", &Pending_rpc_call::get_result);
     auto type_reg = lua->new_usertype<RPCDevice>("RPCDevice");
     type_reg.set(sol::meta_function::index, [this](RPCDevice &device, std::string name) -> sol::object {
         abort_check();
         qDebug() << "Checking custom index" << name.c_str();
+        if (cooperative && (name == "try" || device.has_function(name))) {
+            sol::table wrappers = lua->registry()["cooperative_rpc_wrappers"];
+            if (not wrappers.valid()) {
+                lua_pushlightuserdata(lua->lua_state(), this);
+                lua_pushcclosure(lua->lua_state(), &yield_to_scheduler, 1);
+                sol::function yielder{lua->lua_state(), -1};
+                lua_pop(lua->lua_state(), 1);
+                sol::function load_wrappers = lua->load(cooperative_rpc_wrappers);
+                wrappers = load_wrappers(yielder);
+                lua->registry()["cooperative_rpc_wrappers"] = wrappers;
+            }
+            if (name == "try") {
+                sol::function try_wrapper = wrappers["try"];
+                return try_wrapper(sol::make_object(*lua, [](RPCDevice &device, const std::string &function_name, const sol::variadic_args &va) {
+                    abort_check();
+                    return device.start_rpc_function(function_name, va, false);
+                }));
+            }
+            sol::function call_wrapper = wrappers["call"];
+            return call_wrapper(sol::make_object(*lua, [function_name = std::move(name)](RPCDevice &device, const sol::variadic_args &va) {
+                abort_check();
+                return device.start_rpc_function(function_name, va, true);
+            }));
+        }
+        //try is resolved here instead of being a member so that cooperative scripts get the yielding version
+        if (name == "try") {
+            return sol::make_object(*lua, [this](RPCDevice &device, std::string function_name, const sol::variadic_args &va) {
+                abort_check();
+                auto result = create_table();
+                try {
+                    result["result"] = device.call_rpc_function(function_name, va, false);
+                    result["timeout"] = false;
+                    return result;
+                } catch (const RPCTimeoutException &) {
+                    result["timeout"] = true;
+                    return result;
+                }
+            });
+        }
         if (device.has_function(name)) {
             return sol::object(*lua, sol::in_place, [function_name = std::move(name)](RPCDevice &device, const sol::variadic_args &va) {
                 abort_check();
@@ -520,18 +903,6 @@ void ScriptEngine::reset_lua_state() {
         }
         throw std::runtime_error{"Element \"" + name + "\" does not exist in " + ::to_string(device)};
     });
-    type_reg.set("try", [this](RPCDevice &device, std::string function_name, const sol::variadic_args &va) {
-        abort_check();
-        auto result = create_table();
-        try {
-            result["result"] = device.call_rpc_function(function_name, va, false);
-            result["timeout"] = false;
-            return result;
-        } catch (const RPCTimeoutException &) {
-            result["timeout"] = true;
-            return result;
-        }
-    });
     type_reg.set("get_protocol_name", [](RPCDevice &device) {
         abort_check();
         return device.get_protocol_name();
@@ -774,6 +1145,10 @@ void ScriptEngine::run(std::vector<MatchedDevice> &devices) {
     qDebug() << "ScriptEngine::run";
     assert(not currently_in_gui_thread());
     matched_devices = &devices;
+    performance_counters_run = Performance_counters::create_run();
+    const Performance_counters::Run_binding performance_counters_binding{performance_counters_run};
+    TRACE_RUN(path_m);
+    TRACE_SCOPE("ScriptEngine::run");
     try {
         {
             sol::protected_function run = (*lua)["run"];
@@ -800,6 +1175,158 @@ void ScriptEngine::run(std::vector<MatchedDevice> &devices) {
     }
 }
 
+void ScriptEngine::start_cooperative_run(std::vector<MatchedDevice> devices, QObject *context, std::function<void(std::exception_ptr)> on_finished) {
+    assert(lua_devices);
+    assert(cooperative);
+    assert(not cooperative_run);
+    assert(not currently_in_gui_thread());
+    performance_counters_run = Performance_counters::create_run();
+    cooperative_run = std::make_unique<Cooperative_run>(path_m);
+    cooperative_run->devices = std::move(devices);
+    cooperative_run->context = context;
+    cooperative_run->on_finished = std::move(on_finished);
+    matched_devices = &cooperative_run->devices;
+    run_scheduler_call(context, [this] {
+        try {
+            sol::function run = (*lua)["run"];
+            if (not run.valid()) {
+                throw std::runtime_error{"Script does not have a \"run\" function."};
+            }
+            add_cooperative_task(run);
+        } catch (...) {
+            finish_cooperative_run(std::current_exception());
+            return;
+        }
+        resume_cooperative_task(0, 0);
+    });
+}
+
+std::size_t ScriptEngine::add_cooperative_task(const sol::function &function) {
+    auto task = std::make_unique<Cooperative_task>();
+    task->thread = sol::thread::create(lua->lua_state());
+    task->coroutine = sol::coroutine{task->thread.thread_state(), function};
+    cooperative_run->tasks.push_back(std::move(task));
+    cooperative_run->unfinished_tasks++;
+    return cooperative_run->tasks.size() - 1;
+}
+
+void ScriptEngine::spawn_cooperative_task(const sol::function &function) {
+    if (not cooperative_run) {
+        throw sol::error("spawn is only available while the run function of a script executes with cooperative script execution enabled.");
+    }
+    const auto task_index = add_cooperative_task(function);
+    post_scheduler_call(cooperative_run->context, [this, task_index] { resume_cooperative_task(task_index, 0); });
+}
+
+void ScriptEngine::resume_cooperative_task(std::size_t task_index, std::uint64_t wait_id) {
+    assert(scheduler_call_running);
+    if (not cooperative_run || task_index >= cooperative_run->tasks.size()) {
+        return;
+    }
+    auto &task = *cooperative_run->tasks[task_index];
+    if (task.finished || task.wait_id != wait_id || cooperative_run->finishing) {
+        return;
+    }
+    const Performance_counters::Run_binding performance_counters_binding{performance_counters_run};
+    TRACE_BIND_RUN(cooperative_run->trace_run.get_context());
+    TRACE_SCOPE("ScriptEngine::resume_cooperative_task");
+    task.wait_id++;
+    current_cooperative_script = this;
+    auto current_script_resetter = Utility::RAII_do([] { current_cooperative_script = nullptr; });
+    try {
+        if (cooperative_interrupt_requested) {
+            throw std::runtime_error("Interrupted");
+        }
+        auto result = task.started || task_index != 0 ? task.coroutine() : task.coroutine(get_devices(cooperative_run->devices));
+        task.started = true;
+        if (result.status() == sol::call_status::yielded) {
+            const bool scheduler_yield = result.return_count() == 2 && result.get_type(0) == sol::type::lightuserdata &&
+                                         result.get<void *>(0) == get_cooperative_yield_tag();
+            //untagged values were yielded by the script with coroutine.yield, that is a plain yield whatever the values are
+            schedule_cooperative_task(task_index, scheduler_yield ? result.get<sol::object>(1) : sol::object{});
+            return;
+        }
+        if (not result.valid()) {
+            sol::error error = result;
+            throw error;
+        }
+    } catch (const sol::error &e) {
+        qDebug() << "caught sol::error@resume_cooperative_task";
+        final_device_list_string = to_string(*lua_devices);
+        set_error_line(e);
+        finish_cooperative_run(std::current_exception());
+        return;
+    } catch (...) {
+        finish_cooperative_run(std::current_exception());
+        return;
+    }
+    task.finished = true;
+    if (--cooperative_run->unfinished_tasks == 0) {
+        script_finished();
+        finish_cooperative_run(nullptr);
+    }
+}
+
+void ScriptEngine::schedule_cooperative_task(std::size_t task_index, const sol::object &wait_for) {
+    const auto context = cooperative_run->context;
+    auto resume = [this, task_index, wait_id = cooperative_run->tasks[task_index]->wait_id] { resume_cooperative_task(task_index, wait_id); };
+    //wait_for is what sleep_ms or an RPC call yielded along with the yield tag, or nil for a plain yield
+    if (wait_for.get_type() == sol::type::number) { //sleep_ms yields the number of milliseconds to sleep
+        QTimer::singleShot(wait_for.as<int>(), context, [context, resume = std::move(resume)] { run_scheduler_call(context, resume); });
+    } else if (wait_for.is<Pending_rpc_call>()) { //RPC calls yield the pending call
+        auto &pending_rpc_calls = cooperative_run->pending_rpc_calls;
+        pending_rpc_calls.erase(std::remove_if(std::begin(pending_rpc_calls), std::end(pending_rpc_calls),
+                                               [](const auto &state) {
+                                                   std::lock_guard<std::mutex> lock{state->mutex};
+                                                   return state->finished;
+                                               }),
+                                std::end(pending_rpc_calls));
+        auto &call = wait_for.as<Pending_rpc_call &>();
+        pending_rpc_calls.push_back(call.state);
+        call.call_when_finished([context, resume = std::move(resume)] { post_scheduler_call(context, resume); });
+    } else { //plain yield, continue after the other tasks had their turn
+        post_scheduler_call(context, std::move(resume));
+    }
+}
+
+void ScriptEngine::finish_cooperative_run(std::exception_ptr error) {
+    if (cooperative_run->finishing) { //already waiting for RPC calls, the first error is the one reported
+        return;
+    }
+    cooperative_run->finishing = true;
+    cooperative_run->error = error;
+    //RPC calls still running in the pool use the devices, so they must complete before the devices are released. Instead of blocking the
+    //thread, which also runs other scripts, the last call to finish completes the run.
+    const auto context = cooperative_run->context;
+    for (auto &state : cooperative_run->pending_rpc_calls) {
+        std::lock_guard<std::mutex> lock{state->mutex};
+        if (not state->finished) {
+            state->on_finished = [this, context] { post_scheduler_call(context, [this] { complete_cooperative_run(); }); };
+        }
+    }
+    complete_cooperative_run();
+}
+
+void ScriptEngine::complete_cooperative_run() {
+    if (not cooperative_run || not cooperative_run->finishing) { //a late wake up after the run already completed
+        return;
+    }
+    for (auto &state : cooperative_run->pending_rpc_calls) {
+        std::lock_guard<std::mutex> lock{state->mutex};
+        if (not state->finished) {
+            return;
+        }
+    }
+    auto on_finished = std::move(cooperative_run->on_finished);
+    auto error = std::move(cooperative_run->error);
+    //the coroutines reference the lua state, so they must be destroyed first
+    cooperative_run.reset();
+    matched_devices = nullptr;
+    cooperative_interrupt_requested = false;
+    reset_lua_state();
+    on_finished(error);
+}
+
 QString DeviceRequirements::get_description() const {
     QString quantity;
     if (quantity_max == INT_MAX) {
@@ -1,21 +1,25 @@
 #ifndef SCRIPTENGINE_H
 #define SCRIPTENGINE_H
 
+#include "performance_counters.h"
 #include "qt_util.h"
 
 #include <QEventLoop>
 #include <QList>
 #include <QObject>
 #include <QString>
+#include <QStringList>
 #include <chrono>
+#include <atomic>
 #include <condition_variable>
+#include <cstdint>
+#include <exception>
 #include <functional>
 #include <memory>
 #include <mutex>
 #include <sol.hpp>
 #include <vector>
 
-class QStringList;
 class QSplitter;
 class QPlainTextEdit;
 struct Protocol;
@@ -67,6 +71,8 @@ class ScriptEngine : public QObject {
     friend class TestRunner;
     friend class TestDescriptionLoader;
     friend class DeviceWorker;
+    friend class Headless_runner;
+    friend class TestScriptEngine;
 
     ScriptEngine(UI_container *parent, Console &console, TestRunner *runner, QString test_name);
     ScriptEngine(const ScriptEngine &) = delete;
@@ -74,14 +80,26 @@ class ScriptEngine : public QObject {
     ~ScriptEngine();
 
     Event_id::Event_id await_timeout(std::chrono::milliseconds duration, std::chrono::milliseconds start = {});
+    Performance_counters::Snapshot get_run_performance_counters() const;
     Event_id::Event_id await_ui_event();
     Event_id::Event_id await_hotkey_event();
 
     void post_hotkey_event(Event_id::Event_id event);
     void post_ui_event();
     void post_interrupt(QString message = {});
+    //true if the script currently being resumed by the cooperative scheduler of this thread was interrupted
+    static bool current_cooperative_script_interrupted();
+    //true if L is the thread of a task of the running cooperative run and may yield right now. Coroutines the script creates itself never
+    //yield to the scheduler.
+    bool may_yield_to_scheduler(lua_State *L) const;
+    //yields to the scheduler pass this as their first value, so values a script yields itself are never mistaken for a scheduler request
+    static void *get_cooperative_yield_tag();
 
     static std::vector<std::string> get_default_globals();
+    //true if the script runs without a MainWindow, in which case it gets no user interface
+    bool is_headless() const;
+    //true if the state was reset after the last run and holds no objects of the script, so loading the same script again is cheap
+    bool is_warm() const;
 
     void load_script(const std::string &path);
     static void launch_editor(QString path, int error_line = 1);
@@ -93,6 +111,9 @@ class ScriptEngine : public QObject {
     QString get_absolute_filename(QString file_to_open);
     bool adopt_device(const MatchedDevice &device);
     std::string get_script_import_path(const std::string &name);
+    //files the script loaded with require or import since load_script was called
+    void add_required_file(const QString &path);
+    const QStringList &get_required_files() const;
 
     sol::table create_table();
     template <class Return_type, class... Args>
@@ -110,20 +131,40 @@ class ScriptEngine : public QObject {
     std::vector<DeviceRequirements> get_device_requirement_list();
     sol::table get_devices(const std::vector<MatchedDevice> &devices);
     void run(std::vector<MatchedDevice> &devices);
+    //Runs the script's run function as a coroutine in the thread of context and returns immediately. Coroutines are resumed in that thread by
+    //timers, finished RPC calls or right away, depending on what they yielded. on_finished is called in that thread once all coroutines
+    //started by spawn finished too, with the error of the run or a nullptr on success.
+    void start_cooperative_run(std::vector<MatchedDevice> devices, QObject *context, std::function<void(std::exception_ptr)> on_finished);
+    std::size_t add_cooperative_task(const sol::function &function);
+    void spawn_cooperative_task(const sol::function &function);
+    void resume_cooperative_task(std::size_t task_index, std::uint64_t wait_id);
+    void schedule_cooperative_task(std::size_t task_index, const sol::object &wait_for);
+    void finish_cooperative_run(std::exception_ptr error);
+    void complete_cooperative_run();
     template <class ReturnType, class... Arguments>
     ReturnType call(const char *function_name, Arguments &&... args);
     void set_error_line(const sol::error &error);
+    //restores the globals of the freshly loaded script if possible, otherwise creates a new state
     void reset_lua_state();
+    void create_lua_state();
 
     std::optional<sol::table> lua_devices;
     std::unique_ptr<sol::state> lua{};
     QString path_m{};
+    QStringList required_files;
     int error_line{0};
     UI_container *parent{nullptr};
     Console &console;
     QObject *owner;
     std::vector<MatchedDevice> *matched_devices;
     std::string final_device_list_string;
+    Performance_counters::Run_context performance_counters_run;
+    bool headless = false; //set by the Headless_runner before the script is loaded
+    bool state_is_reset = false;
+    bool cooperative = false; //sleep_ms and RPC calls yield to the cooperative scheduler instead of blocking the thread
+    struct Cooperative_run;
+    std::unique_ptr<Cooperative_run> cooperative_run;
+    std::atomic<bool> cooperative_interrupt_requested{false};
 
     std::mutex await_mutex;
     std::condition_variable await_condition_variable;
@@ -5,6 +5,7 @@
 #include "LuaFunctions/datalogger_lua.h"
 #include "LuaFunctions/lua_functions_lua.h"
 #include "LuaFunctions/moving_average_lua.h"
+#include "LuaFunctions/numarray_lua.h"
 #include "LuaFunctions/polldataengine_lua.h"
 #include "LuaUI/button_lua.h"
 #include "LuaUI/checkbox_lua.h"
@@ -63,9 +64,20 @@ void script_setup(sol::state &lua, const std::string &path, ScriptEngine &script
     bind_chargecounter(lua);
     bind_datalogger(lua, script_engine_console_plaintext, path);
     bind_moving_average(lua, script_engine_console_plaintext);
+    bind_numarray(lua);
     bind_lua_functions(lua, ui_table, path, script_engine, script_engine_console_plaintext);
     //protocols and devices
     bind_scpiprotocol(lua, script_engine);
     bind_sg04countprotocol(lua);
     bind_manualprotocol(lua);
+    if (script_engine.is_headless()) {
+        //headless runs have no widgets to place user interface elements in. Checking for a missing parent is not enough, scripts loaded
+        //only to read their descriptions have none either.
+        lua.safe_script(R"(
+			for name in pairs(Ui) do
+				Ui[name] = nil
+			end
+			setmetatable(Ui, {__index = function(_, name) error("Ui." .. name .. " is not available in headless mode", 2) end})
+		)");
+    }
 }
@@ -1,10 +1,11 @@
 #include "scriptsetup_helper.h"
+#include "scriptengine.h"
 
 #include <QThread>
 #include <sol.hpp>
 
 void abort_check() {
-	if (QThread::currentThread()->isInterruptionRequested()) {
+	if (QThread::currentThread()->isInterruptionRequested() || ScriptEngine::current_cooperative_script_interrupted()) {
 		throw sol::error("Abort Requested");
 	}
 }
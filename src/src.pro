@@ -73,6 +73,9 @@ HEADERS += \
         LuaFunctions/polldataengine_lua.h \
         LuaFunctions/moving_average_lua.h \
         LuaFunctions/moving_average.h \
+	LuaFunctions/numarray.h \
+	LuaFunctions/numarray_lua.h \
+	LuaFunctions/spectrum.h \
 	LuaUI/progressbar.h \
 	LuaUI/progressbar_lua.h \
 	LuaUI/spinbox.h \
@@ -99,6 +102,7 @@ HEADERS += \
 	Windows/reporthistoryquery.h \
 	Windows/scpimetadatadeviceselector.h \
 	Windows/settingsform.h \
+	LuaFunctions/binary_table_file.h \
 	LuaFunctions/chargecounter.h \
 	LuaFunctions/chargecounter_lua.h \
 	communication_devices.h \
@@ -116,17 +120,23 @@ HEADERS += \
 	export.h \
 	favorite_scripts.h \
 	forward_decls.h \
+	headless_runner.h \
 	identicon/identicon.h \
 	LuaFunctions/lua_functions.h \
 	LuaFunctions/lua_functions_lua.h \
+	lua_bytecode_cache.h \
+	performance_counters.h \
 	qt_util.h \
 	scpimetadata.h \
+	script_executor.h \
+	script_metadata_cache.h \
 	scriptengine.h \
 	scriptsetup.h \
 	scriptsetup_helper.h \
 	testdescriptionloader.h \
 	testrunner.h \
 	thread_pool.h \
+	tracing.h \
 	ui_container.h \
 	userentrystorage.h \
 	util.h
@@ -196,6 +206,7 @@ SOURCES += \
 	Windows/reporthistoryquery.cpp \
 	Windows/scpimetadatadeviceselector.cpp \
 	Windows/settingsform.cpp \
+	LuaFunctions/binary_table_file.cpp \
 	LuaFunctions/chargecounter.cpp \
 	LuaFunctions/chargecounter_lua.cpp \
 	communication_devices.cpp \
@@ -212,19 +223,28 @@ SOURCES += \
 	exception_wrap.cpp \
 	favorite_scripts.cpp \
 	forward_decls.cpp \
+	headless_runner.cpp \
 	identicon/identicon.cpp \
 	LuaFunctions/lua_functions.cpp \
         LuaFunctions/lua_functions_lua.cpp \
         LuaFunctions/moving_average_lua.cpp \
         LuaFunctions/moving_average.cpp \
+	LuaFunctions/numarray.cpp \
+	LuaFunctions/numarray_lua.cpp \
+	LuaFunctions/spectrum.cpp \
+	lua_bytecode_cache.cpp \
+	performance_counters.cpp \
 	qt_util.cpp \
 	scpimetadata.cpp \
+	script_executor.cpp \
+	script_metadata_cache.cpp \
 	scriptengine.cpp \
 	scriptsetup.cpp \
 	scriptsetup_helper.cpp \
 	testdescriptionloader.cpp \
 	testrunner.cpp \
 	thread_pool.cpp \
+	tracing.cpp \
 	ui_container.cpp \
 	userentrystorage.cpp \
 	util.cpp
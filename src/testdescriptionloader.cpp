@@ -3,6 +3,7 @@
 #include "Windows/plaintextedit.h"
 #include "config.h"
 #include "console.h"
+#include "script_metadata_cache.h"
 #include "scriptengine.h"
 
 #include <QDebug>
@@ -47,7 +48,8 @@ static QTreeWidgetItem *add_entry(QTreeWidget *item, QStringList &&list) {
     return add_entry(child, list);
 }
 
-TestDescriptionLoader::TestDescriptionLoader(QTreeWidget *test_list, const QString &file_path, const QString &display_name)
+TestDescriptionLoader::TestDescriptionLoader(QTreeWidget *test_list, const QString &file_path, const QString &display_name,
+                                             std::optional<QStringList> validation_messages, bool use_cache, QString validation_error)
     : name(display_name)
     , file_path(file_path) {
     console = Utility::promised_thread_call(MainWindow::mw, [&] {
@@ -61,7 +63,7 @@ TestDescriptionLoader::TestDescriptionLoader(QTreeWidget *test_list, const QStri
         ui_entry->setData(0, Qt::UserRole, QVariant::fromValue(this));
         return link_console;
     });
-    reload();
+    load_description(use_cache, std::move(validation_messages), std::move(validation_error));
 }
 
 TestDescriptionLoader::TestDescriptionLoader(TestDescriptionLoader &&other)
@@ -69,7 +71,8 @@ TestDescriptionLoader::TestDescriptionLoader(TestDescriptionLoader &&other)
     , ui_entry(std::move(other.ui_entry))
     , name(std::move(other.name))
     , file_path(std::move(other.file_path))
-    , device_requirements(std::move(other.device_requirements)) {
+    , device_requirements(std::move(other.device_requirements))
+    , required_files(std::move(other.required_files)) {
     Utility::promised_thread_call(MainWindow::mw, [this] { ui_entry->setData(0, Qt::UserRole, QVariant::fromValue(this)); });
 }
 
@@ -79,6 +82,7 @@ TestDescriptionLoader &TestDescriptionLoader::operator=(TestDescriptionLoader &&
     name = std::move(other.name);
     file_path = std::move(other.file_path);
     device_requirements = std::move(other.device_requirements);
+    required_files = std::move(other.required_files);
     Utility::promised_thread_call(MainWindow::mw, [this] { ui_entry->setData(0, Qt::UserRole, QVariant::fromValue(this)); });
     return *this;
 }
@@ -89,6 +93,10 @@ const std::vector<DeviceRequirements> &TestDescriptionLoader::get_device_require
     return device_requirements;
 }
 
+const QStringList &TestDescriptionLoader::get_required_files() const {
+    return required_files;
+}
+
 const QString &TestDescriptionLoader::get_name() const {
     return name;
 }
@@ -98,59 +106,76 @@ const QString &TestDescriptionLoader::get_filepath() const {
 }
 
 void TestDescriptionLoader::reload() {
-    load_description();
+    load_description(false);
 }
 
 void TestDescriptionLoader::launch_editor() {
     ScriptEngine::launch_editor(file_path);
 }
 
-void TestDescriptionLoader::load_description() {
+void TestDescriptionLoader::load_description(bool use_cache, std::optional<QStringList> validation_messages, QString validation_error) {
     Utility::promised_thread_call(MainWindow::mw, [&] {
         ui_entry->setText(1, "");
         console->clear();
     });
     Console temp_console{console.get()};
-    ScriptEngine script{nullptr, temp_console, nullptr, ""};
+    auto &metadata_cache = Script_metadata_cache::get();
+    auto metadata = use_cache ? metadata_cache.find(file_path) : std::nullopt;
+    const bool cached = metadata.has_value();
+    if (not cached) {
+        metadata_cache.remove(file_path);
+        metadata.emplace();
+        try {
+            if (not validation_error.isEmpty()) {
+                throw std::runtime_error{validation_error.toStdString()};
+            }
+            metadata->validation_messages = validation_messages ? std::move(*validation_messages) : MainWindow::validate_script(file_path);
+        } catch (const std::exception &e) {
+            Console_handle::error(console.get()) << "Failed validating script: " << Sol_error_message{e.what(), file_path, name};
+            Utility::promised_thread_call(MainWindow::mw, [&] { ui_entry->setIcon(3, QIcon{"://src/icons/if_exclamation_16.ico"}); });
+            return;
+        }
+    }
     bool warning_occured = false;
     bool error_occured = false;
-    try {
-        for (const auto &message : MainWindow::validate_script(file_path)) {
-            QRegExp regex{R"((.*):(\d+):\d+-\d+:(.*))"};
-            if (not regex.exactMatch(message)) {
-                qDebug() << "Failed parsing message" << message;
-                continue;
-            }
-            auto message_parts = regex.capturedTexts();
-            auto path = std::move(message_parts[1]);
-            auto line = std::move(message_parts[2]);
-            auto diagnostic = std::move(message_parts[3]);
-            if (message.contains("(W")) {
-                temp_console.warning() << Console_Link{path + ':' + line, name + ':' + line} << ':' << std::move(diagnostic);
-                warning_occured = true;
-            } else if (message.contains("(E")) {
-                temp_console.error() << Console_Link{path + ':' + line, name + ':' + line} << ':' << std::move(diagnostic);
-                error_occured = true;
-            }
+    for (const auto &message : metadata->validation_messages) {
+        QRegExp regex{R"((.*):(\d+):\d+-\d+:(.*))"};
+        if (not regex.exactMatch(message)) {
+            qDebug() << "Failed parsing message" << message;
+            continue;
+        }
+        auto message_parts = regex.capturedTexts();
+        auto path = std::move(message_parts[1]);
+        auto line = std::move(message_parts[2]);
+        auto diagnostic = std::move(message_parts[3]);
+        if (message.contains("(W")) {
+            temp_console.warning() << Console_Link{path + ':' + line, name + ':' + line} << ':' << std::move(diagnostic);
+            warning_occured = true;
+        } else if (message.contains("(E")) {
+            temp_console.error() << Console_Link{path + ':' + line, name + ':' + line} << ':' << std::move(diagnostic);
+            error_occured = true;
         }
-    } catch (const std::exception &e) {
-        Console_handle::error(console.get()) << "Failed validating script: " << Sol_error_message{e.what(), file_path, name};
-        Utility::promised_thread_call(MainWindow::mw, [&] { ui_entry->setIcon(3, QIcon{"://src/icons/if_exclamation_16.ico"}); });
-        return;
     }
 
     try {
-        script.load_script(file_path.toStdString());
-        device_requirements.clear();
-        device_requirements = script.get_device_requirement_list();
-
+        if (not cached) {
+            ScriptEngine script{nullptr, temp_console, nullptr, ""};
+            script.load_script(file_path.toStdString());
+            metadata->device_requirements = script.get_device_requirement_list();
+            metadata->required_files = script.get_required_files();
+            //scripts that fail to load are not cached so that their error shows up on every start
+            metadata_cache.insert(file_path, *metadata);
+        }
         QStringList reqs;
-        for (auto &device_requirement : device_requirements) {
+        for (auto &device_requirement : metadata->device_requirements) {
             reqs << device_requirement.get_description();
         }
 
         //promised_thread_call guards above thread_calls. May be empty, but cannot be removed.
         Utility::promised_thread_call(MainWindow::mw, [&] {
+            //assigned in the gui thread because the gui reads them while scripts are reloaded in the background
+            device_requirements = std::move(metadata->device_requirements);
+            required_files = std::move(metadata->required_files);
             ui_entry->setText(1, reqs.join(", "));
             if (error_occured) {
                 ui_entry->setIcon(3, QIcon{"://src/icons/if_exclamation_16.ico"});
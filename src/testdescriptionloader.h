@@ -4,7 +4,9 @@
 #include "scriptengine.h"
 
 #include <QString>
+#include <QStringList>
 #include <memory>
+#include <optional>
 #include <vector>
 
 class QTreeWidget;
@@ -13,14 +15,21 @@ class QPlainTextEdit;
 
 class TestDescriptionLoader {
 	public:
-	TestDescriptionLoader(QTreeWidget *test_list, const QString &file_path, const QString &display_name);
+	//validation_messages are the luacheck results for the script if they are already known
+	//use_cache = false loads the script even if the Script_metadata_cache has an entry for it
+	//validation_error is why luacheck failed to check the script if that is already known, the script is then not validated again
+	TestDescriptionLoader(QTreeWidget *test_list, const QString &file_path, const QString &display_name,
+						  std::optional<QStringList> validation_messages = std::nullopt, bool use_cache = true, QString validation_error = {});
 	TestDescriptionLoader(TestDescriptionLoader &&other);
 	TestDescriptionLoader &operator=(TestDescriptionLoader &&other);
 	~TestDescriptionLoader();
 
 	const std::vector<DeviceRequirements> &get_device_requirements() const;
+	//absolute paths of the files the script loaded with require or import when it was loaded successfully the last time
+	const QStringList &get_required_files() const;
 	const QString &get_name() const;
 	const QString &get_filepath() const;
+	//does not save the Script_metadata_cache so that several scripts can be reloaded in parallel
 	void reload();
 	void launch_editor();
 
@@ -28,10 +37,11 @@ class TestDescriptionLoader {
 	std::unique_ptr<QTreeWidgetItem> ui_entry;
 
 	private:
-	void load_description();
+	void load_description(bool use_cache, std::optional<QStringList> validation_messages = std::nullopt, QString validation_error = {});
 	QString name;
 	QString file_path;
     std::vector<DeviceRequirements> device_requirements;
+    QStringList required_files;
 };
 
 Q_DECLARE_METATYPE(TestDescriptionLoader *);
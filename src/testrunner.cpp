@@ -6,6 +6,7 @@
 #include "console.h"
 #include "data_engine/data_engine.h"
 #include "deviceworker.h"
+#include "script_executor.h"
 #include "scriptengine.h"
 #include "testdescriptionloader.h"
 #include "ui_container.h"
@@ -16,51 +17,162 @@
 #include <QPlainTextEdit>
 #include <QSettings>
 #include <QSplitter>
+#include <QThread>
+#include <algorithm>
+
+struct TestRunner::Warm_engine {
+    std::unique_ptr<Console> console;
+    UI_container *ui_container{nullptr};
+    std::unique_ptr<ScriptEngine> script;
+};
 
 TestRunner::TestRunner(const TestDescriptionLoader &description)
-    : console_pointer{std::make_unique<Console>([] {
-        auto console = new PlainTextEdit();
-        console->setReadOnly(true);
-        console->setMaximumBlockCount(1000);
-        console->setVisible(false);
-        return console;
-    }())}
-    , lua_ui_container(new UI_container(MainWindow::mw))
-    , script_pointer{std::make_unique<ScriptEngine>(lua_ui_container, *console_pointer, this, description.get_name())}
+    : TestRunner{description, take_warm_engine(description)} {}
+
+TestRunner::TestRunner(const TestDescriptionLoader &description, Warm_engine engine)
+    : console_pointer{std::move(engine.console)}
+    , lua_ui_container(engine.ui_container)
+    , script_pointer{std::move(engine.script)}
     , script{*script_pointer}
     , name{description.get_name()}
     , script_path{QDir{QSettings{}.value(Globals::test_script_path_settings_key, "").toString()}.filePath(description.get_filepath())}
+    , cooperative{QSettings{}.value(Globals::cooperative_script_execution_key, false).toBool()}
     , console{*console_pointer} {
+    script.runner = this;
+    script.test_name = name;
+    script.await_condition = Event_id::invalid;
     console.note() << "Script started";
 
     lua_ui_container->add(console.get_plaintext_edit(), nullptr);
-    thread.adopt(*this);
-    thread.start();
+    if (cooperative) {
+        script.cooperative = true;
+    } else {
+        thread.adopt(*this);
+        thread.start();
+    }
     try {
         script.load_script(description.get_filepath().toStdString());
     } catch (const std::runtime_error &e) {
         qDebug() << e.what();
-        thread.quit();
+        if (not cooperative) {
+            thread.quit();
+        }
         throw;
     }
+    //a runner whose script failed to load never gets a worker, so there is nothing to release from the GUI thread
+    if (cooperative) {
+        cooperative_active = true;
+        cooperative_worker = Script_executor::get().adopt(*this);
+    }
 }
 
 TestRunner::~TestRunner() {
     message_queue_join();
+    if (not script.is_warm()) {
+        return;
+    }
+    //the console is the only widget of the user interface that is kept, it is moved out of the widget clear deletes
+    console.get_plaintext_edit()->setParent(lua_ui_container);
+    console.get_plaintext_edit()->clear();
+    lua_ui_container->clear();
+    script.runner = nullptr;
+    auto &warm_engines = get_warm_engines();
+    const auto path = script.path_m;
+    //another runner of the same script may have finished first, only the most recent engine is kept
+    for (auto it = std::begin(warm_engines); it != std::end(warm_engines); ++it) {
+        if (it->first == path) {
+            discard_warm_engine(std::move(it->second));
+            warm_engines.erase(it);
+            break;
+        }
+    }
+    warm_engines.emplace_front(path, Warm_engine{std::move(console_pointer), lua_ui_container, std::move(script_pointer)});
+    while (warm_engines.size() > max_warm_engines) {
+        discard_warm_engine(std::move(warm_engines.back().second));
+        warm_engines.pop_back();
+    }
+}
+
+void TestRunner::clear_warm_engines() {
+    auto &warm_engines = get_warm_engines();
+    for (auto &warm_engine : warm_engines) {
+        discard_warm_engine(std::move(warm_engine.second));
+    }
+    warm_engines.clear();
+}
+
+void TestRunner::discard_warm_engine(Warm_engine engine) {
+    //the script references its user interface and console, so it goes first
+    engine.script.reset();
+    auto console = engine.console->get_plaintext_edit();
+    //deleted later because console messages that are still queued for the GUI thread refer to the console
+    if (not engine.ui_container->isAncestorOf(console)) {
+        console->deleteLater();
+    }
+    engine.ui_container->deleteLater();
+}
+
+TestRunner::Warm_engine TestRunner::take_warm_engine(const TestDescriptionLoader &description) {
+    assert(currently_in_gui_thread());
+    const bool cooperative = QSettings{}.value(Globals::cooperative_script_execution_key, false).toBool();
+    auto &warm_engines = get_warm_engines();
+    const auto warm_engine_it = std::find_if(std::begin(warm_engines), std::end(warm_engines),
+                                             [&description](const auto &warm_engine) { return warm_engine.first == description.get_filepath(); });
+    if (warm_engine_it != std::end(warm_engines)) {
+        auto engine = std::move(warm_engine_it->second);
+        warm_engines.erase(warm_engine_it);
+        if (engine.script->cooperative == cooperative) { //cooperative scripts get different bindings
+            return engine;
+        }
+        discard_warm_engine(std::move(engine));
+    }
+    Warm_engine engine;
+    engine.console = std::make_unique<Console>([] {
+        auto console = new PlainTextEdit();
+        console->setReadOnly(true);
+        console->setMaximumBlockCount(1000);
+        console->setVisible(false);
+        return console;
+    }());
+    engine.ui_container = new UI_container(MainWindow::mw);
+    engine.script = std::make_unique<ScriptEngine>(engine.ui_container, *engine.console, nullptr, description.get_name());
+    return engine;
+}
+
+std::list<std::pair<QString, TestRunner::Warm_engine>> &TestRunner::get_warm_engines() {
+    static std::list<std::pair<QString, Warm_engine>> warm_engines; //only accessed by the GUI thread
+    return warm_engines;
 }
 
 void TestRunner::interrupt() {
     assert(currently_in_gui_thread());
     console.note() << "Script interrupted";
     script.post_interrupt();
-    thread.requestInterruption();
+    if (cooperative) {
+        cooperative_interrupted = true;
+        if (not cooperative_run_started) { //a running script releases its worker when the interrupted coroutine finishes
+            release_cooperative_worker([this] { console.note() << "Script stopped"; });
+        }
+    } else {
+        thread.requestInterruption();
+    }
 }
 
 bool TestRunner::was_interrupted() const {
+    if (cooperative) {
+        return cooperative_interrupted;
+    }
     return thread.was_interrupted();
 }
 
 void TestRunner::message_queue_join() {
+    if (cooperative) {
+        while (cooperative_active) {
+            QApplication::processEvents();
+            QThread::currentThread()->msleep(16);
+        }
+        return;
+    }
     assert(not thread.is_current());
     while (!thread.wait(16)) {
         QApplication::processEvents();
@@ -68,6 +180,12 @@ void TestRunner::message_queue_join() {
 }
 
 void TestRunner::blocking_join() {
+    if (cooperative) {
+        while (cooperative_active) {
+            QThread::currentThread()->msleep(16);
+        }
+        return;
+    }
     assert(not thread.is_current());
     thread.wait();
 }
@@ -86,32 +204,73 @@ UI_container *TestRunner::get_lua_ui_container() const {
 
 void TestRunner::run_script(std::vector<MatchedDevice> devices, DeviceWorker &device_worker) {
     device_worker_pointer = &device_worker;
+    cooperative_run_started = true;
     Utility::thread_call(this, [this, devices = std::move(devices), &device_worker]() mutable {
         for (auto &dev_prot : devices) {
             device_worker.set_currently_running_test(dev_prot.device, name);
             used_devices.push_back(dev_prot.device);
         }
+        MainWindow::mw->execute_in_gui_thread([this] { MainWindow::mw->set_testrunner_state(this, TestRunner_State::running); });
+        if (cooperative) {
+            script.start_cooperative_run(std::move(devices), this,
+                                         [this, &device_worker](std::exception_ptr error) { finish_script(device_worker, std::move(error)); });
+            return;
+        }
+        std::exception_ptr error;
         try {
-            MainWindow::mw->execute_in_gui_thread([this] { MainWindow::mw->set_testrunner_state(this, TestRunner_State::running); });
             script.run(devices);
-            MainWindow::mw->execute_in_gui_thread([this] { MainWindow::mw->set_testrunner_state(this, TestRunner_State::finished); });
-        } catch (const std::exception &e) {
-            MainWindow::mw->execute_in_gui_thread([this] { MainWindow::mw->set_testrunner_state(this, TestRunner_State::error); });
-            qDebug() << "runtime_error caught @TestRunner::run_script:" << e.what() << '\n';
-            console.error() << Sol_error_message{e.what(), script_path, name};
+        } catch (...) {
+            error = std::current_exception();
         }
-        device_worker_pointer = nullptr;
-        for (auto &extra_device : used_devices) {
-            device_worker.set_currently_running_test(extra_device, "");
+        finish_script(device_worker, std::move(error));
+    });
+}
+
+void TestRunner::finish_script(DeviceWorker &device_worker, std::exception_ptr error) {
+    try {
+        if (error) {
+            std::rethrow_exception(error);
         }
-        used_devices.clear();
+        MainWindow::mw->execute_in_gui_thread([this] { MainWindow::mw->set_testrunner_state(this, TestRunner_State::finished); });
+    } catch (const std::exception &e) {
+        MainWindow::mw->execute_in_gui_thread([this] { MainWindow::mw->set_testrunner_state(this, TestRunner_State::error); });
+        qDebug() << "runtime_error caught @TestRunner::run_script:" << e.what() << '\n';
+        console.error() << Sol_error_message{e.what(), script_path, name};
+    }
+    device_worker_pointer = nullptr;
+    for (auto &extra_device : used_devices) {
+        device_worker.set_currently_running_test(extra_device, "");
+    }
+    used_devices.clear();
+    if (cooperative) {
+        release_cooperative_worker();
+    } else {
         moveToThread(MainWindow::gui_thread);
         thread.quit();
-        console.note() << "Script stopped";
+    }
+    console.note() << "Script stopped";
+}
+
+void TestRunner::release_cooperative_worker(std::function<void()> on_released) {
+    //moveToThread must be called from the thread the runner currently lives in. The worker may be busy with another script, so the GUI
+    //thread does not wait for it. is_running and message_queue_join see the release through cooperative_active.
+    Utility::thread_call(this, [this, on_released = std::move(on_released)] {
+        if (not cooperative_active) {
+            return;
+        }
+        moveToThread(MainWindow::gui_thread);
+        Script_executor::get().release(cooperative_worker);
+        if (on_released) { //runs in the GUI thread, the event is dropped if the runner is destroyed first
+            Utility::thread_call(this, on_released);
+        }
+        cooperative_active = false;
     });
 }
 
 bool TestRunner::is_running() const {
+    if (cooperative) {
+        return cooperative_active;
+    }
     return thread.isRunning();
 }
 
@@ -5,6 +5,14 @@
 #include "qt_util.h"
 
 #include <QObject>
+#include <QString>
+#include <atomic>
+#include <exception>
+#include <functional>
+#include <list>
+#include <map>
+#include <memory>
+#include <utility>
 
 class CommunicationDevice;
 class DeviceWorker;
@@ -24,6 +32,8 @@ class TestRunner : QObject {
     using Lua_ui_container = QWidget;
     TestRunner(const TestDescriptionLoader &description);
     ~TestRunner();
+    //destroys the script engines kept for running their scripts again, must be called before the MainWindow shuts down
+    static void clear_warm_engines();
 
     void interrupt();
     bool was_interrupted() const;
@@ -49,8 +59,27 @@ class TestRunner : QObject {
     bool uses_device(CommunicationDevice *device);
 
     private:
+    //The bindings of a script capture its console and user interface, so a finished runner hands all three to the next runner of the
+    //same script which then only needs to run the script file again instead of setting up a new Lua state.
+    //Only the engines of the max_warm_engines most recently finished scripts are kept.
+    struct Warm_engine;
+    static constexpr std::size_t max_warm_engines = 4;
+    TestRunner(const TestDescriptionLoader &description, Warm_engine engine);
+    static Warm_engine take_warm_engine(const TestDescriptionLoader &description);
+    static std::list<std::pair<QString, Warm_engine>> &get_warm_engines(); //most recently used first
+    static void discard_warm_engine(Warm_engine engine);
+    void finish_script(DeviceWorker &device_worker, std::exception_ptr error);
+    //hands the worker back to the Script_executor without blocking, on_released is called in the GUI thread afterwards
+    void release_cooperative_worker(std::function<void()> on_released = {});
+
     std::unique_ptr<Console> console_pointer;
     Utility::Qt_thread thread{};
+    //in cooperative mode the runner lives in a shared thread of the Script_executor instead of its own thread
+    const bool cooperative;
+    std::size_t cooperative_worker{0};
+    std::atomic<bool> cooperative_active{false};
+    std::atomic<bool> cooperative_interrupted{false};
+    bool cooperative_run_started{false};
     UI_container *lua_ui_container{nullptr};
     std::unique_ptr<ScriptEngine> script_pointer;
     ScriptEngine &script;
@@ -5,31 +5,14 @@
 #include <condition_variable>
 #include <deque>
 #include <functional>
+#include <map>
 #include <mutex>
 #include <thread>
 #include <vector>
 
 struct Thread_pool {
-	Thread_pool(unsigned int threads = std::thread::hardware_concurrency())
-		: workers(threads) {
-		// initialize worker threads
-		for (auto &thread : workers) {
-			thread = std::thread{[this] {
-				for (;;) {
-					std::function<void()> work;
-					{ // get work from work queue
-						std::unique_lock l{worker_queue_mutex};
-						condition_variable.wait(l, [this] { return not work_queue.empty(); });
-						work = std::move(work_queue.front());
-						work_queue.pop_front();
-					}
-					if (not work) { //empty function means worker thread should quit
-						return;
-					}
-					work();
-				}
-			}};
-		}
+	Thread_pool(unsigned int threads = std::thread::hardware_concurrency()) {
+		grow(threads);
 	}
 	Thread_pool(const Thread_pool &) = delete;
 	Thread_pool &operator=(const Thread_pool &) = delete;
@@ -54,10 +37,65 @@ struct Thread_pool {
 		condition_variable.notify_one();
 	}
 
+	//Runs f after all functions pushed earlier with the same key finished, functions with different keys run in parallel. The pool grows so
+	//that every key with pending functions has a thread, so a function that blocks for a long time only delays the functions of its key.
+	void push_serialized(const void *key, std::function<void()> f) {
+		assert(f);
+		std::unique_lock l(serialized_queues_mutex);
+		auto &queue = serialized_queues[key];
+		queue.push_back(std::move(f));
+		if (queue.size() > 1) { //the function running for this key runs the new one when it is done
+			return;
+		}
+		grow(static_cast<unsigned int>(serialized_queues.size()));
+		push([this, key] { run_serialized(key); });
+	}
+
+	//adds threads until the pool has at least the given number of threads
+	void grow(unsigned int threads) {
+		std::unique_lock l(worker_queue_mutex);
+		while (workers.size() < threads) {
+			workers.emplace_back([this] { work(); });
+		}
+	}
+
 	private:
+	void work() {
+		for (;;) {
+			std::function<void()> work;
+			{ // get work from work queue
+				std::unique_lock l{worker_queue_mutex};
+				condition_variable.wait(l, [this] { return not work_queue.empty(); });
+				work = std::move(work_queue.front());
+				work_queue.pop_front();
+			}
+			if (not work) { //empty function means worker thread should quit
+				return;
+			}
+			work();
+		}
+	}
+	void run_serialized(const void *key) {
+		std::unique_lock l(serialized_queues_mutex);
+		auto &queue = serialized_queues[key]; //stays valid while other threads append to it, the entry is only erased here
+		for (;;) {
+			auto f = std::move(queue.front());
+			l.unlock();
+			f();
+			l.lock();
+			queue.pop_front();
+			if (queue.empty()) {
+				serialized_queues.erase(key);
+				return;
+			}
+		}
+	}
+
 	std::mutex worker_queue_mutex;
 	std::deque<std::function<void()>> work_queue;
 	std::vector<std::thread> workers;
 	std::condition_variable condition_variable;
+	std::mutex serialized_queues_mutex;
+	std::map<const void *, std::deque<std::function<void()>>> serialized_queues;
 };
 #endif // THREAD_POOL_H
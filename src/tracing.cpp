@@ -0,0 +1,142 @@
+#include "tracing.h"
+
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace {
+    struct Event {
+        const char *name;
+        Tracing::Clock::time_point start;
+        Tracing::Clock::duration duration;
+        std::size_t thread_id;
+    };
+
+    const Tracing::Clock::time_point epoch = Tracing::Clock::now();
+
+    thread_local Tracing::Run_context bound_run;
+
+    long long to_us(Tracing::Clock::duration duration) {
+        return std::chrono::duration_cast<std::chrono::microseconds>(duration).count();
+    }
+
+    QByteArray escape_json(const char *name) {
+        QByteArray result;
+        for (const char *c = name; *c; c++) {
+            if (*c == '"' || *c == '\\') {
+                result += '\\';
+            }
+            result += *c;
+        }
+        return result;
+    }
+
+    void write_trace(const QString &run_name, std::vector<Event> events, Tracing::Clock::time_point epoch) {
+        QDir dir{QDir::tempPath()};
+        dir.mkpath("crystalTestFramework_traces");
+        dir.cd("crystalTestFramework_traces");
+        const auto file_path = dir.filePath(QFileInfo{run_name}.completeBaseName() + "_" +
+                                            QDateTime::currentDateTime().toString("yyyy_MM_dd_hh_mm_ss_zzz") + ".json");
+        QFile file{file_path};
+        if (not file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+            qDebug() << "Failed writing trace file" << file_path;
+            return;
+        }
+        const auto pid = QByteArray::number(QCoreApplication::applicationPid());
+        file.write("{\"traceEvents\":[\n");
+        bool first = true;
+        for (const auto &event : events) {
+            if (not first) {
+                file.write(",\n");
+            }
+            first = false;
+            file.write("{\"name\":\"" + escape_json(event.name) + "\",\"ph\":\"X\",\"pid\":" + pid +
+                       ",\"tid\":" + QByteArray::number(static_cast<qulonglong>(event.thread_id)) +
+                       ",\"ts\":" + QByteArray::number(to_us(event.start - epoch)) + ",\"dur\":" + QByteArray::number(to_us(event.duration)) + "}");
+        }
+        file.write("\n],\"displayTimeUnit\":\"ms\"}\n");
+        qDebug() << "Wrote trace file" << file_path;
+    }
+} // namespace
+
+struct Tracing::Run_buffer {
+    std::mutex mutex;
+    std::vector<Event> events;
+    bool finished = false;
+};
+
+static void finish_run(const QString &run_name, Tracing::Run_buffer &run) {
+    std::vector<Event> events;
+    {
+        std::lock_guard<std::mutex> lock{run.mutex};
+        run.finished = true;
+        events = std::move(run.events);
+    }
+    write_trace(run_name, std::move(events), epoch);
+}
+
+Tracing::Run_context Tracing::current_run() {
+    return bound_run;
+}
+
+Tracing::Scope::Scope(const char *name)
+    : name{name}
+    , start{Clock::now()} {}
+
+Tracing::Scope::~Scope() {
+    const auto end = Clock::now();
+    const auto &run = bound_run;
+    if (not run) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock{run->mutex};
+    if (run->finished) {
+        return;
+    }
+    run->events.push_back({name, start, end - start, std::hash<std::thread::id>{}(std::this_thread::get_id())});
+}
+
+Tracing::Run::Run(QString run_name)
+    : run_name{std::move(run_name)}
+    , context{std::make_shared<Run_buffer>()}
+    , previous_context{std::move(bound_run)} {
+    bound_run = context;
+}
+
+Tracing::Run::~Run() {
+    bound_run = std::move(previous_context);
+    finish_run(run_name, *context);
+}
+
+Tracing::Detached_run::Detached_run(QString run_name)
+    : run_name{std::move(run_name)} {
+#ifdef CTF_TRACING
+    context = std::make_shared<Run_buffer>();
+#endif
+}
+
+Tracing::Detached_run::~Detached_run() {
+    if (context) {
+        finish_run(run_name, *context);
+    }
+}
+
+const Tracing::Run_context &Tracing::Detached_run::get_context() const {
+    return context;
+}
+
+Tracing::Run_binding::Run_binding(Run_context context)
+    : previous_context{std::move(bound_run)} {
+    bound_run = std::move(context);
+}
+
+Tracing::Run_binding::~Run_binding() {
+    bound_run = std::move(previous_context);
+}
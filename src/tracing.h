@@ -0,0 +1,84 @@
+#ifndef TRACING_H
+#define TRACING_H
+
+#include <QString>
+#include <chrono>
+#include <memory>
+
+//Scoped trace spans that are written as Chrome trace-event JSON (load the file in chrome://tracing or https://ui.perfetto.dev).
+//Tracing is compiled in only when CTF_TRACING is defined (see defaults.pri), otherwise TRACE_SCOPE, TRACE_RUN and TRACE_BIND_RUN expand to nothing.
+namespace Tracing {
+    using Clock = std::chrono::steady_clock;
+
+    //records a complete event ("ph":"X") from construction to destruction
+    struct Scope {
+        Scope(const char *name);
+        ~Scope();
+        Scope(const Scope &) = delete;
+        Scope &operator=(const Scope &) = delete;
+
+        private:
+        const char *name;
+        Clock::time_point start;
+    };
+
+    struct Run_buffer;
+    //the run events of the calling thread are recorded for, empty if there is none
+    using Run_context = std::shared_ptr<Run_buffer>;
+    Run_context current_run();
+
+    //marks a test run. Events recorded by the thread that created the run, and by threads bound to it with Run_binding, are written to
+    //<temp dir>/crystalTestFramework_traces/<run_name>_<timestamp>.json when the run ends. Each run keeps its own events, so runs that overlap
+    //in different threads do not see each other's events. Events of threads that are not bound to a run are not recorded.
+    struct Run {
+        Run(QString run_name);
+        ~Run();
+        Run(const Run &) = delete;
+        Run &operator=(const Run &) = delete;
+
+        private:
+        QString run_name;
+        Run_context context;
+        Run_context previous_context;
+    };
+
+    //like Run, but does not bind the calling thread, for runs that are resumed piece by piece such as cooperative scripts.
+    //Each piece binds get_context() with TRACE_BIND_RUN. Without CTF_TRACING the context stays empty and no file is written.
+    struct Detached_run {
+        Detached_run(QString run_name);
+        ~Detached_run();
+        Detached_run(const Detached_run &) = delete;
+        Detached_run &operator=(const Detached_run &) = delete;
+        const Run_context &get_context() const;
+
+        private:
+        QString run_name;
+        Run_context context;
+    };
+
+    //records the events of the calling thread for context until destruction, used for work a run hands to other threads
+    struct Run_binding {
+        Run_binding(Run_context context);
+        ~Run_binding();
+        Run_binding(const Run_binding &) = delete;
+        Run_binding &operator=(const Run_binding &) = delete;
+
+        private:
+        Run_context previous_context;
+    };
+} // namespace Tracing
+
+#define TRACE_CONCAT_IMPL(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_IMPL(a, b)
+
+#ifdef CTF_TRACING
+#define TRACE_SCOPE(name) const Tracing::Scope TRACE_CONCAT(trace_scope_, __LINE__){name}
+#define TRACE_RUN(run_name) const Tracing::Run TRACE_CONCAT(trace_run_, __LINE__){run_name}
+#define TRACE_BIND_RUN(context) const Tracing::Run_binding TRACE_CONCAT(trace_run_binding_, __LINE__){context}
+#else
+#define TRACE_SCOPE(name) static_cast<void>(0)
+#define TRACE_RUN(run_name) static_cast<void>(0)
+#define TRACE_BIND_RUN(context) static_cast<void>(context)
+#endif
+
+#endif // TRACING_H
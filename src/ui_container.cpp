@@ -58,13 +58,8 @@ struct Widget_paragraph {
 };
 
 UI_container::UI_container(QWidget *parent)
-    : QScrollArea{parent}
-    , layout{new QVBoxLayout} {
-    auto widget = std::make_unique<QWidget>();
-	widget->setMinimumSize({100, 100});
-    widget->setLayout(layout);
-	layout->setAlignment(Qt::AlignmentFlag::AlignTop);
-    setWidget(widget.release());
+    : QScrollArea{parent} {
+    clear();
 	setWidgetResizable(true);
 	const auto vscrollbar = verticalScrollBar();
 	connect(vscrollbar, &QAbstractSlider::rangeChanged, [vscrollbar](int, int) { vscrollbar->setSliderPosition(vscrollbar->maximum()); });
@@ -98,6 +93,17 @@ void UI_container::set_column_count(int columns) {
     column_count = columns;
 }
 
+void UI_container::clear() {
+    paragraphs.clear();
+    column_count = 1;
+    layout = new QVBoxLayout;
+    auto widget = std::make_unique<QWidget>();
+	widget->setMinimumSize({100, 100});
+    widget->setLayout(layout);
+	layout->setAlignment(Qt::AlignmentFlag::AlignTop);
+    setWidget(widget.release()); //deletes the previous widget with everything that was added to it
+}
+
 void UI_container::scroll_to_bottom() {
     //ensureVisible(0, height(), 0, 0);
     verticalScrollBar()->setSliderPosition(verticalScrollBar()->maximum());
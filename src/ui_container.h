@@ -34,6 +34,8 @@ class UI_container : public QScrollArea {
     void add(QWidget *widget, UI_widget *lua_ui_widget);
     void add(QLayout *layout, UI_widget *lua_ui_widget);
     void set_column_count(int columns);
+    //removes all widgets so the container can be used for another run of its script
+    void clear();
     void scroll_to_bottom();
     void remove_me_from_resize_list(UI_widget *me);
     // UserEntryCache user_entry_cache;
@@ -1,8 +1,30 @@
 #include "testScriptEngine.h"
+#include "LuaFunctions/binary_table_file.h"
 #include "LuaFunctions/lua_functions.h"
+#include "LuaFunctions/numarray_lua.h"
+#include "LuaFunctions/spectrum.h"
 #include "LuaUI/lineedit.h"
+#include "Windows/devicematcher.h"
+#include "console.h"
+#include "lua_bytecode_cache.h"
+#include "performance_counters.h"
+#include "script_metadata_cache.h"
+#include "thread_pool.h"
 #include "sol.hpp"
 #include "gmock/gmock.h" // Brings in Google Mock.
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QDir>
+#include <QEventLoop>
+#include <QFile>
+#include <QTemporaryDir>
+#include <QTimer>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <limits>
+#include <thread>
 
 #define USETESTS 1
 TestScriptEngine::TestScriptEngine(QObject *parent)
@@ -45,6 +67,52 @@ void TestScriptEngine::initTestCase() {}
 
 void TestScriptEngine::cleanupTestCase() {}
 
+std::vector<std::string> TestScriptEngine::run_cooperative_script(const char *script) {
+    QTemporaryDir dir;
+    const QString file_name = dir.filePath("cooperative.lua");
+    {
+        QFile file{file_name};
+        file.open(QIODevice::WriteOnly);
+        file.write(script);
+    }
+    Console console{nullptr};
+    ScriptEngine script_engine{nullptr, console, nullptr, {}};
+    script_engine.cooperative = true;
+    script_engine.load_script(file_name.toStdString());
+    std::vector<std::string> log;
+    script_engine.lua->set_function("log", [&log](const std::string &message) { log.push_back(message); });
+    //stands in for calls that wait for the GUI thread and handle events of the worker meanwhile
+    script_engine.lua->set_function("spin_event_loop", [](int duration_ms) {
+        const auto end = std::chrono::steady_clock::now() + std::chrono::milliseconds{duration_ms};
+        while (std::chrono::steady_clock::now() < end) {
+            QCoreApplication::processEvents();
+        }
+    });
+
+    QObject context;
+    QEventLoop loop;
+    bool finished = false;
+    script_engine.start_cooperative_run({}, &context, [&log, &loop, &finished](std::exception_ptr error) {
+        if (error) {
+            try {
+                std::rethrow_exception(error);
+            } catch (const std::exception &e) {
+                log.push_back(std::string{"error: "} + e.what());
+            }
+        }
+        finished = true;
+        loop.quit();
+    });
+    if (not finished) {
+        QTimer::singleShot(5000, &loop, &QEventLoop::quit);
+        loop.exec();
+    }
+    if (not finished) {
+        log.push_back("timeout");
+    }
+    return log;
+}
+
 void TestScriptEngine::basicLuaTest() {
     sol::state lua;
     int x = 0;
@@ -106,3 +174,494 @@ void TestScriptEngine::test_serachpath() {
     //  qDebug() << git_path;
     QVERIFY(git_path != "");
 }
+
+void TestScriptEngine::test_numarray() {
+    sol::state lua;
+    lua.open_libraries();
+    bind_numarray(lua);
+    lua.script(R"(
+        local a = NumArray.new({-20, -40, 2, 30, 8})
+        local b = NumArray.new(5, 2)
+        sum = a:sum()
+        mean = a:mean()
+        variance = a:variance()
+        max = a:max()
+        min_abs = a:min_abs()
+        added = (a + b):to_table()
+        divided = (a / NumArray.new({1, 2, 0, 3, 4})):to_table()
+        added_at = a:add_at(NumArray.new({1, 1}), 5):to_table()
+        length = #a
+        range = NumArray.range(-1, 1, 0.5):to_table()
+    )");
+    QCOMPARE(lua.get<double>("sum"), -20.);
+    QCOMPARE(lua.get<double>("mean"), -4.);
+    QCOMPARE(lua.get<double>("variance"), 577.6);
+    QCOMPARE(lua.get<double>("max"), 30.);
+    QCOMPARE(lua.get<double>("min_abs"), 2.);
+    QCOMPARE(lua.get<int>("length"), 5);
+    sol::table added = lua["added"];
+    QCOMPARE(added.size(), std::size_t{5});
+    QCOMPARE(added[1].get<double>(), -18.);
+    QCOMPARE(added[5].get<double>(), 10.);
+    sol::table divided = lua["divided"];
+    QCOMPARE(divided[2].get<double>(), -20.);
+    QCOMPARE(divided[3].get<double>(), std::numeric_limits<double>::infinity());
+    sol::table added_at = lua["added_at"];
+    QCOMPARE(added_at.size(), std::size_t{6});
+    QCOMPARE(added_at[5].get<double>(), 9.);
+    QCOMPARE(added_at[6].get<double>(), 1.);
+    sol::table range = lua["range"];
+    QCOMPARE(range.size(), std::size_t{5});
+    QVERIFY_EXCEPTION_THROWN(lua.script("NumArray.new({1, 2}):add(NumArray.new({1, 2, 3}))"), sol::error);
+    QVERIFY_EXCEPTION_THROWN(lua.script("NumArray.new({1, 'x'})"), sol::error);
+}
+
+void TestScriptEngine::test_table_stats() {
+    sol::state lua;
+    bind_numarray(lua);
+    const sol::table values = lua.script("return {-20, -40, 2, 30}");
+    for (const sol::object &input : {sol::object{values}, lua.script("return NumArray.new({-20, -40, 2, 30})").get<sol::object>()}) {
+        sol::table stats = table_stats(lua, input);
+        QCOMPARE(stats["count"].get<int>(), 4);
+        QCOMPARE(stats["sum"].get<double>(), -28.);
+        QCOMPARE(stats["mean"].get<double>(), -7.);
+        QCOMPARE(stats["variance"].get<double>(), table_variance(values));
+        QCOMPARE(stats["min"].get<double>(), -40.);
+        QCOMPARE(stats["argmin"].get<int>(), 2);
+        QCOMPARE(stats["max"].get<double>(), 30.);
+        QCOMPARE(stats["argmax"].get<int>(), 4);
+    }
+    sol::table empty_stats = table_stats(lua, sol::object{lua.create_table()});
+    QCOMPARE(empty_stats["count"].get<int>(), 0);
+    QVERIFY(not empty_stats["min"].valid());
+}
+
+void TestScriptEngine::test_spectrum() {
+    QCOMPARE(Spectrum::rebin({1, 2, 3, 4, 5}, 2), (std::vector<double>{3, 7, 5}));
+    QCOMPARE(Spectrum::moving_average({3, 6, 9, 3, 0}, 3), (std::vector<double>{3, 6, 6, 4, 0}));
+
+    //a Savitzky-Golay filter of order 2 reproduces a parabola exactly
+    std::vector<double> parabola;
+    for (int i = 0; i < 20; i++) {
+        parabola.push_back(0.5 * i * i - 3 * i + 7);
+    }
+    const auto smoothed = Spectrum::savitzky_golay(parabola, 7, 2);
+    for (std::size_t i = 0; i < parabola.size(); i++) {
+        QVERIFY(std::abs(smoothed[i] - parabola[i]) < 1e-9);
+    }
+
+    //gaussian peak with sigma 4 at channel 100 on a flat background of 10 counts
+    const double sigma = 4;
+    std::vector<double> spectrum;
+    for (int i = 0; i < 200; i++) {
+        spectrum.push_back(10 + 1000 * std::exp(-(i - 100) * (i - 100) / (2 * sigma * sigma)));
+    }
+    const auto background = Spectrum::snip_background(spectrum, 20);
+    QVERIFY(std::abs(background[100] - 10) < 1);
+    QVERIFY(std::abs(background[20] - 10) < 1e-9);
+
+    std::vector<double> net(spectrum.size());
+    for (std::size_t i = 0; i < spectrum.size(); i++) {
+        net[i] = spectrum[i] - background[i];
+    }
+    const auto peaks = Spectrum::find_peaks(net, 100);
+    QCOMPARE(peaks.size(), std::size_t{1});
+    QCOMPARE(peaks[0].channel, std::size_t{100});
+    QVERIFY(std::abs(peaks[0].centroid - 100) < 1e-6);
+    QVERIFY(std::abs(peaks[0].fwhm - 2.3548 * sigma) < 0.2);
+}
+
+void TestScriptEngine::test_noise_level_search() {
+    //noise rate that falls below the default limit of 5 cps at threshold 245
+    auto noise_cps = [](unsigned int threshold) { return 1e6 * std::exp(-threshold / 20.); };
+    int integrations = 0;
+    auto measure = [&](const std::vector<unsigned int> &thresholds, double integration_time_s, double) {
+        integrations++;
+        std::vector<double> counts;
+        for (auto threshold : thresholds) {
+            counts.push_back(noise_cps(threshold) * integration_time_s);
+        }
+        return counts;
+    };
+    QCOMPARE(measure_noise_level_search(measure, 4, 4095, Noise_level_search_options{}), 245u);
+    QVERIFY(integrations <= 8);
+
+    integrations = 0;
+    QCOMPARE(measure_noise_level_search(measure, 1, 4095, Noise_level_search_options{5, {1}}), 245u);
+    QVERIFY(integrations <= 13);
+
+    QVERIFY_EXCEPTION_THROWN(measure_noise_level_search(measure, 4, 100, Noise_level_search_options{}), std::runtime_error);
+
+    //the longer integration picks up more noise, so the result of the short one is not confirmed and the search continues above it
+    auto integration_dependent_measure = [&](const std::vector<unsigned int> &thresholds, double integration_time_s, double) {
+        integrations++;
+        std::vector<double> counts;
+        for (auto threshold : thresholds) {
+            counts.push_back(noise_cps(threshold) * (integration_time_s > 1 ? 100 : 1) * integration_time_s);
+        }
+        return counts;
+    };
+    integrations = 0;
+    QCOMPARE(measure_noise_level_search(integration_dependent_measure, 4, 4095, Noise_level_search_options{}), 337u);
+    QVERIFY(integrations <= 12);
+}
+
+void TestScriptEngine::test_binary_table_file() {
+    sol::state lua;
+    lua.open_libraries();
+    const sol::table table = lua.script(R"(
+        local t = {1, 2.5, -3, name = "detector", enabled = true, nested = {x = {10, 20}, [7] = false}}
+        t[1.5] = "half"
+        return t
+    )");
+    QTemporaryDir dir;
+    const QString file_name = dir.filePath("table.bin");
+    {
+        QFile file{file_name};
+        QVERIFY(file.open(QIODevice::WriteOnly));
+        Binary_table_file::save(table, file);
+    }
+    QVERIFY(Binary_table_file::is_binary_table_file(file_name));
+    lua["loaded"] = Binary_table_file::load(lua.lua_state(), file_name);
+    QVERIFY(lua.script(R"(
+        return #loaded == 3 and loaded[2] == 2.5 and loaded[3] == -3 and loaded.name == "detector" and loaded.enabled == true and
+               loaded.nested.x[2] == 20 and loaded.nested[7] == false and loaded[1.5] == "half"
+    )").get<bool>());
+
+    QFile file{file_name};
+    QVERIFY(file.open(QIODevice::ReadWrite));
+    QVERIFY(file.resize(file.size() - 3));
+    file.close();
+    QVERIFY_EXCEPTION_THROWN(Binary_table_file::load(lua.lua_state(), file_name), std::runtime_error);
+
+    if (QCoreApplication::instance() != nullptr) { //errors are reported to the console through the event loop
+        //a table that fails to save halfway leaves an existing file untouched
+        const QString saved_file_name = dir.filePath("saved.bin");
+        table_save_to_file(nullptr, saved_file_name.toStdString(), table, true, "binary");
+        QFile saved_file{saved_file_name};
+        QVERIFY(saved_file.open(QIODevice::ReadOnly));
+        const auto saved_content = saved_file.readAll();
+        saved_file.close();
+        const sol::table unsupported_table = lua.script(R"(
+            local t = {}
+            for i = 1, 1000 do
+                t[i] = {i}
+            end
+            t.callback = print
+            return t
+        )");
+        QVERIFY_EXCEPTION_THROWN(table_save_to_file(nullptr, saved_file_name.toStdString(), unsupported_table, true, "binary"), sol::error);
+        QVERIFY(saved_file.open(QIODevice::ReadOnly));
+        QCOMPARE(saved_file.readAll(), saved_content);
+    }
+}
+
+void TestScriptEngine::test_cooperative_tasks_take_turns() {
+    if (QCoreApplication::instance() == nullptr) {
+        QSKIP("The cooperative scheduler needs an event loop");
+    }
+    const std::vector<std::string> expected_order = {"run start", "spawned start", "spawned end", "run end"};
+    QCOMPARE(run_cooperative_script(R"(
+        function run(devices)
+            spawn(function()
+                log("spawned start")
+                sleep_ms(1)
+                log("spawned end")
+            end)
+            log("run start")
+            sleep_ms(200)
+            log("run end")
+        end
+    )"),
+             expected_order);
+
+    //a number the script yields itself is a plain yield, not a request to sleep
+    const std::vector<std::string> expected_resume = {"resumed"};
+    QCOMPARE(run_cooperative_script(R"(
+        function run(devices)
+            coroutine.yield(100000)
+            log("resumed")
+        end
+    )"),
+             expected_resume);
+}
+
+void TestScriptEngine::test_cooperative_scheduler_is_not_reentrant() {
+    if (QCoreApplication::instance() == nullptr) {
+        QSKIP("The cooperative scheduler needs an event loop");
+    }
+    //the other task is due while the run function spins an event loop, it must wait until the run function yields
+    const std::vector<std::string> expected_order = {"spin start", "spin end", "spawned"};
+    QCOMPARE(run_cooperative_script(R"(
+        function run(devices)
+            spawn(function()
+                log("spawned")
+            end)
+            log("spin start")
+            spin_event_loop(50)
+            log("spin end")
+        end
+    )"),
+             expected_order);
+}
+
+void TestScriptEngine::test_cooperative_script_coroutines() {
+    if (QCoreApplication::instance() == nullptr) {
+        QSKIP("The cooperative scheduler needs an event loop");
+    }
+    //inside coroutines of the script sleep_ms blocks and yields go to the script's own resume instead of the scheduler
+    const std::vector<std::string> expected = {"5", "b", "done"};
+    QCOMPARE(run_cooperative_script(R"(
+        function run(devices)
+            local co = coroutine.wrap(function()
+                coroutine.yield(5)
+                sleep_ms(1)
+                coroutine.yield("b")
+                return "done"
+            end)
+            log(tostring(co()))
+            log(tostring(co()))
+            log(tostring(co()))
+        end
+    )"),
+             expected);
+}
+
+void TestScriptEngine::test_thread_pool_serialized_calls() {
+    //calls to the same device run one at a time and in order, calls to different devices run in parallel
+    Thread_pool pool{0};
+    const int devices[2] = {};
+    std::array<std::atomic<int>, 2> running{};
+    std::atomic<int> max_running_per_device{0};
+    std::atomic<int> done{0};
+    std::atomic<bool> second_device_called{false};
+    std::atomic<bool> waited_for_second_device{false};
+    std::array<std::vector<int>, 2> order;
+    const int calls_per_device = 20;
+    for (int call = 0; call < calls_per_device; call++) {
+        for (std::size_t device = 0; device < 2; device++) {
+            pool.push_serialized(&devices[device], [&, call, device] {
+                const int now_running = ++running[device];
+                for (int max = max_running_per_device; now_running > max && not max_running_per_device.compare_exchange_weak(max, now_running);) {
+                }
+                if (device == 0 && call == 0) { //blocks the first device until the second one got a call through
+                    const auto timeout = std::chrono::steady_clock::now() + std::chrono::seconds{10};
+                    while (not second_device_called && std::chrono::steady_clock::now() < timeout) {
+                        std::this_thread::sleep_for(std::chrono::milliseconds{1});
+                    }
+                    waited_for_second_device = second_device_called.load();
+                }
+                if (device == 1) {
+                    second_device_called = true;
+                }
+                order[device].push_back(call);
+                --running[device];
+                ++done;
+            });
+        }
+    }
+    const auto timeout = std::chrono::steady_clock::now() + std::chrono::seconds{20};
+    while (done < 2 * calls_per_device && std::chrono::steady_clock::now() < timeout) {
+        std::this_thread::sleep_for(std::chrono::milliseconds{1});
+    }
+    QCOMPARE(done.load(), 2 * calls_per_device);
+    QCOMPARE(max_running_per_device.load(), 1);
+    QVERIFY(waited_for_second_device);
+    for (const auto &device_order : order) {
+        QCOMPARE(static_cast<int>(device_order.size()), calls_per_device);
+        QVERIFY(std::is_sorted(std::begin(device_order), std::end(device_order)));
+    }
+}
+
+void TestScriptEngine::test_reset_lua_state_does_not_leak() {
+    QTemporaryDir dir;
+    const QString file_name = dir.filePath("leak.lua");
+    {
+        QFile file{file_name};
+        QVERIFY(file.open(QIODevice::WriteOnly));
+        file.write(R"(
+            loads = (loads or 0) + 1
+            function run(devices)
+                leaked_global = true
+                string.leaked = true
+                math.pi = 3
+                table.insert = nil
+                package.loaded.leaked_module = {}
+                getmetatable("").__index = {}
+                setmetatable(_G, {__index = function() return "leaked" end})
+            end
+        )");
+    }
+    Console console{nullptr};
+    ScriptEngine script_engine{nullptr, console, nullptr, {}};
+    std::vector<MatchedDevice> devices;
+    for (int run = 0; run < 2; run++) {
+        script_engine.load_script(file_name.toStdString());
+        QCOMPARE(script_engine.lua->get<int>("loads"), 1);
+        script_engine.run(devices);
+        QVERIFY(script_engine.is_warm());
+        QVERIFY(script_engine.lua->script(R"(
+            return rawget(_G, "leaked_global") == nil and string.leaked == nil and math.pi > 3.14 and table.insert ~= nil and
+                   package.loaded.leaked_module == nil and ("x"):upper() == "X" and getmetatable(_G) == nil and rawget(_G, "loads") == nil
+        )").get<bool>());
+    }
+}
+
+void TestScriptEngine::test_script_metadata_cache() {
+    QTemporaryDir dir;
+    const QString script_path = dir.filePath("cached.lua");
+    const QString module_path = dir.filePath("module.lua");
+    auto write_file = [](const QString &path, const QByteArray &content) {
+        QFile file{path};
+        QVERIFY(file.open(QIODevice::WriteOnly));
+        file.write(content);
+    };
+    write_file(script_path, "require \"module\"");
+    write_file(module_path, "return {}");
+
+    const QString cache_path = dir.filePath("script_metadata_cache.json");
+    Script_metadata_cache cache{cache_path};
+    Script_metadata metadata;
+    metadata.validation_messages << "cached.lua:1:1-2: (W111) setting non-standard global variable";
+    metadata.required_files << module_path;
+    cache.insert(script_path, metadata);
+    auto found = cache.find(script_path);
+    QVERIFY(found);
+    QCOMPARE(found->validation_messages, metadata.validation_messages);
+    QCOMPARE(found->required_files, metadata.required_files);
+
+    //a changed required file invalidates the entry of the script
+    write_file(module_path, "return {changed = true}");
+    QVERIFY(not cache.find(script_path));
+
+    cache.insert(script_path, metadata);
+    QVERIFY(cache.find(script_path));
+    write_file(script_path, "require \"module\" -- changed");
+    QVERIFY(not cache.find(script_path));
+
+    cache.insert(script_path, metadata);
+    cache.remove(script_path);
+    QVERIFY(not cache.find(script_path));
+
+    //entries survive saving and loading the cache file
+    cache.insert(script_path, metadata);
+    cache.save();
+    auto loaded = Script_metadata_cache{cache_path}.find(script_path);
+    QVERIFY(loaded);
+    QCOMPARE(loaded->validation_messages, metadata.validation_messages);
+    QCOMPARE(loaded->required_files, metadata.required_files);
+}
+
+void TestScriptEngine::test_lua_bytecode_cache_eviction() {
+    QTemporaryDir dir;
+    auto write_file = [](const QString &path, const QByteArray &content) {
+        QFile file{path};
+        QVERIFY(file.open(QIODevice::WriteOnly));
+        file.write(content);
+    };
+    const QString cache_directory = dir.filePath("lua_bytecode");
+    QVERIFY(QDir{}.mkpath(cache_directory));
+
+#if QT_VERSION >= QT_VERSION_CHECK(5, 10, 0)
+    //cache files that were not used for too long are deleted on startup, recently used ones are kept
+    const QString stale_path = QDir{cache_directory}.filePath("stale.luac");
+    const QString fresh_path = QDir{cache_directory}.filePath("fresh.luac");
+    write_file(stale_path, "stale");
+    write_file(fresh_path, "fresh");
+    {
+        QFile stale_file{stale_path};
+        QVERIFY(stale_file.open(QIODevice::Append));
+        QVERIFY(stale_file.setFileTime(QDateTime::currentDateTime().addDays(-40), QFileDevice::FileModificationTime));
+    }
+    Lua_bytecode_cache{cache_directory, 1024, 30};
+    QVERIFY(not QFile::exists(stale_path));
+    QVERIFY(QFile::exists(fresh_path));
+#endif
+
+    //the chunks only differ in a constant, so they have the same size
+    const QStringList script_paths{dir.filePath("a.lua"), dir.filePath("b.lua"), dir.filePath("c.lua")};
+    for (int i = 0; i < script_paths.size(); i++) {
+        write_file(script_paths[i], "return " + QByteArray::number(i + 1));
+    }
+    sol::state lua;
+    std::size_t chunk_size;
+    {
+        Lua_bytecode_cache cache{cache_directory};
+        QCOMPARE(cache.load_file(lua, script_paths[0])().get<int>(), 1);
+        chunk_size = cache.memory_size;
+        QVERIFY(chunk_size > 0);
+    }
+
+    //only 2 chunks fit into memory, the least recently used one is dropped and loaded from its file again
+    Lua_bytecode_cache cache{cache_directory, 2 * chunk_size};
+    auto key = [&script_paths](int index) {
+        QFile file{script_paths[index]};
+        file.open(QIODevice::ReadOnly);
+        return Lua_bytecode_cache::get_key(script_paths[index], file.readAll());
+    };
+    QCOMPARE(cache.load_file(lua, script_paths[0])().get<int>(), 1);
+    QCOMPARE(cache.load_file(lua, script_paths[1])().get<int>(), 2);
+    QCOMPARE(cache.load_file(lua, script_paths[0])().get<int>(), 1);
+    QCOMPARE(cache.load_file(lua, script_paths[2])().get<int>(), 3);
+    QCOMPARE(cache.chunks.size(), std::size_t{2});
+    QVERIFY(cache.memory_size <= 2 * chunk_size);
+    QVERIFY(cache.chunk_positions.count(key(0)) == 1);
+    QVERIFY(cache.chunk_positions.count(key(1)) == 0);
+    QVERIFY(cache.chunk_positions.count(key(2)) == 1);
+    QCOMPARE(cache.load_file(lua, script_paths[1])().get<int>(), 2);
+    QVERIFY(cache.chunk_positions.count(key(1)) == 1);
+    QVERIFY(cache.chunk_positions.count(key(0)) == 0);
+}
+
+void TestScriptEngine::test_performance_counters() {
+    using namespace Performance_counters;
+    auto counter = [](const Snapshot &snapshot, Counter counter) { return snapshot.counters[static_cast<std::size_t>(counter)]; };
+    auto histogram = [](const Snapshot &snapshot, Histogram histogram) { return snapshot.histograms[static_cast<std::size_t>(histogram)]; };
+
+    const auto process_before = get_snapshot();
+    const auto run = create_run();
+    const auto other_run = create_run();
+    {
+        const Run_binding binding{run};
+        QVERIFY(current_run() == run);
+        add(Counter::rpc_transactions);
+        add(Counter::bytes_sent, 10);
+        record(Histogram::rpc_transaction_ms, std::chrono::microseconds{3});
+        {
+            //a nested binding counts for its own run only and restores the previous one
+            const Run_binding other_binding{other_run};
+            add(Counter::rpc_transactions);
+        }
+        QVERIFY(current_run() == run);
+    }
+    QVERIFY(not current_run());
+    //without a binding only the process wide values count
+    add(Counter::rpc_transactions);
+
+    const auto run_snapshot = get_snapshot(run);
+    QCOMPARE(counter(run_snapshot, Counter::rpc_transactions), std::uint64_t{1});
+    QCOMPARE(counter(run_snapshot, Counter::bytes_sent), std::uint64_t{10});
+    QCOMPARE(histogram(run_snapshot, Histogram::rpc_transaction_ms).count, std::uint64_t{1});
+    QCOMPARE(histogram(run_snapshot, Histogram::rpc_transaction_ms).total_us, std::uint64_t{3});
+    //3 us is below 2^2 us
+    QCOMPARE(histogram(run_snapshot, Histogram::rpc_transaction_ms).buckets[2], std::uint64_t{1});
+    QCOMPARE(counter(get_snapshot(other_run), Counter::rpc_transactions), std::uint64_t{1});
+    QCOMPARE(counter(get_snapshot(other_run), Counter::bytes_sent), std::uint64_t{0});
+    QCOMPARE(counter(get_snapshot(Run_context{}), Counter::rpc_transactions), std::uint64_t{0});
+
+    const auto process_difference = get_snapshot() - process_before;
+    QCOMPARE(counter(process_difference, Counter::rpc_transactions), std::uint64_t{3});
+    QCOMPARE(counter(process_difference, Counter::bytes_sent), std::uint64_t{10});
+    QCOMPARE(histogram(process_difference, Histogram::rpc_transaction_ms).count, std::uint64_t{1});
+    QCOMPARE(histogram(process_difference, Histogram::rpc_transaction_ms).buckets[2], std::uint64_t{1});
+
+    //percentiles report the upper bound of the bucket they fall into
+    Histogram_data data;
+    QCOMPARE(data.percentile_ms(50), 0.);
+    data.count = 10;
+    data.buckets[1] = 5;
+    data.buckets[10] = 5;
+    QCOMPARE(data.percentile_ms(50), 0.002);
+    QCOMPARE(data.percentile_ms(90), 1.024);
+    QCOMPARE(data.percentile_ms(100), 1.024);
+}
@@ -4,6 +4,8 @@
 #include "autotest.h"
 #include "scriptengine.h"
 #include <QObject>
+#include <string>
+#include <vector>
 
 class TestScriptEngine : public QObject {
     Q_OBJECT
@@ -14,12 +16,27 @@ class TestScriptEngine : public QObject {
     private:
     void initTestCase();
     void cleanupTestCase();
+    //runs the script with the cooperative scheduler and returns what it passed to log(message)
+    std::vector<std::string> run_cooperative_script(const char *script);
     private slots:
     void basicLuaTest();
     void test_file_name_path();
     void test_create_name_path();
     void test_serachpath();
     void test_pattern_check();
+    void test_numarray();
+    void test_table_stats();
+    void test_spectrum();
+    void test_noise_level_search();
+    void test_binary_table_file();
+    void test_cooperative_tasks_take_turns();
+    void test_cooperative_scheduler_is_not_reentrant();
+    void test_cooperative_script_coroutines();
+    void test_thread_pool_serialized_calls();
+    void test_reset_lua_state_does_not_leak();
+    void test_script_metadata_cache();
+    void test_lua_bytecode_cache_eviction();
+    void test_performance_counters();
 };
 
 DECLARE_TEST(TestScriptEngine)
@@ -51,6 +51,20 @@ QString operator"" _qs(const char *text, std::size_t size) {
     return QString::fromStdString(std::string{text, text + size});
 }
 
+namespace {
+    //clears the prototype cache and turns it on or off until the setting goes out of scope, so tests and benchmarks can cover loading the source
+    struct Prototype_cache_setting {
+        explicit Prototype_cache_setting(bool enabled) {
+            Data_engine::clear_prototype_cache();
+            Data_engine::set_prototype_cache_enabled(enabled);
+        }
+        ~Prototype_cache_setting() {
+            Data_engine::clear_prototype_cache();
+            Data_engine::set_prototype_cache_enabled(true);
+        }
+    };
+} // namespace
+
 struct TestDataVersionString {
     QString in;
 
@@ -317,6 +331,338 @@ void Test_Data_engine::check_non_existing_desired_value() {
 #endif
 }
 
+void Test_Data_engine::check_field_lookup_with_many_fields() {
+#if !DISABLE_ALL || 0
+    const int section_count = 20;
+    const int field_count = 200;
+    QString json = "{";
+    for (int section = 0; section < section_count; section++) {
+        json += QString(R"("Section_%1":{"instance_count": 2, "data":[)").arg(section);
+        for (int field = 0; field < field_count; field++) {
+            json += QString(R"({"name": "Field_%1", "value": %1, "tolerance": 0.5, "nice_name": "field %1"})").arg(field);
+            json += field + 1 < field_count ? "," : "";
+        }
+        json += section + 1 < section_count ? "]}," : "]}";
+    }
+    json += "}";
+    std::stringstream input{json.toStdString()};
+
+    QMap<QString, QList<QVariant>> tags;
+    Data_engine de{input, tags};
+
+    for (int section = 0; section < section_count; section++) {
+        for (int field = 0; field < field_count; field++) {
+            de.set_actual_number(QString("section_%1/FIELD_%2").arg(section).arg(field), field);
+        }
+        de.use_instance(QString("SECTION_%1").arg(section), "second", 2);
+        for (int field = 0; field < field_count; field++) {
+            de.set_actual_number(QString("Section_%1/field_%2").arg(section).arg(field), field + 1);
+        }
+    }
+    QVERIFY(de.is_complete());
+    QVERIFY(!de.all_values_in_range());
+    QVERIFY(!de.value_in_range_in_instance("section_7/field_42"));
+    de.use_instance("section_7", "first", 1);
+    QVERIFY(de.value_in_range_in_instance("section_7/field_42"));
+
+    QVERIFY_EXCEPTION_THROWN_error_number(de.set_actual_number("section_7/field_200", 1), DataEngineErrorNumber::no_field_id_found);
+    QVERIFY_EXCEPTION_THROWN_error_number(de.set_actual_number("section_20/field_1", 1), DataEngineErrorNumber::no_section_id_found);
+    QVERIFY_EXCEPTION_THROWN_error_number(de.set_actual_number("section_7/field_1/x", 1), DataEngineErrorNumber::faulty_field_id);
+#endif
+}
+
+void Test_Data_engine::test_field_handle() {
+#if !DISABLE_ALL || 0
+    std::stringstream input{R"(
+{
+    "supply":{
+        "instance_count": "probe_count",
+        "data":[
+            {	"name": "voltage",	 	"value": 5000,	"tolerance": 200,	"unit": "mV", "si_prefix": 1e-3,	"nice_name": "Supply voltage"	},
+            {	"name": "ok",	 	"value": true,	"nice_name": "Supply ok"	}
+        ]
+    }
+}
+                            )"};
+
+    QMap<QString, QList<QVariant>> tags;
+    Data_engine de{input, tags};
+
+    auto voltage = de.get_field("Supply/Voltage");
+    auto ok = de.get_field("supply/ok");
+    QVERIFY_EXCEPTION_THROWN_error_number(voltage.set_actual_number(5.0), DataEngineErrorNumber::instance_count_yet_undefined);
+
+    de.set_instance_count("probe_count", 2);
+    voltage.set_actual_number(5.0);
+    ok.set_actual_bool(true);
+    QVERIFY(voltage.get_entry_type().t == EntryType::Number);
+    QCOMPARE(voltage.get_actual_number(), 5.0);
+    QCOMPARE(de.get_actual_number("supply/voltage"), 5.0);
+    QVERIFY(!de.is_complete());
+
+    de.use_instance("supply", "second", 2);
+    QVERIFY(!de.value_complete_in_instance("supply/voltage"));
+    voltage.set_actual_number(4.0);
+    ok.set_actual_bool(false);
+    QCOMPARE(de.get_actual_number("supply/voltage"), 4.0);
+    QVERIFY(de.is_complete());
+    QVERIFY(!de.value_in_range_in_instance("supply/voltage"));
+
+    de.use_instance("supply", "first", 1);
+    QCOMPARE(voltage.get_actual_number(), 5.0);
+    QCOMPARE(ok.get_actual_value(), de.get_actual_value("supply/ok"));
+
+    QVERIFY_EXCEPTION_THROWN_error_number(voltage.set_actual_bool(true), DataEngineErrorNumber::setting_desired_value_with_wrong_type);
+    QVERIFY_EXCEPTION_THROWN_error_number(de.get_field("supply"), DataEngineErrorNumber::faulty_field_id);
+    QVERIFY_EXCEPTION_THROWN_error_number(de.get_field("power/voltage"), DataEngineErrorNumber::no_section_id_found);
+    auto missing = de.get_field("supply/current");
+    QVERIFY_EXCEPTION_THROWN_error_number(missing.set_actual_number(1), DataEngineErrorNumber::no_field_id_found);
+#endif
+}
+
+void Test_Data_engine::test_completeness_follows_set_values() {
+#if !DISABLE_ALL || 0
+    std::stringstream input{R"(
+{
+    "supply":{
+        "instance_count": 2,
+        "data":[
+            {	"name": "voltage",	 	"value": 5000,	"tolerance": 200,	"unit": "mV", "si_prefix": 1e-3,	"nice_name": "Supply voltage"	},
+            {	"name": "ok",	 	"value": true,	"nice_name": "Supply ok"	}
+        ]
+    },
+    "source":{
+        "data":[
+            {	"name": "level",	 	"value": 3,	"tolerance": 1,	"nice_name": "Source level"	}
+        ]
+    },
+    "check":{
+        "data":[
+            {	"name": "level_copy",	 	"value": "[source/level.actual]",	"tolerance": 0.1,	"nice_name": "Source level again"	}
+        ]
+    }
+}
+                            )"};
+
+    QMap<QString, QList<QVariant>> tags;
+    Data_engine de{input, tags};
+
+    QVERIFY(!de.is_complete());
+    QVERIFY(!de.all_values_in_range());
+    for (uint instance = 1; instance <= 2; instance++) {
+        de.use_instance("supply", "", instance);
+        de.set_actual_number("supply/voltage", 5.0);
+        de.set_actual_bool("supply/ok", true);
+    }
+    QVERIFY(!de.is_complete());
+    QVERIFY(de.value_complete_in_section("supply"));
+    QVERIFY(de.value_in_range_in_section("supply"));
+
+    de.set_actual_number("source/level", 3.0);
+    de.set_actual_number("check/level_copy", 3.05);
+    QVERIFY(de.is_complete());
+    QVERIFY(de.all_values_in_range());
+
+    //setting the same field again has to be counted only once
+    de.set_actual_number("supply/voltage", 6.0);
+    de.set_actual_number("supply/voltage", 7.0);
+    QVERIFY(de.is_complete());
+    QVERIFY(!de.all_values_in_range());
+    QVERIFY(!de.value_in_range_in_section("supply"));
+
+    de.set_actual_number("supply/voltage", 5.0);
+    QVERIFY(de.value_in_range_in_section("supply"));
+    QVERIFY(de.all_values_in_range());
+
+    de.set_actual_bool("supply/ok", false);
+    QVERIFY(!de.all_values_in_range());
+    de.set_actual_bool("supply/ok", true);
+    QVERIFY(de.all_values_in_range());
+
+    //the reference is checked against the actual value of its target, which changes without setting the reference
+    de.set_actual_number("source/level", 3.5);
+    QVERIFY(de.value_in_range_in_section("source"));
+    QVERIFY(!de.value_in_range_in_section("check"));
+    QVERIFY(!de.all_values_in_range());
+#endif
+}
+
+void Test_Data_engine::test_engines_loaded_from_same_source() {
+#if !DISABLE_ALL || 0
+    const std::string json = R"(
+{
+    "source":[
+        {
+            "apply_if":{
+                "model":"small"
+            },
+            "data":[
+                {	"name": "level",	 	"value": 3,	"tolerance": 1,	"nice_name": "Source level"	}
+            ]
+        },
+        {
+            "apply_if":{
+                "model":"big"
+            },
+            "data":[
+                {	"name": "level",	 	"value": 30,	"tolerance": 1,	"nice_name": "Source level"	}
+            ]
+        }
+    ],
+    "check":{
+        "data":[
+            {	"name": "level_copy",	 	"value": "[source/level.actual]",	"tolerance": 0.1,	"nice_name": "Source level again"	}
+        ]
+    }
+}
+                            )";
+
+    //the second and third engine are copied from the prototype cache if it is enabled
+    for (const bool use_prototype_cache : {false, true}) {
+        Prototype_cache_setting prototype_cache_setting{use_prototype_cache};
+        QMap<QString, QList<QVariant>> tags;
+        tags.insert("model", {"small"});
+        std::stringstream first_input{json};
+        Data_engine first{first_input, tags};
+        std::stringstream second_input{json};
+        Data_engine second{second_input, tags};
+        tags["model"] = {"big"};
+        std::stringstream third_input{json};
+        Data_engine third{third_input, tags};
+
+        first.set_actual_number("source/level", 3.0);
+        first.set_actual_number("check/level_copy", 3.0);
+        QVERIFY(first.is_complete());
+        QVERIFY(first.all_values_in_range());
+        QVERIFY(!second.is_complete());
+
+        //the reference of the second engine has to point to the second engine's source
+        second.set_actual_number("source/level", 2.5);
+        second.set_actual_number("check/level_copy", 3.0);
+        QVERIFY(second.value_in_range_in_section("source"));
+        QVERIFY(!second.value_in_range_in_section("check"));
+        QVERIFY(first.all_values_in_range());
+
+        third.set_actual_number("source/level", 3.0);
+        QVERIFY(!third.value_in_range_in_section("source"));
+        QCOMPARE(third.get_desired_number("source/level"), 30.0);
+        QCOMPARE(second.get_desired_number("source/level"), 3.0);
+    }
+#endif
+}
+
+void Test_Data_engine::benchmark_set_and_get_10k_fields() {
+#if !DISABLE_ALL || 0
+    const int section_count = 10;
+    const int field_count = 1000;
+    QString json = "{";
+    for (int section = 0; section < section_count; section++) {
+        json += QString(R"("section_%1":{"data":[)").arg(section);
+        for (int field = 0; field < field_count; field++) {
+            switch (field % 3) {
+                case 0:
+                    json += QString(R"({"name": "field_%1", "value": 5, "tolerance": 1, "nice_name": "number"})").arg(field);
+                    break;
+                case 1:
+                    json += QString(R"({"name": "field_%1", "value": true, "nice_name": "bool"})").arg(field);
+                    break;
+                default:
+                    json += QString(R"({"name": "field_%1", "value": "[section_%2/field_%3.desired]", "tolerance": 1, "nice_name": "reference"})")
+                                .arg(field)
+                                .arg(section)
+                                .arg(field - 2);
+            }
+            json += field + 1 < field_count ? "," : "";
+        }
+        json += section + 1 < section_count ? "]}," : "]}";
+    }
+    json += "}";
+    std::stringstream input{json.toStdString()};
+
+    QMap<QString, QList<QVariant>> tags;
+    Data_engine de{input, tags};
+
+    QStringList ids;
+    for (int section = 0; section < section_count; section++) {
+        for (int field = 0; field < field_count; field++) {
+            ids.append(QString("section_%1/field_%2").arg(section).arg(field));
+        }
+    }
+    double sum = 0;
+    QBENCHMARK {
+        sum = 0;
+        for (int i = 0; i < ids.count(); i++) {
+            if (i % 3 == 1) {
+                de.set_actual_bool(ids[i], true);
+            } else {
+                de.set_actual_number(ids[i], 5);
+                sum += de.get_actual_number(ids[i]);
+            }
+        }
+    }
+    QCOMPARE(sum, 5.0 * (ids.count() - ids.count() / 3));
+    QVERIFY(de.is_complete());
+    QVERIFY(de.all_values_in_range());
+#endif
+}
+
+void Test_Data_engine::benchmark_select_variant_of_10k() {
+#if !DISABLE_ALL || 0
+    const int variant_count = 10000;
+    QString json = R"({"calibration":[)";
+    for (int variant = 0; variant < variant_count; variant++) {
+        json += QString(R"({"apply_if":{"serial_number":"[%1-%2]", "model":["model_%3", "model_any"], "revision":"[*]"},)"
+                        R"("data":[{"name": "offset", "value": %1, "tolerance": 1, "nice_name": "offset"}]})")
+                    .arg(variant * 10)
+                    .arg(variant * 10 + 10)
+                    .arg(variant % 100);
+        json += variant + 1 < variant_count ? "," : "";
+    }
+    json += "]}";
+    const std::string json_string = json.toStdString();
+
+    QMap<QString, QList<QVariant>> tags;
+    tags.insert("serial_number", {43215.5});
+    tags.insert("model", {"model_21"});
+    tags.insert("revision", {3});
+    Prototype_cache_setting prototype_cache_setting{false};
+    QBENCHMARK {
+        std::stringstream input{json_string};
+        Data_engine de{input, tags};
+        QCOMPARE(de.get_desired_number("calibration/offset"), 43210.0);
+    }
+#endif
+}
+
+void Test_Data_engine::benchmark_create_1000_instances() {
+#if !DISABLE_ALL || 0
+    const int variant_count = 20;
+    const int field_count = 50;
+    QString json = R"({"probe":{"instance_count": "probe_count", "variants":[)";
+    for (int variant = 0; variant < variant_count; variant++) {
+        json += QString(R"({"apply_if":{"model":"model_%1"}, "data":[)").arg(variant);
+        for (int field = 0; field < field_count; field++) {
+            json += QString(R"({"name": "field_%1", "value": %2, "tolerance": 1, "nice_name": "number"})").arg(field).arg(variant);
+            json += field + 1 < field_count ? "," : "";
+        }
+        json += variant + 1 < variant_count ? "]}," : "]}";
+    }
+    json += "]}}";
+    const std::string json_string = json.toStdString();
+
+    QMap<QString, QList<QVariant>> tags;
+    tags.insert("model", {"model_7"});
+    Prototype_cache_setting prototype_cache_setting{false};
+    QBENCHMARK {
+        std::stringstream input{json_string};
+        Data_engine de{input, tags};
+        de.set_instance_count("probe_count", 1000);
+        de.use_instance("probe", "", 1000);
+        QCOMPARE(de.get_desired_number("probe/field_49"), 7.0);
+    }
+#endif
+}
+
 struct TestDependencyData {
     QList<QPair<QString, QVariant>> values;
 
@@ -2283,6 +2629,32 @@ void Test_Data_engine::test_references() {
 #endif
 }
 
+void Test_Data_engine::test_references_cycle() {
+#if !DISABLE_ALL || 0
+    std::stringstream input{R"(
+{
+    "section_a":{
+        "data":[
+            {	"name": "value_a",       "value": "[section_b/value_b.actual]",        "tolerance": "5",		"nice_name": "points to b"       }
+        ]
+    },
+    "section_b":{
+        "data":[
+            {	"name": "value_b",       "value": "[section_c/value_c.actual]",        "tolerance": "5",		"nice_name": "points to c"       }
+        ]
+    },
+    "section_c":{
+        "data":[
+            {	"name": "value_c",       "value": "[Section_A/Value_A.desired]",        "tolerance": "5",		"nice_name": "points back to a"       }
+        ]
+    }
+}
+                            )"};
+    QMap<QString, QList<QVariant>> tags;
+    QVERIFY_EXCEPTION_THROWN_error_number(Data_engine(input, tags), DataEngineErrorNumber::reference_cycle);
+#endif
+}
+
 void Test_Data_engine::test_references_ambiguous() {
 #if !DISABLE_ALL || 0
 
@@ -28,6 +28,13 @@ class Test_Data_engine : public QObject {
     void check_non_existing_desired_value();
     void check_non_faulty_field_id();
     void check_non_existing_section_name();
+    void check_field_lookup_with_many_fields();
+    void test_field_handle();
+    void test_completeness_follows_set_values();
+    void test_engines_loaded_from_same_source();
+    void benchmark_set_and_get_10k_fields();
+    void benchmark_select_variant_of_10k();
+    void benchmark_create_1000_instances();
     void check_version_string_parsing();
     void check_dependency_handling();
     void check_dependency_ambiguity_handling();
@@ -35,6 +42,7 @@ class Test_Data_engine : public QObject {
     void test_references();
     void test_references_ambiguous();
     void test_references_non_existing();
+    void test_references_cycle();
     void test_references_from_non_actual_only_field();
     void test_references_string_bool();
     void test_references_set_value_in_wrong_type();